@@ -0,0 +1,84 @@
+/*
+ * BlockDevice.h
+ *
+ *  Created on: 17 Oct 2026
+ *
+ *  Abstract block device used by LittleFS. SDCard, SDRaid and
+ *  RAMBlockDevice implement it on the target, host/FileBlockDevice on
+ *  Linux. Addresses and sizes are in bytes, multiples of the read,
+ *  program or erase size of the device.
+ */
+
+#ifndef BLOCKDEVICE_H_
+#define BLOCKDEVICE_H_
+
+#include <stdint.h>
+
+#define BD_ERROR_OK              0           /*!< no error */
+#define BD_ERROR_DEVICE_ERROR    -4001       /*!< device specific error */
+#define BD_ERROR_PARAMETER       -4002       /*!< invalid address or size */
+
+class BlockDevice
+{
+public:
+    virtual ~BlockDevice() {}
+
+    virtual int init() = 0;
+    virtual int deinit() = 0;
+
+    virtual int read(void *buffer, uint64_t addr, uint64_t size) = 0;
+    virtual int program(const void *buffer, uint64_t addr, uint64_t size) = 0;
+
+    // Prepare blocks for programming
+    virtual int erase(uint64_t addr, uint64_t size) = 0;
+
+    // Hint that the content of the blocks is no longer needed
+    virtual int trim(uint64_t addr, uint64_t size)
+    {
+        return BD_ERROR_OK;
+    }
+
+    // Write back whatever the device still buffers
+    virtual int sync()
+    {
+        return BD_ERROR_OK;
+    }
+
+    // True while the device completes a program in the background
+    virtual bool is_busy()
+    {
+        return false;
+    }
+
+    virtual uint64_t get_read_size() const = 0;
+    virtual uint64_t get_program_size() const = 0;
+    virtual uint64_t get_erase_size() const = 0;
+    virtual uint64_t size() const = 0;
+    virtual const char *get_type() const = 0;
+
+    bool is_valid_read(uint64_t addr, uint64_t size) const
+    {
+        return (
+                   addr % get_read_size() == 0 &&
+                   size % get_read_size() == 0 &&
+                   addr + size <= this->size());
+    }
+
+    bool is_valid_program(uint64_t addr, uint64_t size) const
+    {
+        return (
+                   addr % get_program_size() == 0 &&
+                   size % get_program_size() == 0 &&
+                   addr + size <= this->size());
+    }
+
+    bool is_valid_erase(uint64_t addr, uint64_t size) const
+    {
+        return (
+                   addr % get_erase_size() == 0 &&
+                   size % get_erase_size() == 0 &&
+                   addr + size <= this->size());
+    }
+};
+
+#endif /* BLOCKDEVICE_H_ */
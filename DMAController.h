@@ -0,0 +1,45 @@
+/*
+ * DMAController.h
+ *
+ *  Created on: 17 Oct 2026
+ *
+ *  Minimal interface to the DMA engine used by DSPI_A. It only covers what
+ *  a SPI transfer needs (route a peripheral trigger, run a basic byte
+ *  transfer, poll for completion), so that the sequencing can be replaced
+ *  by a fake controller when running off-target.
+ */
+
+#ifndef DMACONTROLLER_H_
+#define DMACONTROLLER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Transfer flags */
+#define DMA_SRC_INCREMENT       (1 << 0)    /*!< Source address increments after every byte */
+#define DMA_DST_INCREMENT       (1 << 1)    /*!< Destination address increments after every byte */
+
+class DMAController
+{
+public:
+    virtual ~DMAController() {}
+
+    // Route a peripheral trigger (e.g. DMA_CH2_EUSCIA1TX) to its channel,
+    // returns the channel number to be used in the other calls
+    virtual uint32_t assign(uint32_t mapping) = 0;
+
+    // Program and enable a basic byte transfer on a channel
+    virtual void start(uint32_t channel, const volatile void *src,
+                       volatile void *dst, size_t length, uint8_t flags) = 0;
+
+    // Abort a transfer
+    virtual void stop(uint32_t channel) = 0;
+
+    // True when the channel has moved all the bytes it was programmed for
+    virtual bool isDone(uint32_t channel) = 0;
+
+    // Largest number of bytes a single transfer can move
+    virtual size_t maxLength() const = 0;
+};
+
+#endif /* DMACONTROLLER_H_ */
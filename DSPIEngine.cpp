@@ -0,0 +1,293 @@
+/*
+ * DSPIEngine.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "DSPIEngine.h"
+
+DSPIEngine::DSPIEngine(const DSPI_Registers &registers, DSPIPlatform *platform)
+{
+    this->regs = registers;
+    this->platform = platform;
+    this->dma = 0;
+    this->dmaTxChannel = 0;
+    this->dmaRxChannel = 0;
+    this->dmaBusy = false;
+    this->dmaCallback = 0;
+    this->dmaFill = 0xFF;
+    this->dmaSink = 0;
+    this->queueHead = 0;
+    this->queueTail = 0;
+    this->queueRunning = false;
+    this->txCount = 0;
+    this->rxCount = 0;
+    this->overruns = 0;
+}
+
+/**** Block transfer: keep TXBUF loaded with the next byte while the
+ * current one is shifted out, so the bus never idles between bytes.
+ * Either buffer can be omitted: tx = 0 sends the fill byte, rx = 0
+ * drops the received data. When the loop is stalled (e.g. by an ISR) for
+ * more than a byte time, the second byte overwrites RXBUF: UCOE is set and
+ * only one RXIFG is left for the two bytes, so the lost byte is counted
+ * as received instead of waiting for an RXIFG that never comes.
+ * Returns false when bytes were lost. ****/
+bool DSPIEngine::transfer(const uint8_t *tx, uint8_t *rx, size_t length, uint8_t fill)
+{
+    size_t received = 0;
+    bool overrun = false;
+
+    if (length == 0)
+    {
+        return true;
+    }
+
+    // prime the transmitter with the first byte
+    while (!(*this->regs.IFG & DSPI_IFG_TXIFG));
+    *this->regs.TXBUF = tx ? tx[0] : fill;
+
+    for (size_t i = 1; i < length; i++)
+    {
+        // queue the next byte as soon as the previous one moved to the shift register
+        while (!(*this->regs.IFG & DSPI_IFG_TXIFG));
+        *this->regs.TXBUF = tx ? tx[i] : fill;
+
+        // collect the byte that has just been shifted in, unless an overrun
+        // already accounted for it
+        if (received < i)
+        {
+            while (!(*this->regs.IFG & DSPI_IFG_RXIFG));
+            overrun |= _receive(rx, &received);
+        }
+    }
+
+    // collect the last byte
+    while (received < length)
+    {
+        while (!(*this->regs.IFG & DSPI_IFG_RXIFG));
+        overrun |= _receive(rx, &received);
+    }
+    return !overrun;
+}
+
+/**** Read RXBUF into rx[*count]: on an overrun the byte before it was lost
+ * and is skipped, at most one byte can be lost with two bytes in flight ****/
+bool DSPIEngine::_receive(uint8_t *rx, size_t *count)
+{
+    bool overrun = (*this->regs.STATW & DSPI_STATW_OE) != 0;
+    uint8_t data = *this->regs.RXBUF;
+
+    if (overrun)
+    {
+        this->overruns++;
+        (*count)++;
+    }
+    if (rx)
+    {
+        rx[*count] = data;
+    }
+    (*count)++;
+    return overrun;
+}
+
+/**** Enable DMA mode on the given TX / RX channels ****/
+void DSPIEngine::setDMA(DMAController *controller, uint32_t txChannel, uint32_t rxChannel)
+{
+    this->dma = controller;
+    this->dmaTxChannel = txChannel;
+    this->dmaRxChannel = rxChannel;
+}
+
+bool DSPIEngine::hasDMA( void ) const
+{
+    return this->dma != 0;
+}
+
+/**** Start a background transfer: returns false when DMA is not available,
+ * another transfer is still running or the length exceeds the controller limit ****/
+bool DSPIEngine::startTransfer(const uint8_t *tx, uint8_t *rx, size_t length,
+                               uint8_t fill, void (*callback)( void ))
+{
+
+    if (!this->dma || this->dmaBusy || (length == 0) || (length > this->dma->maxLength()))
+    {
+        return false;
+    }
+
+    this->dmaFill = fill;
+    this->dmaCallback = callback;
+    this->dmaBusy = true;
+
+    // the RX channel always runs, also for TX-only transfers, so that RXIFG
+    // is consumed and the next polled transfer does not read a stale byte
+    this->dma->start(this->dmaRxChannel, this->regs.RXBUF,
+                     rx ? (volatile void *)rx : (volatile void *)&this->dmaSink, length,
+                     rx ? DMA_DST_INCREMENT : 0);
+
+    // TXIFG is already set: enabling the TX channel starts the transfer
+    this->dma->start(this->dmaTxChannel,
+                     tx ? (const volatile void *)tx : (const volatile void *)&this->dmaFill,
+                     this->regs.TXBUF, length, tx ? DMA_SRC_INCREMENT : 0);
+    return true;
+}
+
+/**** Poll for completion of the background transfer ****/
+bool DSPIEngine::transferDone( void )
+{
+    if (this->dmaBusy && this->dma->isDone(this->dmaRxChannel))
+    {
+        handleDMAInterrupt();
+    }
+    return !this->dmaBusy;
+}
+
+/**** Abort the background transfer: both channels are stopped, the bytes
+ * already handed to the module are let out (UCBUSY, at most two byte
+ * times) and RXBUF is drained, so the DMA no longer writes to the caller's
+ * buffer and the next polled transfer does not see a stale RXIFG. The
+ * callback is not called ****/
+void DSPIEngine::abortTransfer( void )
+{
+    if (!this->dma)
+    {
+        return;
+    }
+
+    this->dma->stop(this->dmaTxChannel);
+    this->dma->stop(this->dmaRxChannel);
+    while (*this->regs.STATW & DSPI_STATW_BUSY);
+    (void)*this->regs.RXBUF;                // clears RXIFG and UCOE
+
+    bool masked = this->platform->enterCritical();
+    this->dmaBusy = false;
+    this->platform->exitCritical(masked);
+}
+
+/**** To be called from the DMA completion interrupt of the RX channel.
+ * transferDone() also gets here: the test-and-clear of dmaBusy runs with
+ * interrupts masked, so that the callback runs only once ****/
+void DSPIEngine::handleDMAInterrupt( void )
+{
+    bool masked = this->platform->enterCritical();
+    bool busy = this->dmaBusy;
+    void (*callback)( void ) = this->dmaCallback;
+
+    this->dmaBusy = false;
+    this->platform->exitCritical(masked);
+
+    if (busy && callback)
+    {
+        callback();
+    }
+}
+
+/**** Add a transaction to the interrupt queue, returns false when the queue is full ****/
+bool DSPIEngine::enqueue(const DSPI_Transaction &transaction)
+{
+    uint8_t next = (this->queueHead + 1) % DSPI_QUEUE_SIZE;
+
+    if ((transaction.length == 0) || (next == this->queueTail))
+    {
+        return false;
+    }
+
+    this->queue[this->queueHead] = transaction;
+
+    // the ISR can complete the last transaction in the meantime: keep it out
+    this->platform->disableInterrupt();
+    this->queueHead = next;
+    if (!this->queueRunning)
+    {
+        this->queueRunning = true;
+        _startTransaction();
+    }
+    this->platform->enableInterrupt();
+    return true;
+}
+
+bool DSPIEngine::queueIdle( void ) const
+{
+    return !this->queueRunning;
+}
+
+/**** eUSCI interrupt handler: at most two bytes are in flight (TXBUF and
+ * shift register), TX is re-armed every time a byte is received. A late
+ * ISR can lose one of them to an RXBUF overrun, it is counted as received ****/
+void DSPIEngine::handleInterrupt( void )
+{
+    DSPI_Transaction *t = &this->queue[this->queueTail];
+
+    if (!this->queueRunning)
+    {
+        *this->regs.IE &= ~(DSPI_IE_TXIE | DSPI_IE_RXIE);
+        return;
+    }
+
+    if (*this->regs.IFG & DSPI_IFG_RXIFG)
+    {
+        if (*this->regs.STATW & DSPI_STATW_OE)
+        {
+            this->overruns++;
+            this->rxCount++;
+        }
+        uint8_t data = *this->regs.RXBUF;
+        if (t->rx)
+        {
+            t->rx[this->rxCount] = data;
+        }
+        this->rxCount++;
+
+        if (this->rxCount == t->length)
+        {
+            // transaction completed
+            if (t->csPort && !(t->flags & DSPI_TRANSACTION_KEEP_CS))
+            {
+                this->platform->deselect(t->csPort, t->csPin);
+            }
+            if (t->callback)
+            {
+                t->callback();
+            }
+            this->queueTail = (this->queueTail + 1) % DSPI_QUEUE_SIZE;
+            if (this->queueTail == this->queueHead)
+            {
+                *this->regs.IE &= ~(DSPI_IE_TXIE | DSPI_IE_RXIE);
+                this->queueRunning = false;
+                return;
+            }
+            _startTransaction();
+            return;
+        }
+        if (this->txCount < t->length)
+        {
+            *this->regs.IE |= DSPI_IE_TXIE;
+        }
+    }
+
+    if ((*this->regs.IE & DSPI_IE_TXIE) && (*this->regs.IFG & DSPI_IFG_TXIFG))
+    {
+        *this->regs.TXBUF = t->tx ? t->tx[this->txCount] : t->fill;
+        this->txCount++;
+        if ((this->txCount == t->length) || (this->txCount - this->rxCount >= 2))
+        {
+            *this->regs.IE &= ~DSPI_IE_TXIE;
+        }
+    }
+}
+
+/**** PRIVATE ****/
+/**** Assert chip-select for the transaction at the queue tail and arm the
+ * interrupts: TXIFG is already set, so the ISR fires straight away ****/
+void DSPIEngine::_startTransaction( void )
+{
+    DSPI_Transaction *t = &this->queue[this->queueTail];
+
+    this->txCount = 0;
+    this->rxCount = 0;
+    if (t->csPort)
+    {
+        this->platform->select(t->csPort, t->csPin);
+    }
+    *this->regs.IE |= DSPI_IE_TXIE | DSPI_IE_RXIE;
+}
@@ -0,0 +1,128 @@
+/*
+ * DSPIEngine.h
+ *
+ *  Created on: 17 Oct 2026
+ *
+ *  Hardware independent part of DSPI_A: the polled block transfer, the
+ *  uDMA transfer sequencing and the interrupt driven transaction queue.
+ *  It only touches the eUSCI SPI registers it is given and goes through
+ *  DSPIPlatform for the chip-select pins and the interrupt masking, so it
+ *  runs unchanged against a simulated register block on the host.
+ */
+
+#ifndef DSPIENGINE_H_
+#define DSPIENGINE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "DMAController.h"
+
+/* Register bits, same position in eUSCI_A and eUSCI_B */
+#define DSPI_IFG_RXIFG              (0x0001)    /*!< UCRXIFG */
+#define DSPI_IFG_TXIFG              (0x0002)    /*!< UCTXIFG */
+#define DSPI_IE_RXIE                (0x0001)    /*!< UCRXIE */
+#define DSPI_IE_TXIE                (0x0002)    /*!< UCTXIE */
+#define DSPI_STATW_BUSY             (0x0001)    /*!< UCBUSY */
+#define DSPI_STATW_OE               (0x0020)    /*!< UCOE, cleared by reading RXBUF */
+
+#define DSPI_QUEUE_SIZE             8           /*!< Transactions in the interrupt queue */
+
+/* Transaction flags */
+#define DSPI_TRANSACTION_KEEP_CS    (1 << 0)    /*!< Leave chip-select asserted at the end */
+
+/* Transaction executed by the interrupt engine: chip-select is asserted
+ * before the first byte (csPort = 0 disables chip-select handling),
+ * tx = 0 sends the fill byte and rx = 0 discards the received data */
+typedef struct
+{
+    uint32_t csPort;
+    uint32_t csPin;
+    const uint8_t *tx;
+    uint8_t *rx;
+    size_t length;
+    uint8_t fill;
+    uint8_t flags;
+    void (*callback)( void );   /*!< Called from the ISR when the transaction is completed */
+} DSPI_Transaction;
+
+/* eUSCI SPI registers used by the engine: eUSCI_A and eUSCI_B only
+ * differ in their offsets */
+typedef struct
+{
+    volatile uint16_t *IE;
+    volatile uint16_t *IFG;
+    volatile uint16_t *STATW;
+    volatile uint16_t *RXBUF;
+    volatile uint16_t *TXBUF;
+} DSPI_Registers;
+
+/* Operations outside the eUSCI registers */
+class DSPIPlatform
+{
+public:
+    virtual ~DSPIPlatform() {}
+
+    // Chip-select, active low
+    virtual void select( uint32_t port, uint32_t pin ) = 0;
+    virtual void deselect( uint32_t port, uint32_t pin ) = 0;
+
+    // Mask / unmask the eUSCI module interrupt
+    virtual void disableInterrupt( void ) = 0;
+    virtual void enableInterrupt( void ) = 0;
+
+    // Mask all interrupts, returns true when they were already masked;
+    // exitCritical() gets that value back
+    virtual bool enterCritical( void ) = 0;
+    virtual void exitCritical( bool masked ) = 0;
+};
+
+class DSPIEngine
+{
+private:
+    DSPI_Registers regs;
+    DSPIPlatform *platform;
+
+    /* DMA mode */
+    DMAController *dma;
+    uint32_t dmaTxChannel;
+    uint32_t dmaRxChannel;
+    volatile bool dmaBusy;
+    void (*dmaCallback)( void );
+    uint8_t dmaFill;
+    uint8_t dmaSink;
+
+    /* Interrupt mode */
+    DSPI_Transaction queue[DSPI_QUEUE_SIZE];
+    volatile uint8_t queueHead;
+    volatile uint8_t queueTail;
+    volatile bool queueRunning;
+    size_t txCount;
+    size_t rxCount;
+
+    bool _receive( uint8_t *rx, size_t *count );
+    void _startTransaction( void );
+
+public:
+    DSPIEngine( const DSPI_Registers &registers, DSPIPlatform *platform );
+
+    uint32_t overruns;      /*!< Received bytes lost to an RXBUF overrun */
+
+    /* Polled block transfer, returns false when received bytes were lost */
+    bool transfer( const uint8_t *tx, uint8_t *rx, size_t length, uint8_t fill );
+
+    /* DMA mode, channels already assigned to the module triggers */
+    void setDMA( DMAController *controller, uint32_t txChannel, uint32_t rxChannel );
+    bool hasDMA( void ) const;
+    bool startTransfer( const uint8_t *tx, uint8_t *rx, size_t length,
+                        uint8_t fill, void (*callback)( void ) );
+    bool transferDone( void );
+    void abortTransfer( void );
+    void handleDMAInterrupt( void );
+
+    /* Interrupt mode */
+    bool enqueue( const DSPI_Transaction &transaction );
+    bool queueIdle( void ) const;
+    void handleInterrupt( void );
+};
+
+#endif /* DSPIENGINE_H_ */
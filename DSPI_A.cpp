@@ -15,10 +15,51 @@
  
  #include "DSPI_A.h"
 
-/**** CONSTRUCTORS Default ****/
-DSPI_A::DSPI_A()
-{   //MSP432 launchpad used EUSCI_A0_SPI as default
-    this->module = EUSCI_A1_SPI_BASE;
+/**** Module descriptors, pins from the device specific header ****/
+const DSPI_Module DSPI_EUSCI_A0 = { EUSCI_A0_SPI_BASE, EUSCI_A0_PORT, EUSCI_A0_PINS, INT_EUSCIA0 };
+const DSPI_Module DSPI_EUSCI_A1 = { EUSCI_A1_SPI_BASE, EUSCI_A1_PORT, EUSCI_A1_PINS, INT_EUSCIA1 };
+const DSPI_Module DSPI_EUSCI_A2 = { EUSCI_A2_SPI_BASE, EUSCI_A2_PORT, EUSCI_A2_PINS, INT_EUSCIA2 };
+const DSPI_Module DSPI_EUSCI_A3 = { EUSCI_A3_SPI_BASE, EUSCI_A3_PORT, EUSCI_A3_PINS, INT_EUSCIA3 };
+const DSPI_Module DSPI_EUSCI_B0 = { EUSCI_B0_SPI_BASE, EUSCI_B0_PORT, EUSCI_B0_PINS, INT_EUSCIB0 };
+const DSPI_Module DSPI_EUSCI_B1 = { EUSCI_B1_SPI_BASE, EUSCI_B1_PORT, EUSCI_B1_PINS, INT_EUSCIB1 };
+const DSPI_Module DSPI_EUSCI_B2 = { EUSCI_B2_SPI_BASE, EUSCI_B2_PORT, EUSCI_B2_PINS, INT_EUSCIB2 };
+const DSPI_Module DSPI_EUSCI_B3 = { EUSCI_B3_SPI_BASE, EUSCI_B3_PORT, EUSCI_B3_PINS, INT_EUSCIB3 };
+
+/**** CONSTRUCTORS ****/
+DSPI_A::DSPI_A(const DSPI_Module &descriptor) :
+    engine(_registers(descriptor.module), this)
+{   //MSP432 launchpad used EUSCI_A0_SPI as default, this board EUSCI_A1_SPI
+    this->module = descriptor.module;
+    this->port = descriptor.port;
+    this->pins = descriptor.pins;
+    this->interrupt = descriptor.interrupt;
+}
+
+/**** eUSCI_A and eUSCI_B only differ in the register offsets ****/
+DSPI_Registers DSPI_A::_registers(uint32_t module)
+{
+    DSPI_Registers registers;
+
+    if ((module == EUSCI_A0_SPI_BASE) || (module == EUSCI_A1_SPI_BASE) ||
+        (module == EUSCI_A2_SPI_BASE) || (module == EUSCI_A3_SPI_BASE))
+    {
+        EUSCI_A_Type *regs = EUSCI_A_CMSIS(module);
+        registers.IE = &regs->IE;
+        registers.IFG = &regs->IFG;
+        registers.STATW = &regs->STATW;
+        registers.RXBUF = &regs->RXBUF;
+        registers.TXBUF = &regs->TXBUF;
+    }
+    else
+    {
+        EUSCI_B_Type *regs = EUSCI_B_CMSIS(module);
+        registers.IE = &regs->IE;
+        registers.IFG = &regs->IFG;
+        registers.STATW = &regs->STATW;
+        registers.RXBUF = &regs->RXBUF;
+        registers.TXBUF = &regs->TXBUF;
+    }
+    return registers;
 }
 
 /**** DESTRUCTORS Reset the module ****/
@@ -33,9 +74,15 @@ void DSPI_A::initMaster( unsigned int speed )
 
     _initMain();    //SPI pins init
 
+    // the eUSCI divides SMCLK by an integer of at least 1
+    uint32_t smclk = MAP_CS_getSMCLK();
+    if (speed > smclk) {
+        speed = smclk;
+    }
+
     eUSCI_SPI_MasterConfig config;
     config.selectClockSource    = EUSCI_A_SPI_CLOCKSOURCE_SMCLK;    // SMCLK Clock Source
-    config.clockSourceFrequency = MAP_CS_getSMCLK();
+    config.clockSourceFrequency = smclk;
     config.desiredSpiClock      = speed; //150kHz
     config.msbFirst             = EUSCI_A_SPI_MSB_FIRST;                                    // MSB first, macro found in spi.h
     config.spiMode                = EUSCI_SPI_3PIN;
@@ -46,6 +93,11 @@ void DSPI_A::initMaster( unsigned int speed )
     MAP_SPI_enableModule(this->module);
 }
 
+unsigned int DSPI_A::maxFrequency( void )
+{
+    return MAP_CS_getSMCLK();
+}
+
 /**** Read and write 1 byte of data ****/
 uint8_t DSPI_A::transfer(uint8_t data)
 {
@@ -58,14 +110,134 @@ uint8_t DSPI_A::transfer(uint8_t data)
     return MAP_SPI_receiveData(this->module);
 }
 
+/**** Read and write a block of data, false when received bytes were lost ****/
+bool DSPI_A::transfer(const uint8_t *tx, uint8_t *rx, size_t length)
+{
+    return this->engine.transfer(tx, rx, length, 0xFF);
+}
+
+/**** Write a block of data, discarding the received bytes ****/
+bool DSPI_A::write(const uint8_t *tx, size_t length)
+{
+    return this->engine.transfer(tx, 0, length, 0xFF);
+}
+
+/**** Read a block of data, clocking out the fill byte ****/
+bool DSPI_A::read(uint8_t *rx, size_t length, uint8_t fill)
+{
+    return this->engine.transfer(0, rx, length, fill);
+}
+
+uint32_t DSPI_A::overruns( void ) const
+{
+    return this->engine.overruns;
+}
+
+/**** Chip-select: GPIO output, active low ****/
+void DSPI_A::initChipSelect(uint32_t port, uint32_t pin)
+{
+    MAP_GPIO_setAsOutputPin(port, pin);
+    MAP_GPIO_setOutputHighOnPin(port, pin);
+}
+
+void DSPI_A::select(uint32_t port, uint32_t pin)
+{
+    MAP_GPIO_setOutputLowOnPin(port, pin);
+}
+
+void DSPI_A::deselect(uint32_t port, uint32_t pin)
+{
+    MAP_GPIO_setOutputHighOnPin(port, pin);
+}
+
+/**** Module interrupt masking for the transaction queue ****/
+void DSPI_A::disableInterrupt( void )
+{
+    MAP_Interrupt_disableInterrupt(this->interrupt);
+}
+
+void DSPI_A::enableInterrupt( void )
+{
+    MAP_Interrupt_enableInterrupt(this->interrupt);
+}
+
+/**** Global interrupt masking for the DMA completion ****/
+bool DSPI_A::enterCritical( void )
+{
+    return MAP_Interrupt_disableMaster();
+}
+
+void DSPI_A::exitCritical( bool masked )
+{
+    if (!masked)
+    {
+        MAP_Interrupt_enableMaster();
+    }
+}
+
+/**** Enable DMA mode using the given TX / RX channel mappings ****/
+void DSPI_A::setDMA(DMAController *controller, uint32_t txMapping, uint32_t rxMapping)
+{
+    if (controller)
+    {
+        uint32_t txChannel = controller->assign(txMapping);
+        uint32_t rxChannel = controller->assign(rxMapping);
+        this->engine.setDMA(controller, txChannel, rxChannel);
+    }
+    else
+    {
+        this->engine.setDMA(0, 0, 0);
+    }
+}
+
+bool DSPI_A::hasDMA( void ) const
+{
+    return this->engine.hasDMA();
+}
+
+bool DSPI_A::startTransfer(const uint8_t *tx, uint8_t *rx, size_t length,
+                           uint8_t fill, void (*callback)( void ))
+{
+    return this->engine.startTransfer(tx, rx, length, fill, callback);
+}
+
+bool DSPI_A::transferDone( void )
+{
+    return this->engine.transferDone();
+}
+
+void DSPI_A::abortTransfer( void )
+{
+    this->engine.abortTransfer();
+}
+
+/**** To be called from the DMA completion interrupt of the RX channel ****/
+void DSPI_A::handleDMAInterrupt( void )
+{
+    this->engine.handleDMAInterrupt();
+}
+
+/**** Interrupt mode, see DSPIEngine ****/
+bool DSPI_A::enqueue(const DSPI_Transaction &transaction)
+{
+    return this->engine.enqueue(transaction);
+}
+
+bool DSPI_A::queueIdle( void ) const
+{
+    return this->engine.queueIdle();
+}
+
+/**** To be called from the eUSCI module ISR ****/
+void DSPI_A::handleInterrupt( void )
+{
+    this->engine.handleInterrupt();
+}
+
 /**** PRIVATE ****/
 /**** Initialise SPI Pin Configuration based on EUSCI used ****/
 void DSPI_A::_initMain( void )
 {
-    //UCA1CLK
-    MAP_GPIO_setAsPeripheralModuleFunctionInputPin(GPIO_PORT_P2, GPIO_PIN1 , GPIO_PRIMARY_MODULE_FUNCTION);
-    //UCA1SOMI
-    MAP_GPIO_setAsPeripheralModuleFunctionInputPin(GPIO_PORT_P2, GPIO_PIN2 , GPIO_PRIMARY_MODULE_FUNCTION);
-    //UCA1SIMO
-    MAP_GPIO_setAsPeripheralModuleFunctionInputPin(GPIO_PORT_P2, GPIO_PIN3 , GPIO_PRIMARY_MODULE_FUNCTION);
+    // CLK, SOMI and SIMO of the selected module
+    MAP_GPIO_setAsPeripheralModuleFunctionInputPin(this->port, this->pins, GPIO_PRIMARY_MODULE_FUNCTION);
 }
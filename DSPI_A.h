@@ -16,24 +16,87 @@
 #ifndef DSPI_AA_H
 #define DSPI_AA_H
 
+#include <stddef.h>
 #include <driverlib.h>
 // Device specific includes
 #include "inc/msp432p4111.h"
+#include "DMAController.h"
+#include "DSPIEngine.h"
+#include "SPIBus.h"
 
-class DSPI_A
+/* eUSCI module descriptor: base address, SPI pins and interrupt.
+ * Both eUSCI_A and eUSCI_B modules can be used in SPI master mode */
+typedef struct
+{
+    uint32_t module;        /*!< EUSCI_xx_SPI_BASE */
+    uint_fast8_t port;      /*!< GPIO port of the CLK / MISO / MOSI pins */
+    uint_fast16_t pins;     /*!< CLK | MISO | MOSI */
+    uint32_t interrupt;     /*!< INT_EUSCIxx */
+} DSPI_Module;
+
+extern const DSPI_Module DSPI_EUSCI_A0;
+extern const DSPI_Module DSPI_EUSCI_A1;
+extern const DSPI_Module DSPI_EUSCI_A2;
+extern const DSPI_Module DSPI_EUSCI_A3;
+extern const DSPI_Module DSPI_EUSCI_B0;
+extern const DSPI_Module DSPI_EUSCI_B1;
+extern const DSPI_Module DSPI_EUSCI_B2;
+extern const DSPI_Module DSPI_EUSCI_B3;
+
+class DSPI_A : public SPIBus, private DSPIPlatform
 {
 private: 
     /* MSP specific modules */
     uint32_t module;
+    uint_fast8_t port;
+    uint_fast16_t pins;
+    uint32_t interrupt;
 
+    /* Block, DMA and interrupt transfers on the module registers */
+    DSPIEngine engine;
+
+    static DSPI_Registers _registers( uint32_t module );
     void _initMain( void );
 
+    virtual void disableInterrupt( void );
+    virtual void enableInterrupt( void );
+    virtual bool enterCritical( void );
+    virtual void exitCritical( bool masked );
+
 public:
-    DSPI_A();
+    DSPI_A( const DSPI_Module &descriptor = DSPI_EUSCI_A1 );
     ~DSPI_A();
 
-    void initMaster(unsigned int speed );
-    uint8_t transfer( uint8_t data );
+    virtual void initMaster(unsigned int speed );
+    virtual unsigned int maxFrequency( void );     // SMCLK: divider of 1
+    virtual uint8_t transfer( uint8_t data );
+    virtual bool transfer( const uint8_t *tx, uint8_t *rx, size_t length );
+    virtual bool write( const uint8_t *tx, size_t length );
+    virtual bool read( uint8_t *rx, size_t length, uint8_t fill = 0xFF );
+
+    virtual void initChipSelect( uint32_t port, uint32_t pin );
+    virtual void select( uint32_t port, uint32_t pin );
+    virtual void deselect( uint32_t port, uint32_t pin );
+
+    uint32_t overruns( void ) const;    // received bytes lost to an RXBUF overrun
+
+    /* DMA mode: a TX and an RX channel serve the module, the transfer runs
+     * in the background and completion is signalled through the callback
+     * (from transferDone() or handleDMAInterrupt()) */
+    void setDMA( DMAController *controller, uint32_t txMapping, uint32_t rxMapping );
+    bool hasDMA( void ) const;
+    virtual bool startTransfer( const uint8_t *tx, uint8_t *rx, size_t length,
+                                uint8_t fill = 0xFF, void (*callback)( void ) = 0 );
+    virtual bool transferDone( void );
+    virtual void abortTransfer( void );
+    void handleDMAInterrupt( void );
+
+    /* Interrupt mode: transactions are queued and executed by the eUSCI
+     * RX/TX interrupts, handleInterrupt() must be called from the module ISR.
+     * Do not mix with polled or DMA transfers while the queue is not idle */
+    bool enqueue( const DSPI_Transaction &transaction );
+    bool queueIdle( void ) const;
+    void handleInterrupt( void );
 
 protected:
 
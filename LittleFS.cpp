@@ -11,32 +11,32 @@
 static int lfs_sd_read(const struct lfs_config *c, lfs_block_t block,
                        lfs_off_t off, void *buffer, lfs_size_t size)
 {
-    SDCard *sd = (SDCard *)c->context;
-    return sd->read(buffer, (uint64_t)block * c->block_size + off, size);
+    BlockDevice *bd = (BlockDevice *)c->context;
+    return bd->read(buffer, (uint64_t)block * c->block_size + off, size);
 }
 
 static int lfs_sd_prog(const struct lfs_config *c, lfs_block_t block,
                        lfs_off_t off, const void *buffer, lfs_size_t size)
 {
-    SDCard *sd = (SDCard *)c->context;
-    return sd->program(buffer, (uint64_t)block * c->block_size + off, size);
+    BlockDevice *bd = (BlockDevice *)c->context;
+    return bd->program(buffer, (uint64_t)block * c->block_size + off, size);
 }
 
 static int lfs_sd_erase(const struct lfs_config *c, lfs_block_t block)
 {
-    SDCard *sd = (SDCard *)c->context;
-    return sd->erase((uint64_t)block * c->block_size, c->block_size);
+    BlockDevice *bd = (BlockDevice *)c->context;
+    return bd->erase((uint64_t)block * c->block_size, c->block_size);
 }
 
 static int lfs_sd_sync(const struct lfs_config *c)
 {
-    SDCard *sd = (SDCard *)c->context;
-    return sd->sync();
+    BlockDevice *bd = (BlockDevice *)c->context;
+    return bd->sync();
 }
 
 LittleFS* _FSstub;
 
-LittleFS::LittleFS(SDCard *bd, lfs_size_t read_size, lfs_size_t prog_size,
+LittleFS::LittleFS(BlockDevice *bd, lfs_size_t read_size, lfs_size_t prog_size,
                                    lfs_size_t block_size, lfs_size_t lookahead)
     : _lfs()
     , _config()
@@ -131,7 +131,7 @@ void LittleFS::TaskRun(){
 }
 
 
-int LittleFS::mount_async(SDCard *bd)
+int LittleFS::mount_async(BlockDevice *bd)
 {
     _bd = bd;
     int err = _bd->init();
@@ -185,7 +185,7 @@ int LittleFS::mount_async(SDCard *bd)
     return 0;
 }
 
-int LittleFS::mount(SDCard *bd)
+int LittleFS::mount(BlockDevice *bd)
 {
     _bd = bd;
     int err = _bd->init();
@@ -258,7 +258,7 @@ int LittleFS::unmount()
     return res;
 }
 
-int LittleFS::format(SDCard *bd, lfs_size_t read_size, lfs_size_t prog_size,
+int LittleFS::format(BlockDevice *bd, lfs_size_t read_size, lfs_size_t prog_size,
                              lfs_size_t block_size, lfs_size_t lookahead)
 {
     _bd = bd;
@@ -10,7 +10,7 @@
 #define LITTLEFS_LITTLEFS_H_
 
 #include "littlefs/lfs.h"
-#include "SDCard.h"
+#include "BlockDevice.h"
 #include "Task.h"
 #include "Console.h"
 
@@ -38,20 +38,20 @@ typedef struct statvfs {
 
 class LittleFS : public Task{
 public:
-    LittleFS(SDCard *sd = 0,
+    LittleFS(BlockDevice *bd = 0,
                           lfs_size_t read_size = LFS_READ_SIZE,
                           lfs_size_t prog_size  = LFS_READ_SIZE,
                           lfs_size_t block_size = LFS_BLOCK_SIZE,
                           lfs_size_t lookahead = LFS_LOOKAHEAD);
     ~LittleFS();
-    int format(SDCard *sd,
+    int format(BlockDevice *bd,
                           lfs_size_t read_size = LFS_READ_SIZE,
                           lfs_size_t prog_size = LFS_READ_SIZE,
                           lfs_size_t block_size = LFS_BLOCK_SIZE,
                           lfs_size_t lookahead = LFS_LOOKAHEAD);
 
-    int mount(SDCard *bd);
-    int mount_async(SDCard *bd);
+    int mount(BlockDevice *bd);
+    int mount_async(BlockDevice *bd);
     int unmount();
 
     //Remove a file from the file system.
@@ -130,7 +130,7 @@ private:
     uint8_t curOperationState = 0;  //status used internally in the operation to allow for unrolling of while-loops.
 
     struct lfs_config _config;
-    SDCard *_bd; // The block device
+    BlockDevice *_bd; // The block device
 
     uint8_t readBuf[LFS_READ_SIZE];
     uint8_t progBuf[LFS_PROG_SIZE];
@@ -0,0 +1,66 @@
+/*
+ * MSP432DMA.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "MSP432DMA.h"
+
+// uDMA control table: 32 channels, primary and alternate structures
+#if defined(__TI_COMPILER_VERSION__)
+#pragma DATA_ALIGN(MSP432DMAControlTable, 1024)
+static uint8_t MSP432DMAControlTable[1024];
+#else
+static uint8_t MSP432DMAControlTable[1024] __attribute__((aligned(1024)));
+#endif
+
+MSP432DMA::MSP432DMA(void *controlTable)
+{
+    this->_controlTable = controlTable ? controlTable : MSP432DMAControlTable;
+}
+
+void MSP432DMA::init()
+{
+    MAP_DMA_enableModule();
+    MAP_DMA_setControlBase(this->_controlTable);
+}
+
+uint32_t MSP432DMA::assign(uint32_t mapping)
+{
+    uint32_t channel = mapping & 0x0F;
+
+    MAP_DMA_assignChannel(mapping);
+    MAP_DMA_disableChannelAttribute(channel, UDMA_ATTR_ALL);
+    return channel;
+}
+
+void MSP432DMA::start(uint32_t channel, const volatile void *src,
+                      volatile void *dst, size_t length, uint8_t flags)
+{
+    uint32_t control = UDMA_SIZE_8 | UDMA_ARB_1;
+
+    control |= (flags & DMA_SRC_INCREMENT) ? UDMA_SRC_INC_8 : UDMA_SRC_INC_NONE;
+    control |= (flags & DMA_DST_INCREMENT) ? UDMA_DST_INC_8 : UDMA_DST_INC_NONE;
+
+    MAP_DMA_setChannelControl(UDMA_PRI_SELECT | channel, control);
+    MAP_DMA_setChannelTransfer(UDMA_PRI_SELECT | channel, UDMA_MODE_BASIC,
+                               (void *)src, (void *)dst, length);
+    MAP_DMA_enableChannel(channel);
+}
+
+void MSP432DMA::stop(uint32_t channel)
+{
+    MAP_DMA_disableChannel(channel);
+}
+
+bool MSP432DMA::isDone(uint32_t channel)
+{
+    // the channel disables itself and the mode falls back to STOP when done
+    return !MAP_DMA_isChannelEnabled(channel) &&
+            (MAP_DMA_getChannelMode(UDMA_PRI_SELECT | channel) == UDMA_MODE_STOP);
+}
+
+size_t MSP432DMA::maxLength() const
+{
+    return MSP432_DMA_MAX_TRANSFER;
+}
@@ -0,0 +1,37 @@
+/*
+ * MSP432DMA.h
+ *
+ *  Created on: 17 Oct 2026
+ *
+ *  DMAController implementation on top of the MSP432 uDMA driverlib calls.
+ */
+
+#ifndef MSP432DMA_H_
+#define MSP432DMA_H_
+
+#include <driverlib.h>
+#include "DMAController.h"
+
+#define MSP432_DMA_MAX_TRANSFER  1024       /*!< uDMA basic mode limit */
+
+class MSP432DMA : public DMAController
+{
+public:
+    // controlTable must be 1024 bytes aligned. When 0, the internal table is used,
+    // pass the application table when other modules also use the uDMA
+    MSP432DMA(void *controlTable = 0);
+
+    void init();
+
+    virtual uint32_t assign(uint32_t mapping);
+    virtual void start(uint32_t channel, const volatile void *src,
+                       volatile void *dst, size_t length, uint8_t flags);
+    virtual void stop(uint32_t channel);
+    virtual bool isDone(uint32_t channel);
+    virtual size_t maxLength() const;
+
+private:
+    void *_controlTable;
+};
+
+#endif /* MSP432DMA_H_ */
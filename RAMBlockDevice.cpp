@@ -0,0 +1,82 @@
+/*
+ * RAMBlockDevice.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "RAMBlockDevice.h"
+#include <string.h>
+
+RAMBlockDevice::RAMBlockDevice(uint8_t *buffer, uint64_t size, uint32_t blockSize)
+{
+    this->_buffer = buffer;
+    this->_block_size = blockSize;
+    // whole blocks only
+    this->_size = size - size % blockSize;
+    this->_is_initialized = false;
+}
+
+int RAMBlockDevice::init()
+{
+    _is_initialized = true;
+    return BD_ERROR_OK;
+}
+
+int RAMBlockDevice::deinit()
+{
+    _is_initialized = false;
+    return BD_ERROR_OK;
+}
+
+int RAMBlockDevice::read(void *buffer, uint64_t addr, uint64_t size)
+{
+    if (!_is_initialized || !is_valid_read(addr, size)) {
+        return BD_ERROR_PARAMETER;
+    }
+    memcpy(buffer, _buffer + addr, size);
+    return BD_ERROR_OK;
+}
+
+int RAMBlockDevice::program(const void *buffer, uint64_t addr, uint64_t size)
+{
+    if (!_is_initialized || !is_valid_program(addr, size)) {
+        return BD_ERROR_PARAMETER;
+    }
+    memcpy(_buffer + addr, buffer, size);
+    return BD_ERROR_OK;
+}
+
+// Erased blocks read back as 0xFF, like flash
+int RAMBlockDevice::erase(uint64_t addr, uint64_t size)
+{
+    if (!_is_initialized || !is_valid_erase(addr, size)) {
+        return BD_ERROR_PARAMETER;
+    }
+    memset(_buffer + addr, 0xFF, size);
+    return BD_ERROR_OK;
+}
+
+uint64_t RAMBlockDevice::get_read_size() const
+{
+    return _block_size;
+}
+
+uint64_t RAMBlockDevice::get_program_size() const
+{
+    return _block_size;
+}
+
+uint64_t RAMBlockDevice::get_erase_size() const
+{
+    return _block_size;
+}
+
+uint64_t RAMBlockDevice::size() const
+{
+    return _size;
+}
+
+const char *RAMBlockDevice::get_type() const
+{
+    return "RAM";
+}
@@ -0,0 +1,41 @@
+/*
+ * RAMBlockDevice.h
+ *
+ *  Created on: 17 Oct 2026
+ *
+ *  BlockDevice on a caller-provided buffer, e.g. a RAM disk for temporary
+ *  files or a target-independent LittleFS test. The buffer keeps its
+ *  contents across deinit()/init().
+ */
+
+#ifndef RAMBLOCKDEVICE_H_
+#define RAMBLOCKDEVICE_H_
+
+#include <stdint.h>
+#include "BlockDevice.h"
+
+class RAMBlockDevice : public BlockDevice
+{
+public:
+    RAMBlockDevice( uint8_t *buffer, uint64_t size, uint32_t blockSize = 512 );
+
+    virtual int init();
+    virtual int deinit();
+    virtual int read(void *buffer, uint64_t addr, uint64_t size);
+    virtual int program(const void *buffer, uint64_t addr, uint64_t size);
+    virtual int erase(uint64_t addr, uint64_t size);
+
+    virtual uint64_t get_read_size() const;
+    virtual uint64_t get_program_size() const;
+    virtual uint64_t get_erase_size() const;
+    virtual uint64_t size() const;
+    virtual const char *get_type() const;
+
+private:
+    uint8_t *_buffer;
+    uint64_t _size;
+    uint32_t _block_size;
+    bool _is_initialized;
+};
+
+#endif /* RAMBLOCKDEVICE_H_ */
@@ -0,0 +1,34 @@
+/*
+ * SDCRC.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "SDCRC.h"
+
+#define SD_CRC7_ROW(i)      SDCRC7_entry((uint8_t)(i), 8)
+#define SD_CRC16_ROW(i)     SDCRC16_entry((uint16_t)((i) << 8), 8)
+#define SD_CRC_X4(f, i)     f(i), f((i) + 1), f((i) + 2), f((i) + 3)
+#define SD_CRC_X16(f, i)    SD_CRC_X4(f, i), SD_CRC_X4(f, (i) + 4), SD_CRC_X4(f, (i) + 8), SD_CRC_X4(f, (i) + 12)
+#define SD_CRC_X64(f, i)    SD_CRC_X16(f, i), SD_CRC_X16(f, (i) + 16), SD_CRC_X16(f, (i) + 32), SD_CRC_X16(f, (i) + 48)
+#define SD_CRC_X256(f)      SD_CRC_X64(f, 0), SD_CRC_X64(f, 64), SD_CRC_X64(f, 128), SD_CRC_X64(f, 192)
+
+const uint8_t SDCRC7Table[256] = { SD_CRC_X256(SD_CRC7_ROW) };
+const uint16_t SDCRC16Table[256] = { SD_CRC_X256(SD_CRC16_ROW) };
+
+uint8_t SDCRC7(const uint8_t *data, uint32_t length)
+{
+    uint8_t crc = 0;
+    while (length--) {
+        crc = SDCRC7Table[(uint8_t)(crc << 1) ^ *data++];
+    }
+    return crc;
+}
+
+uint16_t SDCRC16(const uint8_t *data, uint32_t length, uint16_t crc)
+{
+    while (length--) {
+        crc = (crc << 8) ^ SDCRC16Table[(uint8_t)(crc >> 8) ^ *data++];
+    }
+    return crc;
+}
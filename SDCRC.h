@@ -0,0 +1,44 @@
+/*
+ * SDCRC.h
+ *
+ *  Created on: 17 Oct 2026
+ *
+ *  CRC7 (polynomial 0x09) protecting SD commands and CRC16-CCITT
+ *  (polynomial 0x1021, initial value 0) protecting SD data blocks. The
+ *  lookup tables are generated at compile time and are const, so they stay
+ *  in flash and are shared by every SDCard instance.
+ */
+
+#ifndef SDCRC_H_
+#define SDCRC_H_
+
+#include <stdint.h>
+
+#define SD_CRC7_POLYNOMIAL       0x89        /*!< x^7 + x^3 + 1, with the x^7 term */
+#define SD_CRC16_POLYNOMIAL      0x1021
+
+// One CRC7 table entry: the byte shifted through the polynomial bit by bit
+constexpr uint8_t SDCRC7_entry(uint8_t crc, int bits)
+{
+    return bits ? SDCRC7_entry(((crc & 0x80) ? (uint8_t)((crc ^ SD_CRC7_POLYNOMIAL) << 1) : (uint8_t)(crc << 1)), bits - 1)
+                : (uint8_t)(crc >> 1);
+}
+
+// One table entry: the byte shifted through the polynomial bit by bit
+constexpr uint16_t SDCRC16_entry(uint16_t crc, int bits)
+{
+    return bits ? SDCRC16_entry((crc & 0x8000) ? (uint16_t)((crc << 1) ^ SD_CRC16_POLYNOMIAL)
+                                               : (uint16_t)(crc << 1), bits - 1)
+                : crc;
+}
+
+extern const uint8_t SDCRC7Table[256];
+extern const uint16_t SDCRC16Table[256];
+
+/* CRC7 of a command packet, the caller shifts it left and sets the end bit */
+uint8_t SDCRC7(const uint8_t *data, uint32_t length);
+
+/* Continue a CRC16 over length bytes, start with crc = 0 */
+uint16_t SDCRC16(const uint8_t *data, uint32_t length, uint16_t crc = 0);
+
+#endif /* SDCRC_H_ */
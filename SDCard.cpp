@@ -9,21 +9,43 @@
 
 
 #include "SDCard.h"
+#include "SDCRC.h"
 #include <stdint.h>
+#include <string.h>
 
 #define FILLER 0xff
 #define SPI_CMD(x) (0x40 | (x & 0x3f))
-#define SD_COMMAND_TIMEOUT  5000 //ms of timeout (TODO)
+// Timeouts in ms with a time source (setTimeSource()), without one they
+// are poll budgets of timeout * SD_POLLS_PER_MS polls
+#define SD_COMMAND_TIMEOUT  5000    // ms, card busy
+#define SD_TOKEN_TIMEOUT    300     // ms, start block token
+#define SD_INIT_TIMEOUT     1000    // ms, ACMD41 initialisation
+#define SD_POLLS_PER_MS     1000    // polls counted as 1 ms without a time source
+#define SD_INIT_POLLS       2500    // ACMD41 exchanges without a time source, ~1 s at 400 kHz
 #define SD_CMD0_GO_IDLE_STATE_RETRIES   10
+
+#if SD_TRACE_ENABLED
+#define SD_TRACE_BEGIN(op, addr)    _trace.begin(op, addr)
+#define SD_TRACE_PHASE(p)           _trace.phase(p)
+#define SD_TRACE_END()              _trace.end()
+#else
+#define SD_TRACE_BEGIN(op, addr)
+#define SD_TRACE_PHASE(p)
+#define SD_TRACE_END()
+#endif
 const uint32_t SDCard::_block_size = BLOCK_SIZE_HC;
 
-SDCard::SDCard(DSPI_A* DSPI_in, uint32_t CS_port, uint32_t CS_pin){
+SDCard::SDCard(SPIBus* DSPI_in, uint32_t CS_port, uint32_t CS_pin){
+#if SD_TRACE_ENABLED
+    _trace.attach(DSPI_in);
+    this->_spi = &_trace;
+#else
     this->_spi = DSPI_in;
+#endif
     this->CS_PIN = CS_pin;
     this->CS_PORT = CS_port;
     //chip select
-    MAP_GPIO_setAsOutputPin(CS_PORT, CS_PIN);
-    MAP_GPIO_setOutputHighOnPin( CS_PORT, CS_PIN );
+    _spi->initChipSelect(CS_PORT, CS_PIN);
 
     _card_type = SDCARD_NONE;
 
@@ -31,9 +53,37 @@ SDCard::SDCard(DSPI_A* DSPI_in, uint32_t CS_port, uint32_t CS_pin){
     _init_sck = SD_INIT_FREQUENCY;
     _transfer_sck = SD_TRX_FREQUENCY;
     _erase_size = BLOCK_SIZE_HC;
+    _burst_sectors = 0;
+    _erase_timeout = SD_COMMAND_TIMEOUT;
+    _max_sck = SD_MAX_FREQUENCY;
     _is_initialized = 0;
     _sectors = 0;
     _init_ref_count = 0;
+    _wr_open = false;
+    _wr_next = 0;
+    _wr_start = 0;
+    _wr_landed = 0;
+    _rd_open = false;
+    _rd_next = 0;
+    _card_busy = false;
+    _crc_on = SD_CRC_ENABLED;
+    _millis = 0;
+    _yield = 0;
+    _polls = 0;
+    _poll_ms = 0;
+    _dq_count = 0;
+    _error = SD_BLOCK_DEVICE_OK;
+    _retained = 0;
+    _info.clear();
+#if SD_WRITE_CACHE_SECTORS
+    _wc_count = 0;
+#endif
+#if SD_READAHEAD_SECTORS
+    _ra_addr = 0;
+    _ra_count = 0;
+    _ra_used = 0;
+    _ra_window = 0;
+#endif
 }
 
 SDCard::~SDCard()
@@ -63,8 +113,10 @@ int SDCard::_initialise_card()
     }
 
     if (_crc_on) {
-        // Enable CRC TODO
-        status = _cmd(CMD59_CRC_ON_OFF, _crc_on);
+        // Enable CRC checking of commands and data blocks
+        if (SD_BLOCK_DEVICE_OK != (status = _cmd(CMD59_CRC_ON_OFF, 1))) {
+            return status;
+        }
     }
 
     // Read OCR - CMD58 Response contains OCR register
@@ -85,12 +137,24 @@ int SDCard::_initialise_card()
         arg |= OCR_HCS_CCS;
     }
 
-    /* Repeatedly issue ACMD41 until R1 is set to "0".
+    /* Repeatedly issue ACMD41 until R1 is set to "0", the card has
+     * SD_INIT_TIMEOUT to leave the idle state. Each poll is a whole command
+     * exchange: without a time source they get a budget of their own
      */
-    //TODO: Fix infinite loop problem
+    uint32_t start = _now();
+    uint32_t polls = 0;
     do {
         status = _cmd(ACMD41_SD_SEND_OP_COND, arg, 1, &response);
-    } while ((response & R1_IDLE_STATE));
+        if (!(response & R1_IDLE_STATE)) {
+            break;
+        }
+        _poll_idle();
+    } while (_millis ? ((_now() - start) < SD_INIT_TIMEOUT) : (++polls < SD_INIT_POLLS));
+
+    if (response & R1_IDLE_STATE) {
+        _card_type = CARD_UNKNOWN;
+        return SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
+    }
 
 
     // Initialisation complete: ACMD41 successful
@@ -113,9 +177,8 @@ int SDCard::_initialise_card()
 
     if (!_crc_on) {
         // Disable CRC
-        status = _cmd(CMD59_CRC_ON_OFF, _crc_on);
+        status = _cmd(CMD59_CRC_ON_OFF, 0);
     }
-    status = _cmd(CMD59_CRC_ON_OFF, 0);
 
     return status;
 }
@@ -129,30 +192,124 @@ int SDCard::init()
         goto end;
     }
 
+    SD_TRACE_BEGIN(SD_TRACE_OP_INIT, 0);
+
+    // Card kept powered across an MCU reset: re-attach without identification
+    if (_retained && (SD_BLOCK_DEVICE_OK == _warm_start())) {
+        _is_initialized = true;
+        SD_TRACE_END();
+        goto end;
+    }
+
     err = _initialise_card();
     _is_initialized = (err == SD_BLOCK_DEVICE_OK);
     if (!_is_initialized) {
-        return err;
+        SD_TRACE_END();
+        return _bd_error(err);
     }
+    _info.valid = 0;
     _sectors = _sd_sectors();
     // CMD9 failed
     if (0 == _sectors) {
-        return SD_BLOCK_DEVICE_ERROR_UNSUPPORTED;
+        SD_TRACE_END();
+        return _bd_error(SD_BLOCK_DEVICE_ERROR_UNSUPPORTED);
     }
 
     // Set block length to 512 (CMD16)
     if (_cmd(CMD16_SET_BLOCKLEN, _block_size) != 0) {
-        return SD_BLOCK_DEVICE_ERROR_UNSUPPORTED;
+        SD_TRACE_END();
+        return _bd_error(SD_BLOCK_DEVICE_ERROR_UNSUPPORTED);
     }
 
-    // Set SCK for data transfer TODO
+    // Remaining registers, configures clock, discards and write bursts
+    _read_card_info();
+
+#if SD_HIGH_SPEED_ENABLED
+    _high_speed();
+#endif
+
+    // Set SCK for data transfer
     err = _freq();
+    _save_retained();
+    SD_TRACE_END();
     if (err) {
-        return err;
+        return _bd_error(err);
     }
 
 end:
-    return SD_BLOCK_DEVICE_OK;
+    return _bd_error(SD_BLOCK_DEVICE_OK);
+}
+
+void SDCard::setRetained(SDCardRetained *retained)
+{
+    _retained = retained;
+}
+
+void SDCard::_save_retained()
+{
+    if (!_retained) {
+        return;
+    }
+    _retained->magic = SD_RETAINED_MAGIC;
+    _retained->cardType = _card_type;
+    _retained->sectors = _sectors;
+    _retained->eraseSize = _erase_size;
+    _retained->burstSectors = _burst_sectors;
+    _retained->maxSck = _max_sck;
+    _retained->transferSck = _transfer_sck;
+    _retained->info = _info;
+    _retained->crc = SDCRC16((const uint8_t *)_retained, offsetof(SDCardRetained, crc));
+}
+
+// Re-attach to a card that stayed powered: restore the retained state, go
+// straight to the transfer clock and check that the card is still in
+// transfer state with the same capacity type and CID. On failure
+// everything is left for the full initialisation
+int SDCard::_warm_start()
+{
+    const SDCardRetained *r = _retained;
+    uint32_t transfer_sck = _transfer_sck;
+    uint32_t response;
+    uint8_t cid[16];
+
+    if ((SD_RETAINED_MAGIC != r->magic) ||
+        (r->crc != SDCRC16((const uint8_t *)r, offsetof(SDCardRetained, crc)))) {
+        return SD_BLOCK_DEVICE_ERROR_NO_INIT;
+    }
+
+    _max_sck = r->maxSck;
+    _transfer_sck = r->transferSck;
+    _freq();
+
+    // The reset may have interrupted a multiple block write or read
+    select();
+    _spi->transfer(SPI_STOP_TRAN);
+    _spi->transfer(FILLER);
+    _wait_ready(SD_COMMAND_TIMEOUT);
+    unselect();
+    _cmd(CMD12_STOP_TRANSMISSION, 0x0);
+
+    // CMD13: no error pending, CMD58: powered up with the same capacity type,
+    // CMD10: the same card, when its CID was read before
+    if ((SD_BLOCK_DEVICE_OK == _cmd(CMD13_SEND_STATUS, 0x0, 0, &response)) && (0 == response) &&
+        (SD_BLOCK_DEVICE_OK == _cmd(CMD58_READ_OCR, 0x0, 0, &response)) && (response & OCR_POWER_UP) &&
+        (((response & OCR_HCS_CCS) != 0) == (SDCARD_V2HC == r->cardType)) &&
+        (!(r->info.valid & SD_INFO_CID) ||
+         ((SD_BLOCK_DEVICE_OK == _cmd(CMD10_SEND_CID, 0x0)) &&
+          (SD_BLOCK_DEVICE_OK == _read_bytes(cid, sizeof(cid))) &&
+          (0 == memcmp(cid, r->info.cid, sizeof(cid)))))) {
+        _card_type = r->cardType;
+        _sectors = r->sectors;
+        _erase_size = r->eraseSize;
+        _burst_sectors = r->burstSectors;
+        _info = r->info;
+        return SD_BLOCK_DEVICE_OK;
+    }
+
+    _max_sck = SD_MAX_FREQUENCY;
+    _transfer_sck = transfer_sck;
+    _retained->magic = 0;
+    return SD_BLOCK_DEVICE_ERROR_NO_DEVICE;
 }
 
 int SDCard::deinit()
@@ -162,148 +319,772 @@ int SDCard::deinit()
     }
 
     // Doesnt really do anything... as you can't exactly de-initialize the hardware..
+    // only write back the cache and close a pending multiple block write or read
+    sync();
 
     _is_initialized = false;
     _sectors = 0;
 
 end:
-    return SD_BLOCK_DEVICE_OK;
+    return _bd_error(SD_BLOCK_DEVICE_OK);
 }
 
 
 int SDCard::program(const void *b, uint64_t addr, uint64_t size)
 {
     if (!is_valid_program(addr, size)) {
-        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+        return _bd_error(SD_BLOCK_DEVICE_ERROR_PARAMETER);
     }
 
     if (!_is_initialized) {
-        return SD_BLOCK_DEVICE_ERROR_NO_INIT;
+        return _bd_error(SD_BLOCK_DEVICE_ERROR_NO_INIT);
     }
 
     const uint8_t *buffer = static_cast<const uint8_t *>(b);
     int status = SD_BLOCK_DEVICE_OK;
-    uint8_t response;
 
     // Get block count
     uint64_t blockCnt = size / _block_size;
+    SD_TRACE_BEGIN(SD_TRACE_OP_PROGRAM, addr);
+
+    // Queued discards must not erase the new data
+    if (SD_BLOCK_DEVICE_OK != (status = _dq_cancel(addr, size))) {
+        SD_TRACE_END();
+        return _bd_error(status);
+    }
+
+#if SD_WRITE_CACHE_SECTORS
+    // Small programs are absorbed by the write-back cache, runs that do not
+    // fit go straight to the card and replace whatever was cached there
+    if (blockCnt < SD_WRITE_CACHE_SECTORS) {
+        while ((SD_BLOCK_DEVICE_OK == status) && blockCnt) {
+            status = _wc_store(buffer, addr);
+            buffer += _block_size;
+            addr += _block_size;
+            --blockCnt;
+        }
+        SD_TRACE_END();
+        return _bd_error(status);
+    }
+    _wc_discard(addr, size);
+#endif
+
+    status = _program_blocks(buffer, addr, blockCnt);
+    SD_TRACE_END();
+    return _bd_error(status);
+}
+
+int SDCard::_program_blocks(const uint8_t *buffer, uint64_t addr, uint64_t blockCnt)
+{
+    int status = SD_BLOCK_DEVICE_OK;
+    const uint64_t start = addr;
+    const uint64_t end = addr + blockCnt * _block_size;
+    uint32_t retries = SD_WRITE_RETRIES;
+
+    // Prefetched blocks would go stale
+    _ra_invalidate();
+    _wr_landed = 0;
+
+    for (;;) {
+        // Keep the multiple block write open while the addresses follow on,
+        // a new CMD25 is only sent when the sequence breaks
+        if (_wr_open && (addr != _wr_next)) {
+            status = end_write();
+        }
+        if ((SD_BLOCK_DEVICE_OK == status) && !_wr_open) {
+            status = begin_write(addr, (end - addr) / _block_size);
+        }
+
+        // Write the data: one block at a time
+        while ((SD_BLOCK_DEVICE_OK == status) && (addr < end)) {
+            status = write_block(buffer + (addr - start));
+            if (SD_BLOCK_DEVICE_OK == status) {
+                addr += _block_size;
+            }
+        }
+        if (SD_BLOCK_DEVICE_OK == status) {
+            _wr_landed = end - start;
+            return status;
+        }
+
+        // A rejected block: resume from the first block the card did not
+        // program, instead of failing the whole run
+        if (((SD_BLOCK_DEVICE_ERROR_WRITE != status) && (SD_BLOCK_DEVICE_ERROR_CRC != status)) ||
+                (SD_BLOCK_DEVICE_OK != _resume_write(&addr))) {
+            return status;
+        }
+        if (addr < start) {
+            // a block accepted by an earlier run did not make it
+            return SD_BLOCK_DEVICE_ERROR_WRITE;
+        }
+        _wr_landed = addr - start;
+        if (!retries--) {
+            return status;
+        }
+        status = SD_BLOCK_DEVICE_OK;
+    }
+}
+
+// After a rejected block: address of the first block of the last CMD25 the
+// card did not program
+int SDCard::_resume_write(uint64_t *addr)
+{
+    uint32_t blocks;
+    int status = num_written_blocks(&blocks);
+
+    if (SD_BLOCK_DEVICE_OK == status) {
+        *addr = _wr_start + (uint64_t)blocks * _block_size;
+    }
+    return status;
+}
+
+int SDCard::num_written_blocks(uint32_t *blocks)
+{
+    uint8_t count[4];
+    int status;
+
+    if (SD_BLOCK_DEVICE_OK != (status = end_write())) {
+        return status;
+    }
+
+    // ACMD22, Response R1 + 4-byte block read, most significant byte first
+    if (SD_BLOCK_DEVICE_OK != (status = _cmd(ACMD22_SEND_NUM_WR_BLOCKS, 0x0, 1))) {
+        return status;
+    }
+    if (SD_BLOCK_DEVICE_OK != (status = _read_bytes(count, sizeof(count)))) {
+        return status;
+    }
+    *blocks = ((uint32_t)count[0] << 24) | ((uint32_t)count[1] << 16) |
+              ((uint32_t)count[2] << 8) | count[3];
+    return SD_BLOCK_DEVICE_OK;
+}
+
+int SDCard::begin_write(uint64_t addr, uint32_t blocks)
+{
+    if (!_is_initialized) {
+        return SD_BLOCK_DEVICE_ERROR_NO_INIT;
+    }
+
+    if ((addr % _block_size != 0) || (addr >= size())) {
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    }
+
+    int status = end_write();
+    if (SD_BLOCK_DEVICE_OK != status) {
+        return status;
+    }
+    if (SD_BLOCK_DEVICE_OK != (status = end_read())) {
+        return status;
+    }
 
     // SDSC Card (CCS=0) uses byte unit address
     // SDHC and SDXC Cards (CCS=1) use block unit address (512 Bytes unit)
+    uint64_t cardAddr = addr;
     if (SDCARD_V2HC == _card_type) {
-        addr = addr / _block_size;
+        cardAddr = addr / _block_size;
     }
 
-    // Send command to perform write operation
-    if (blockCnt == 1) {
-        // Single block write command
-        if (SD_BLOCK_DEVICE_OK != (status = _cmd(CMD24_WRITE_BLOCK, addr))) {
+    // Let the card pre-erase the burst, up to one allocation unit
+    if (_burst_sectors && (blocks > 1)) {
+        if (blocks > _burst_sectors) {
+            blocks = _burst_sectors;
+        }
+        if (SD_BLOCK_DEVICE_OK != (status = _cmd(ACMD23_SET_WR_BLK_ERASE_COUNT, blocks, 1))) {
             return status;
         }
+    }
+
+    // Multiple block write command: the card stays in receive-data state
+    // until the 'Stop Tran' token, also with chip-select released
+    if (SD_BLOCK_DEVICE_OK != (status = _cmd(CMD25_WRITE_MULTIPLE_BLOCK, cardAddr))) {
+        return status;
+    }
+    unselect();
 
-        // Write data
-        response = _write(buffer, SPI_START_BLOCK, _block_size);
+    _wr_open = true;
+    _wr_next = addr;
+    _wr_start = addr;
+    return SD_BLOCK_DEVICE_OK;
+}
 
-        // Only CRC and general write error are communicated via response token
-        if (response != SPI_DATA_ACCEPTED) {
-            status = SD_BLOCK_DEVICE_ERROR_WRITE;
-        }
-    } else {
-        // Pre-erase setting prior to multiple block write operation
-        _cmd(ACMD23_SET_WR_BLK_ERASE_COUNT, blockCnt, 1);
+int SDCard::write_block(const void *b)
+{
+    uint8_t response;
 
-        // Multiple block write command
-        if (SD_BLOCK_DEVICE_OK != (status = _cmd(CMD25_WRITE_MULTIPLE_BLOCK, addr))) {
-            return status;
-        }
+    if (!_wr_open) {
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    }
 
-        // Write the data: one block at a time
-        do {
-            response = _write(buffer, SPI_START_BLK_MUL_WRITE, _block_size);
-            if (response != SPI_DATA_ACCEPTED) {
-                break;
-            }
-            buffer += _block_size;
-        } while (--blockCnt);     // Receive all blocks of data
+    if (_wr_next + _block_size > size()) {
+        end_write();
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    }
+
+    // The previous block may still be programming
+    select();
+    if (_card_busy && !_wait_ready(SD_COMMAND_TIMEOUT)) {
+        unselect();
+        end_write();
+        return SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
+    }
+    response = _write(static_cast<const uint8_t *>(b), SPI_START_BLK_MUL_WRITE, _block_size);
+    unselect();
+
+    // Only CRC and general write error are communicated via response token
+    if (response != SPI_DATA_ACCEPTED) {
+        end_write();
+        return (response == SPI_DATA_CRC_ERROR) ? SD_BLOCK_DEVICE_ERROR_CRC : SD_BLOCK_DEVICE_ERROR_WRITE;
+    }
+
+    // Return while the card programs the block, busy is polled on next access
+    _card_busy = true;
+    _wr_next += _block_size;
+    return SD_BLOCK_DEVICE_OK;
+}
 
-        /* In a Multiple Block write operation, the stop transmission will be done by
-         * sending 'Stop Tran' token instead of 'Start Block' token at the beginning
-         * of the next block
-         */
-        _cmd(CMD12_STOP_TRANSMISSION, 0x0); //_cmd(CMD12_STOP_TRANSMISSION, 0x0); //_spi->transfer(SPI_STOP_TRAN);
+bool SDCard::is_busy()
+{
+    if (!_card_busy) {
+        return false;
     }
 
+    // The card holds DO low while programming
+    select();
+    SD_TRACE_PHASE(SD_TRACE_BUSY);
+    if (0xFF == _spi->transfer(FILLER)) {
+        _card_busy = false;
+    }
     unselect();
-    return status;
+    return _card_busy;
+}
+
+int SDCard::wait_idle()
+{
+    bool ready;
+
+    if (!_card_busy) {
+        return SD_BLOCK_DEVICE_OK;
+    }
+
+    select();
+    ready = _wait_ready(SD_COMMAND_TIMEOUT);
+    unselect();
+    return ready ? SD_BLOCK_DEVICE_OK : SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
+}
+
+int SDCard::end_write()
+{
+    bool ready;
+
+    if (!_wr_open) {
+        return SD_BLOCK_DEVICE_OK;
+    }
+    _wr_open = false;
+
+    /* In a Multiple Block write operation, the stop transmission is done by
+     * sending 'Stop Tran' token instead of 'Start Block' token at the beginning
+     * of the next block
+     */
+    select();
+    _wait_ready(SD_COMMAND_TIMEOUT);
+    SD_TRACE_PHASE(SD_TRACE_TOKEN);
+    _spi->transfer(SPI_STOP_TRAN);
+    _spi->transfer(FILLER);     // the busy signal starts one byte after the token
+    ready = _wait_ready(SD_COMMAND_TIMEOUT);
+    unselect();
+
+    return ready ? SD_BLOCK_DEVICE_OK : SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
+}
+
+int SDCard::sync()
+{
+    SD_TRACE_BEGIN(SD_TRACE_OP_SYNC, _wr_next);
+    int status = _wc_flush();
+    int err = end_write();
+    if (SD_BLOCK_DEVICE_OK == status) {
+        status = err;
+    }
+    err = end_read();
+    if (SD_BLOCK_DEVICE_OK == status) {
+        status = err;
+    }
+    err = flush_discards();
+    if (SD_BLOCK_DEVICE_OK == status) {
+        status = err;
+    }
+    SD_TRACE_END();
+    return _bd_error(status);
 }
 
 int SDCard::read(void *b, uint64_t addr, uint64_t size)
 {
     if (!is_valid_read(addr, size)) {
-        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+        return _bd_error(SD_BLOCK_DEVICE_ERROR_PARAMETER);
     }
 
     if (!_is_initialized) {
-        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+        return _bd_error(SD_BLOCK_DEVICE_ERROR_PARAMETER);
     }
 
     uint8_t *buffer = static_cast<uint8_t *>(b);
     int status = SD_BLOCK_DEVICE_OK;
     uint64_t blockCnt =  size / _block_size;
+    SD_TRACE_BEGIN(SD_TRACE_OP_READ, addr);
+
+    // Blocks still in the write-back cache are served from there, the
+    // runs in between from the card
+    while ((SD_BLOCK_DEVICE_OK == status) && blockCnt) {
+        uint64_t run = 0;
+        const uint8_t *cached = 0;
+        while ((run < blockCnt) && !(cached = _wc_lookup(addr + run * _block_size))) {
+            run++;
+        }
+        if (run) {
+            status = _read_ahead(buffer, addr, run);
+        } else {
+            memcpy(buffer, cached, _block_size);
+            run = 1;
+        }
+        buffer += run * _block_size;
+        addr += run * _block_size;
+        blockCnt -= run;
+    }
 
-    // SDSC Card (CCS=0) uses byte unit address
-    // SDHC and SDXC Cards (CCS=1) use block unit address (512 Bytes unit)
-    if (SDCARD_V2HC == _card_type) {
-        addr = addr / _block_size;
+    SD_TRACE_END();
+    return _bd_error(status);
+}
+
+// Read-ahead: blocks already prefetched are copied, the rest is read from
+// the card. From the second request in a row that continues the previous
+// one, the open CMD18 stream goes on with the next _ra_window blocks into
+// the prefetch buffer. The window doubles every time a prefetch is fully
+// used; a read elsewhere closes it until the reads run sequential again,
+// so random and scattered reads (littlefs metadata, CTZ skip-list hops)
+// never pay for blocks they do not use.
+int SDCard::_read_ahead(uint8_t *buffer, uint64_t addr, uint64_t blockCnt)
+{
+#if SD_READAHEAD_SECTORS
+    int status;
+    bool sequential;
+
+    while (blockCnt && _ra_count && (addr >= _ra_addr) &&
+           (addr < _ra_addr + _ra_count * _block_size)) {
+        uint64_t index = (addr - _ra_addr) / _block_size;
+        memcpy(buffer, _ra_data[index], _block_size);
+        if (index + 1 > _ra_used) {
+            _ra_used = index + 1;
+        }
+        if (_ra_used == _ra_count) {
+            // prefetch fully used: widen the window
+            _ra_count = 0;
+            if (_ra_window < SD_READAHEAD_SECTORS) {
+                _ra_window = (2 * _ra_window < SD_READAHEAD_SECTORS) ? 2 * _ra_window : SD_READAHEAD_SECTORS;
+            }
+        }
+        buffer += _block_size;
+        addr += _block_size;
+        --blockCnt;
+    }
+    if (!blockCnt) {
+        return SD_BLOCK_DEVICE_OK;
     }
 
-    // Write command ro receive data
-    if (blockCnt > 1) {
-        status = _cmd(CMD18_READ_MULTIPLE_BLOCK, addr);
-    } else {
-        status = _cmd(CMD17_READ_SINGLE_BLOCK, addr);
+    sequential = (addr == _rd_next);
+    if (_ra_count || !sequential) {
+        // the access moved away: drop the prefetch and stop prefetching
+        _ra_invalidate();
+        _ra_window = 0;
     }
-    if (SD_BLOCK_DEVICE_OK != status) {
+
+    if (SD_BLOCK_DEVICE_OK != (status = _read_blocks(buffer, addr, blockCnt))) {
         return status;
     }
 
+    if (sequential && !_ra_window) {
+        // second sequential read: prefetch from the next one on
+        _ra_window = 1;
+    } else if (sequential) {
+        uint64_t next = addr + blockCnt * _block_size;
+        uint64_t count = (size() - next) / _block_size;
+        if (count > _ra_window) {
+            count = _ra_window;
+        }
+        // a failed prefetch does not fail the read that triggered it
+        if (count && (SD_BLOCK_DEVICE_OK == _read_blocks(_ra_data[0], next, count))) {
+            _ra_addr = next;
+            _ra_count = count;
+            _ra_used = 0;
+        }
+    }
+    return SD_BLOCK_DEVICE_OK;
+#else
+    return _read_blocks(buffer, addr, blockCnt);
+#endif
+}
+
+void SDCard::_ra_invalidate()
+{
+#if SD_READAHEAD_SECTORS
+    _ra_count = 0;
+    _ra_used = 0;
+#endif
+}
+
+int SDCard::_read_blocks(uint8_t *buffer, uint64_t addr, uint64_t blockCnt)
+{
+    int status = SD_BLOCK_DEVICE_OK;
+
+    // The card does not accept commands during a multiple block write
+    if (SD_BLOCK_DEVICE_OK != (status = end_write())) {
+        return status;
+    }
+
+    // Keep the multiple block read open while the addresses follow on,
+    // CMD12 is only sent when the sequence breaks
+    if (_rd_open && (addr != _rd_next)) {
+        status = end_read();
+    }
+    if ((SD_BLOCK_DEVICE_OK == status) && !_rd_open) {
+        if ((blockCnt == 1) && (addr != _rd_next)) {
+            // Isolated block: single block read, there is nothing to stop afterwards
+            status = _read_single(buffer, addr);
+            _rd_next = addr + _block_size;
+            return status;
+        }
+        status = _begin_read(addr);
+    }
+
     // receive the data : one block at a time
-    while (blockCnt) {
-        if (0 != _read(buffer, _block_size)) {
-            status = SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
+    while ((SD_BLOCK_DEVICE_OK == status) && blockCnt) {
+        select();
+        if (SD_BLOCK_DEVICE_OK != (status = _read(buffer, _block_size))) {
+            unselect();
+            end_read();
             break;
         }
+        unselect();
+        _rd_next += _block_size;
         buffer += _block_size;
         --blockCnt;
     }
+    return status;
+}
+
+int SDCard::_read_single(uint8_t *buffer, uint64_t addr)
+{
+    int status;
+
+    // SDSC Card (CCS=0) uses byte unit address
+    // SDHC and SDXC Cards (CCS=1) use block unit address (512 Bytes unit)
+    if (SDCARD_V2HC == _card_type) {
+        addr = addr / _block_size;
+    }
+
+    if (SD_BLOCK_DEVICE_OK != (status = _cmd(CMD17_READ_SINGLE_BLOCK, addr))) {
+        return status;
+    }
+    status = _read(buffer, _block_size);
     unselect();
+    return status;
+}
+
+int SDCard::_begin_read(uint64_t addr)
+{
+    int status;
+    uint64_t cardAddr = addr;
+
+    if (SDCARD_V2HC == _card_type) {
+        cardAddr = addr / _block_size;
+    }
+
+    // Multiple block read command: the card keeps sending blocks, clocked
+    // by the host, until CMD12
+    if (SD_BLOCK_DEVICE_OK != (status = _cmd(CMD18_READ_MULTIPLE_BLOCK, cardAddr))) {
+        return status;
+    }
+    unselect();
+
+    _rd_open = true;
+    _rd_next = addr;
+    return SD_BLOCK_DEVICE_OK;
+}
+
+int SDCard::end_read()
+{
+    if (!_rd_open) {
+        return SD_BLOCK_DEVICE_OK;
+    }
+    _rd_open = false;
 
     // Send CMD12(0x00000000) to stop the transmission for multi-block transfer
-    if (size > _block_size) {
-        status = _cmd(CMD12_STOP_TRANSMISSION, 0x0);
+    return _cmd(CMD12_STOP_TRANSMISSION, 0x0);
+}
+
+// Write-back cache: returns the entry holding the block at addr, -1 if not cached
+int SDCard::_wc_find(uint64_t addr)
+{
+#if SD_WRITE_CACHE_SECTORS
+    for (int i = 0; i < _wc_count; i++) {
+        if (_wc_addr[i] == addr) {
+            return i;
+        }
+    }
+#endif
+    return -1;
+}
+
+// Write-back cache: returns the cached content of the block at addr, 0 if not cached
+const uint8_t *SDCard::_wc_lookup(uint64_t addr)
+{
+#if SD_WRITE_CACHE_SECTORS
+    int i = _wc_find(addr);
+    if (i >= 0) {
+        return _wc_data[i];
+    }
+#endif
+    return 0;
+}
+
+// Write-back cache: absorb one block, written back on sync() or at the high-water mark
+int SDCard::_wc_store(const uint8_t *buffer, uint64_t addr)
+{
+#if SD_WRITE_CACHE_SECTORS
+    int status = SD_BLOCK_DEVICE_OK;
+    int i = _wc_find(addr);
+
+    if (i < 0) {
+        if (_wc_count == SD_WRITE_CACHE_SECTORS) {
+            if (SD_BLOCK_DEVICE_OK != (status = _wc_flush())) {
+                return status;
+            }
+        }
+        i = _wc_count++;
+        _wc_addr[i] = addr;
+    }
+    memcpy(_wc_data[i], buffer, _block_size);
+
+    if (_wc_count >= SD_WRITE_CACHE_HIGH_WATER) {
+        status = _wc_flush();
     }
     return status;
+#else
+    return _program_blocks(buffer, addr, 1);
+#endif
+}
+
+// Write-back cache: write all the dirty blocks in address order, so that
+// adjacent blocks end up in the same CMD25 run
+int SDCard::_wc_flush()
+{
+#if SD_WRITE_CACHE_SECTORS
+    int status = SD_BLOCK_DEVICE_OK;
+
+    while (_wc_count) {
+        int first = 0;
+        for (int i = 1; i < _wc_count; i++) {
+            if (_wc_addr[i] < _wc_addr[first]) {
+                first = i;
+            }
+        }
+
+        if (SD_BLOCK_DEVICE_OK != (status = _program_blocks(_wc_data[first], _wc_addr[first], 1))) {
+            return status;
+        }
+
+        // swap-remove the entry just written
+        if (first != --_wc_count) {
+            _wc_addr[first] = _wc_addr[_wc_count];
+            memcpy(_wc_data[first], _wc_data[_wc_count], _block_size);
+        }
+    }
+    return status;
+#else
+    return SD_BLOCK_DEVICE_OK;
+#endif
+}
+
+// Write-back cache: drop the blocks in a range that is overwritten or trimmed
+void SDCard::_wc_discard(uint64_t addr, uint64_t size)
+{
+#if SD_WRITE_CACHE_SECTORS
+    int i = 0;
+    while (i < _wc_count) {
+        if ((_wc_addr[i] >= addr) && (_wc_addr[i] < addr + size)) {
+            if (i != --_wc_count) {
+                _wc_addr[i] = _wc_addr[_wc_count];
+                memcpy(_wc_data[i], _wc_data[_wc_count], _block_size);
+            }
+        } else {
+            i++;
+        }
+    }
+#endif
+}
+
+// BlockDevice error space: invalid address or size, anything else the card
+// reports is a device error. Positive warnings (clock capped) are no error
+int SDCard::_bd_error(int err)
+{
+    _error = err;
+    if (SD_BLOCK_DEVICE_OK <= err) {
+        return BD_ERROR_OK;
+    }
+    if (SD_BLOCK_DEVICE_ERROR_PARAMETER == err) {
+        return BD_ERROR_PARAMETER;
+    }
+    return BD_ERROR_DEVICE_ERROR;
 }
 
 bool SDCard::_is_valid_trim(uint64_t addr, uint64_t size)
 {
     return (
-               addr % _erase_size == 0 &&
-               size % _erase_size == 0 &&
+               addr % _block_size == 0 &&
+               size % _block_size == 0 &&
                addr + size <= this->size());
 }
 
+int SDCard::erase(uint64_t addr, uint64_t size)
+{
+    // No erase is needed before a program: the blocks are only discarded,
+    // whatever littlefs leaves unwritten reaches the card as a trim
+    return trim(addr, size);
+}
+
 int SDCard::trim(uint64_t addr, uint64_t size)
 {
     if (!_is_valid_trim(addr, size)) {
-        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+        return _bd_error(SD_BLOCK_DEVICE_ERROR_PARAMETER);
     }
 
     if (!_is_initialized) {
-        return SD_BLOCK_DEVICE_ERROR_NO_INIT;
+        return _bd_error(SD_BLOCK_DEVICE_ERROR_NO_INIT);
     }
+
+    // Cached and prefetched data for the range is discarded as well
+    _wc_discard(addr, size);
+    _ra_invalidate();
+
+    if (!size) {
+        return _bd_error(SD_BLOCK_DEVICE_OK);
+    }
+
+    // Merge with the queued ranges the new one overlaps or touches
+    uint64_t end = addr + size;
+    int i = 0;
+    while (i < _dq_count) {
+        if ((_dq_start[i] <= end) && (_dq_end[i] >= addr)) {
+            if (_dq_start[i] < addr) {
+                addr = _dq_start[i];
+            }
+            if (_dq_end[i] > end) {
+                end = _dq_end[i];
+            }
+            _dq_remove(i);
+        } else {
+            i++;
+        }
+    }
+
+    // Queue full: hand the pending ranges to the card first
+    if (SD_DISCARD_RANGES == _dq_count) {
+        int status = flush_discards();
+        if (SD_BLOCK_DEVICE_OK != status) {
+            return _bd_error(status);
+        }
+    }
+    _dq_start[_dq_count] = addr;
+    _dq_end[_dq_count] = end;
+    _dq_count++;
+    return _bd_error(SD_BLOCK_DEVICE_OK);
+}
+
+int SDCard::flush_discards()
+{
     int status = SD_BLOCK_DEVICE_OK;
 
+    while ((SD_BLOCK_DEVICE_OK == status) && _dq_count) {
+        // Only whole erase units are handed to the card
+        uint64_t start = _dq_start[_dq_count - 1] + _erase_size - 1;
+        start -= start % _erase_size;
+        uint64_t end = _dq_end[_dq_count - 1];
+        end -= end % _erase_size;
+        _dq_count--;
+
+        if (start < end) {
+            status = _erase_range(start, end - start);
+        }
+    }
+    return status;
+}
+
+// Discard queue: drop the parts of the queued ranges that are programmed
+int SDCard::_dq_cancel(uint64_t addr, uint64_t size)
+{
+    uint64_t end = addr + size;
+    int i = 0;
+    while (i < _dq_count) {
+        if ((_dq_start[i] >= end) || (_dq_end[i] <= addr)) {
+            i++;
+            continue;
+        }
+        if ((_dq_start[i] < addr) && (_dq_end[i] > end)) {
+            // split: the tail needs a slot of its own, with the queue full
+            // the other ranges go to the card first
+            uint64_t tail = _dq_end[i];
+            _dq_end[i] = addr;
+            if (SD_DISCARD_RANGES == _dq_count) {
+                int status = flush_discards();
+                if (SD_BLOCK_DEVICE_OK != status) {
+                    return status;
+                }
+                i = 0;
+            } else {
+                i++;
+            }
+            _dq_start[_dq_count] = end;
+            _dq_end[_dq_count] = tail;
+            _dq_count++;
+        } else if (_dq_start[i] < addr) {
+            _dq_end[i] = addr;
+            i++;
+        } else if (_dq_end[i] > end) {
+            _dq_start[i] = end;
+            i++;
+        } else {
+            _dq_remove(i);
+        }
+    }
+    return SD_BLOCK_DEVICE_OK;
+}
+
+void SDCard::_dq_remove(int index)
+{
+    if (index != --_dq_count) {
+        _dq_start[index] = _dq_start[_dq_count];
+        _dq_end[index] = _dq_end[_dq_count];
+    }
+}
+
+int SDCard::_erase_range(uint64_t addr, uint64_t size)
+{
+    int status = SD_BLOCK_DEVICE_OK;
+    SD_TRACE_BEGIN(SD_TRACE_OP_TRIM, addr);
+
+    if ((SD_BLOCK_DEVICE_OK != (status = end_write())) ||
+        (SD_BLOCK_DEVICE_OK != (status = end_read()))) {
+        SD_TRACE_END();
+        return status;
+    }
+
+    // Busy time allowed for CMD38, from the SD Status erase timing
+    _erase_timeout = SD_COMMAND_TIMEOUT;
+    if (_info.eraseTimeout && _info.auSize) {
+        uint32_t timeout = _info.eraseOffset + _info.eraseTimeout * ((size + _info.auSize - 1) / _info.auSize);
+        if (timeout > _erase_timeout) {
+            _erase_timeout = timeout;
+        }
+    }
+
     size -= _block_size;
     // SDSC Card (CCS=0) uses byte unit address
     // SDHC and SDXC Cards (CCS=1) use block unit address (512 Bytes unit)
@@ -314,15 +1095,17 @@ int SDCard::trim(uint64_t addr, uint64_t size)
 
     // Start lba sent in start command
     if (SD_BLOCK_DEVICE_OK != (status = _cmd(CMD32_ERASE_WR_BLK_START_ADDR, addr))) {
-        //unlock();
+        SD_TRACE_END();
         return status;
     }
 
     // End lba = addr+size sent in end addr command
     if (SD_BLOCK_DEVICE_OK != (status = _cmd(CMD33_ERASE_WR_BLK_END_ADDR, addr + size))) {
+        SD_TRACE_END();
         return status;
     }
     status = _cmd(CMD38_ERASE, 0x0);
+    SD_TRACE_END();
     return status;
 }
 
@@ -349,6 +1132,10 @@ const char *SDCard::get_type() const
 int SDCard::frequency(uint64_t freq)
 {
     _transfer_sck = freq;
+    // the card's limit is only known once init() read TRAN_SPEED
+    if (!_is_initialized) {
+        return 0;
+    }
     int err = _freq();
     return err;
 }
@@ -356,12 +1143,12 @@ int SDCard::frequency(uint64_t freq)
 // PRIVATE FUNCTIONS
 int SDCard::_freq(void)
 {
-    // Max frequency supported is 25MHZ
-    if (_transfer_sck <= 25000000) {
+    // Max frequency supported is the card's TRAN_SPEED, 25MHz by default
+    if (_transfer_sck <= _max_sck) {
         _spi->initMaster(_transfer_sck);
         return 0;
     } else {
-        _transfer_sck = 25000000;
+        _transfer_sck = _max_sck;
         _spi->initMaster(_transfer_sck);
         return 1;
     }
@@ -370,7 +1157,7 @@ int SDCard::_freq(void)
 uint8_t SDCard::_cmd_spi(SDCard::cmdSupported cmd, uint32_t arg)
 {
     uint8_t response;
-    char cmdPacket[PACKET_SIZE];
+    uint8_t cmdPacket[PACKET_SIZE];
 
     // Prepare the command packet
     cmdPacket[0] = SPI_CMD(cmd);
@@ -379,32 +1166,18 @@ uint8_t SDCard::_cmd_spi(SDCard::cmdSupported cmd, uint32_t arg)
     cmdPacket[3] = (arg >> 8);
     cmdPacket[4] = (arg >> 0);
 
-    if (_crc_on) {
-        cmdPacket[5] = (getCRC7(cmdPacket, 5) << 1) | 1;
-    } else
-    {
-        // CMD0 is executed in SD mode, hence should have correct CRC
-        // CMD8 CRC verification is always enabled
-        switch (cmd) {
-            case CMD0_GO_IDLE_STATE:
-                cmdPacket[5] = 0x95;
-                break;
-            case CMD8_SEND_IF_COND:
-                cmdPacket[5] = 0x87;
-                break;
-            default:
-                cmdPacket[5] = 0xFF;    // Make sure bit 0-End bit is high
-                break;
-        }
-    }
+    // Always send a valid CRC7: CMD0 is executed in SD mode, CMD8 CRC
+    // verification is always enabled and the rest is checked in CRC mode.
+    // End bit is high
+    cmdPacket[5] = (SDCRC7(cmdPacket, 5) << 1) | 1;
 
     // send a command
-    for (int i = 0; i < PACKET_SIZE; i++) {
-        _spi->transfer(cmdPacket[i]);
-    }
+    SD_TRACE_PHASE(SD_TRACE_COMMAND);
+    _spi->write(cmdPacket, PACKET_SIZE);
 
     // The received byte immediataly following CMD12 is a stuff byte,
     // it should be discarded before receive the response of the CMD12.
+    SD_TRACE_PHASE(SD_TRACE_RESPONSE);
     if (CMD12_STOP_TRANSMISSION == cmd) {
         _spi->transfer(FILLER);
     }
@@ -487,6 +1260,7 @@ int SDCard::_cmd(SDCard::cmdSupported cmd, uint32_t arg, bool isAcmd, uint32_t *
         case CMD8_SEND_IF_COND:             // Response R7
             _card_type = SDCARD_V2; // fallthrough
         case CMD58_READ_OCR:                // Response R3
+            SD_TRACE_PHASE(SD_TRACE_RESPONSE);
             response  = (_spi->transfer(FILLER) << 24);
             response |= (_spi->transfer(FILLER) << 16);
             response |= (_spi->transfer(FILLER) << 8);
@@ -494,12 +1268,16 @@ int SDCard::_cmd(SDCard::cmdSupported cmd, uint32_t arg, bool isAcmd, uint32_t *
             break;
 
         case CMD12_STOP_TRANSMISSION:       // Response R1b
-        case CMD38_ERASE:
             _wait_ready(SD_COMMAND_TIMEOUT);
             break;
 
-        case ACMD13_SD_STATUS:             // Response R2
-            response = _spi->transfer(FILLER);
+        case CMD38_ERASE:                   // Response R1b
+            _wait_ready(_erase_timeout);
+            break;
+
+        case CMD13_SEND_STATUS:             // Response R2, also ACMD13: R1 then the status byte
+            SD_TRACE_PHASE(SD_TRACE_RESPONSE);
+            response = (response << 8) | _spi->transfer(FILLER);
             break;
 
         default:                            // Response R1
@@ -512,7 +1290,9 @@ int SDCard::_cmd(SDCard::cmdSupported cmd, uint32_t arg, bool isAcmd, uint32_t *
     }
 
     // Do not deselect card if read is in progress.
-    if (((CMD9_SEND_CSD == cmd) || (ACMD22_SEND_NUM_WR_BLOCKS == cmd) ||
+    if (((CMD9_SEND_CSD == cmd) || (CMD10_SEND_CID == cmd) || (ACMD22_SEND_NUM_WR_BLOCKS == cmd) ||
+            (!isAcmd && (CMD6_SWITCH_FUNC == cmd)) ||
+            (isAcmd && ((ACMD13_SD_STATUS == cmd) || (ACMD51_SEND_SCR == cmd))) ||
             (CMD24_WRITE_BLOCK == cmd) || (CMD25_WRITE_MULTIPLE_BLOCK == cmd) ||
             (CMD17_READ_SINGLE_BLOCK == cmd) || (CMD18_READ_MULTIPLE_BLOCK == cmd))
             && (SD_BLOCK_DEVICE_OK == status)) {
@@ -563,7 +1343,10 @@ uint32_t SDCard::_go_idle_state()
 
 int SDCard::_read_bytes(uint8_t *buffer, uint32_t length)
 {
+    int status;
     uint16_t crc;
+    uint16_t crc_result = 0;
+    uint8_t crcBytes[2];
 
     // read until start byte (0xFE)
     if (false == _wait_token(SPI_START_BLOCK)) {
@@ -571,22 +1354,25 @@ int SDCard::_read_bytes(uint8_t *buffer, uint32_t length)
         return SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
     }
 
-    // read data
-    for (uint32_t i = 0; i < length; i++) {
-        buffer[i] = _spi->transfer(FILLER);
+    // read data, bytes lost on the bus fail the block like a bad CRC
+    SD_TRACE_PHASE(SD_TRACE_DATA);
+    if (SD_BLOCK_DEVICE_OK != (status = _data_transfer(0, buffer, length,
+                                                       _crc_on ? &crc_result : 0))) {
+        unselect();
+        return status;
     }
 
     // Read the CRC16 checksum for the data block
-    crc = (_spi->transfer(FILLER) << 8);
-    crc |= _spi->transfer(FILLER);
+    SD_TRACE_PHASE(SD_TRACE_CRC);
+    if (!_spi->read(crcBytes, 2, FILLER)) {
+        unselect();
+        return SD_BLOCK_DEVICE_ERROR_CRC;
+    }
+    crc = (crcBytes[0] << 8) | crcBytes[1];
 
-    if (_crc_on) {
-        //todo
-        uint32_t crc_result;
-        if (crc_result != crc) {
-            unselect();
-            return SD_BLOCK_DEVICE_ERROR_CRC;
-        }
+    if (_crc_on && (crc_result != crc)) {
+        unselect();
+        return SD_BLOCK_DEVICE_ERROR_CRC;
     }
 
     unselect();
@@ -595,7 +1381,10 @@ int SDCard::_read_bytes(uint8_t *buffer, uint32_t length)
 
 int SDCard::_read(uint8_t *buffer, uint32_t length)
 {
+    int status;
     uint16_t crc;
+    uint16_t crc_result = 0;
+    uint8_t crcBytes[2];
 
     // read until start byte (0xFE)
     if (false == _wait_token(SPI_START_BLOCK)) {
@@ -603,21 +1392,22 @@ int SDCard::_read(uint8_t *buffer, uint32_t length)
     }
 
     // read data
-    for(int p = 0; p < length; p++){
-        ((char *)buffer)[p] = _spi->transfer(FILLER);
+    SD_TRACE_PHASE(SD_TRACE_DATA);
+    if (SD_BLOCK_DEVICE_OK != (status = _data_transfer(0, buffer, length,
+                                                       _crc_on ? &crc_result : 0))) {
+        return status;
     }
 
     // Read the CRC16 checksum for the data block
-    crc = (_spi->transfer(FILLER) << 8);
-    crc |= _spi->transfer(FILLER);
+    SD_TRACE_PHASE(SD_TRACE_CRC);
+    if (!_spi->read(crcBytes, 2, FILLER)) {
+        return SD_BLOCK_DEVICE_ERROR_CRC;
+    }
+    crc = (crcBytes[0] << 8) | crcBytes[1];
 
-    if (_crc_on) {
-        //todo
-        uint32_t crc_result;
-        // Compute and verify checksum
-        if ((uint16_t)crc_result != crc) {
-            return SD_BLOCK_DEVICE_ERROR_CRC;
-        }
+    // Compute and verify checksum
+    if (_crc_on && (crc_result != crc)) {
+        return SD_BLOCK_DEVICE_ERROR_CRC;
     }
 
     return 0;
@@ -626,34 +1416,32 @@ int SDCard::_read(uint8_t *buffer, uint32_t length)
 uint8_t SDCard::_write(const uint8_t *buffer, uint8_t token, uint32_t length)
 {
 
-    uint32_t crc = (~0);
+    uint16_t crc = 0xFFFF;
+    uint8_t crcBytes[2];
     uint8_t response = 0xFF;
 
     // indicate start of block
+    SD_TRACE_PHASE(SD_TRACE_TOKEN);
     _spi->transfer(token);
 
-    // write the data
-    for(int p = 0; p < length; p++){
-        _spi->transfer(((char *)buffer)[p]);
-    }
-
-    if (_crc_on) {
-        //CRC16CCITT crc16(0, false);
-        // Compute CRC
-        //todo
+    // write the data, the CRC is computed while it is being sent
+    SD_TRACE_PHASE(SD_TRACE_DATA);
+    if (SD_BLOCK_DEVICE_OK != _data_transfer(buffer, 0, length, _crc_on ? &crc : 0)) {
+        return 0;       // not accepted
     }
 
     // write the checksum CRC16
-    _spi->transfer(crc >> 8);
-    _spi->transfer(crc);
+    SD_TRACE_PHASE(SD_TRACE_CRC);
+    crcBytes[0] = crc >> 8;
+    crcBytes[1] = crc;
+    _spi->write(crcBytes, 2);
 
 
-    // check the response token
+    // check the response token, the card programs the block afterwards:
+    // callers wait for ready before the next token or command
+    SD_TRACE_PHASE(SD_TRACE_RESPONSE);
     response = _spi->transfer(FILLER);
 
-    // Wait for last block to be written
-    _wait_ready(SD_COMMAND_TIMEOUT);
-
     return (response & SPI_DATA_RESPONSE_MASK);
 }
 
@@ -682,10 +1470,11 @@ uint64_t SDCard::_sd_sectors()
     if (_cmd(CMD9_SEND_CSD, 0x0) != 0x0) {
         return 0;
     }
-    uint8_t csd[16];
+    uint8_t *csd = _info.csd;
     if (_read_bytes(csd, 16) != 0) {
         return 0;
     }
+    _info.valid |= SD_INFO_CSD;
 
     // csd_structure : csd[127:126]
     int csd_structure = ext_bits(csd, 127, 126);
@@ -721,39 +1510,233 @@ uint64_t SDCard::_sd_sectors()
     return blocks;
 }
 
+// CMD6 switch function, Response R1 + 64-byte switch status
+int SDCard::_switch_func(uint32_t arg, uint8_t *status)
+{
+    int err;
+    if (SD_BLOCK_DEVICE_OK != (err = _cmd(CMD6_SWITCH_FUNC, arg))) {
+        return err;
+    }
+    return _read_bytes(status, 64);
+}
+
+// Switch the card to High-Speed (function 1 of group 1) when the configured
+// transfer clock is above the default speed limit and the bus can go there
+// too, then run at the configured clock, capped by the card. Any failure
+// leaves the card at the default speed limit
+void SDCard::_high_speed()
+{
+    uint8_t status[64];
+
+    // Nothing to gain below 25MHz, the bus is limited by its clock divider
+    uint32_t sck = _transfer_sck;
+    uint32_t busMax = _spi->maxFrequency();
+    if (busMax && (busMax < sck)) {
+        sck = busMax;
+    }
+    if (sck <= SD_MAX_FREQUENCY) {
+        return;
+    }
+
+    // CMD6 needs SD 1.10 (SCR SD_SPEC) and command class 10 (CSD CCC)
+    if (!(_info.valid & SD_INFO_SCR) || (_info.sdSpec < 1) ||
+        !(SDCardInfo::bits(_info.csd, sizeof(_info.csd), 95, 84) & (1 << 10))) {
+        return;
+    }
+
+    // Check mode: group 1 supports High-Speed and would select it
+    if ((SD_BLOCK_DEVICE_OK != _switch_func(SD_SWITCH_CHECK | SD_SWITCH_HIGH_SPEED, status)) ||
+        !(SDCardInfo::bits(status, sizeof(status), 415, 400) & (1 << 1)) ||
+        (1 != SDCardInfo::bits(status, sizeof(status), 379, 376))) {
+        return;
+    }
+
+    // Switch mode: the card reports the function now selected
+    if ((SD_BLOCK_DEVICE_OK != _switch_func(SD_SWITCH_SET | SD_SWITCH_HIGH_SPEED, status)) ||
+        (1 != SDCardInfo::bits(status, sizeof(status), 379, 376))) {
+        return;
+    }
+
+    // TRAN_SPEED in the CSD now reads 50MHz
+    _max_sck = SD_HIGH_SPEED_FREQUENCY;
+    if ((SD_BLOCK_DEVICE_OK == _cmd(CMD9_SEND_CSD, 0x0)) &&
+        (SD_BLOCK_DEVICE_OK == _read_bytes(_info.csd, sizeof(_info.csd)))) {
+        _info.update();
+        if (_info.tranSpeed > SD_MAX_FREQUENCY) {
+            _max_sck = _info.tranSpeed;
+        }
+    }
+
+    // Configured clock, at most the High-Speed limit
+    if (_transfer_sck > _max_sck) {
+        _transfer_sck = _max_sck;
+    }
+    _freq();
+
+    // Verify the card still answers at the new clock (R1 and the second
+    // status byte clear), otherwise fall back to the default speed limit
+    uint32_t response;
+    if ((SD_BLOCK_DEVICE_OK != _cmd(CMD13_SEND_STATUS, 0x0, 0, &response)) || response) {
+        _max_sck = SD_MAX_FREQUENCY;
+        if (_transfer_sck > _max_sck) {
+            _transfer_sck = _max_sck;
+        }
+        _freq();
+    }
+}
+
+// Read CID, SCR and SD Status into the card info and configure the driver
+// from them. The registers are optional: what can not be read is skipped
+void SDCard::_read_card_info()
+{
+    // CMD10, Response R1 + 16-byte block read
+    if ((SD_BLOCK_DEVICE_OK == _cmd(CMD10_SEND_CID, 0x0)) &&
+        (SD_BLOCK_DEVICE_OK == _read_bytes(_info.cid, sizeof(_info.cid)))) {
+        _info.valid |= SD_INFO_CID;
+    }
+
+    // ACMD51, Response R1 + 8-byte block read
+    if ((SD_BLOCK_DEVICE_OK == _cmd(ACMD51_SEND_SCR, 0x0, 1)) &&
+        (SD_BLOCK_DEVICE_OK == _read_bytes(_info.scr, sizeof(_info.scr)))) {
+        _info.valid |= SD_INFO_SCR;
+    }
+
+    // ACMD13, Response R2 + 64-byte block read
+    if ((SD_BLOCK_DEVICE_OK == _cmd(ACMD13_SD_STATUS, 0x0, 1)) &&
+        (SD_BLOCK_DEVICE_OK == _read_bytes(_info.ssr, sizeof(_info.ssr)))) {
+        _info.valid |= SD_INFO_SSR;
+    }
+
+    _info.update();
+
+    // Clock: capped by TRAN_SPEED
+    _max_sck = _info.tranSpeed ? _info.tranSpeed : SD_MAX_FREQUENCY;
+
+    // Write bursts are sized on the allocation unit: ACMD23 pre-erases up
+    // to one AU. The AU is only a performance hint, discards keep the erase
+    // granularity of the CSD
+    _burst_sectors = 0;
+    if (_info.auSize) {
+        _burst_sectors = _info.auSize / _block_size;
+    }
+}
+
+void SDCard::setTimeSource(uint32_t (*millis)(void), void (*yield)(void))
+{
+    _millis = millis;
+    _yield = yield;
+}
+
+// Milliseconds for the wait loops: from the time source when there is one.
+// Otherwise every SD_POLLS_PER_MS polls count as one whatever they took
+// (a poll is a byte on the bus plus the yield hook), so the timeouts only
+// bound the number of polls. Either count wraps at 2^32 like a tick
+// counter: the loops compare (now - start), which stays valid across it
+uint32_t SDCard::_now()
+{
+    return _millis ? _millis() : _poll_ms;
+}
+
+// Called between two polls of a wait loop
+void SDCard::_poll_idle()
+{
+    if (++_polls >= SD_POLLS_PER_MS) {
+        _polls = 0;
+        _poll_ms++;
+    }
+    if (_yield) {
+        _yield();
+    }
+}
+
 // SPI function to wait till chip is ready and sends start token
 bool SDCard::_wait_token(uint8_t token)
 {
-    //todo timeout
-    int count = 0;
+    uint32_t start = _now();
+    SD_TRACE_PHASE(SD_TRACE_TOKEN);
     do {
         if (token == _spi->transfer(FILLER)) {
-            //_spi_timer.stop();
             return true;
-        };
-        count++;
-    } while ( count < 50000);
+        }
+        _poll_idle();
+    } while ((_now() - start) < SD_TOKEN_TIMEOUT);
     return false;
 }
 
 // SPI function to wait till chip is ready
 // The host controller should wait for end of the process until DO goes high (a 0xFF is received).
-bool SDCard::_wait_ready(int timeous_ms)//std::chrono::duration<uint32_t, std::milli> timeout)
+bool SDCard::_wait_ready(uint32_t timeout_ms)
 {
-    uint8_t response;
-    int c = 0;
+    uint32_t start = _now();
+    SD_TRACE_PHASE(SD_TRACE_BUSY);
     do {
-        response = _spi->transfer(FILLER);
-        if (response == 0xFF) {
+        if (0xFF == _spi->transfer(FILLER)) {
+            _card_busy = false;
             return true;
         }
-    } while ( c < timeous_ms);
+        _poll_idle();
+    } while ((_now() - start) < timeout_ms);
     return false;
 }
 
+// SPI function for the data phase of a block transfer: runs on DMA when
+// the bus has it, otherwise falls back to the polled block transfer.
+// When crc is given, the CRC16 of the block (received data when rx is
+// given, else the data sent) is stored there. The block then moves in
+// chunks of SD_CRC_CHUNK bytes and the CRC is updated per chunk while the
+// DMA moves the next one, so it is ready when the last byte is: for data
+// going out the chunk on the bus, for data coming in the chunk received
+// before. Returns SD_BLOCK_DEVICE_ERROR_NO_RESPONSE when the DMA did not
+// finish in time and SD_BLOCK_DEVICE_ERROR_CRC when received bytes were
+// lost on the bus
+int SDCard::_data_transfer(const uint8_t *tx, uint8_t *rx, uint32_t length, uint16_t *crc)
+{
+    uint32_t chunk = crc ? SD_CRC_CHUNK : length;
+    const uint8_t *received = 0;    // last chunk received, CRC still to add
+    uint32_t receivedLength = 0;
+    uint16_t sum = 0;
+    bool complete = true;
+
+    for (uint32_t offset = 0; offset < length; offset += chunk) {
+        uint32_t n = (length - offset < chunk) ? length - offset : chunk;
+        const uint8_t *out = tx ? tx + offset : 0;
+        uint8_t *in = rx ? rx + offset : 0;
+        bool dma = _spi->startTransfer(out, in, n, FILLER, 0);
+
+        // after a loss the block still goes to its end, the card keeps sending
+        if (!dma && !_spi->transfer(out, in, n) && in) {
+            complete = false;
+        }
+        if (crc) {
+            sum = rx ? SDCRC16(received, receivedLength, sum) : SDCRC16(out, n, sum);
+        }
+        if (dma) {
+            uint32_t start = _now();
+            while (!_spi->transferDone()) {
+                if ((_now() - start) >= SD_COMMAND_TIMEOUT) {
+                    // the buffer can be gone once we return
+                    _spi->abortTransfer();
+                    return SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
+                }
+                _poll_idle();
+            }
+        }
+        received = in;
+        receivedLength = n;
+    }
+    if (!complete) {
+        return SD_BLOCK_DEVICE_ERROR_CRC;
+    }
+    if (crc) {
+        *crc = rx ? SDCRC16(received, receivedLength, sum) : sum;
+    }
+    return SD_BLOCK_DEVICE_OK;
+}
+
 // SPI function to wait for count
 void SDCard::_spi_wait(uint8_t count)
 {
+    SD_TRACE_PHASE(SD_TRACE_FILLER);
     for (uint8_t i = 0; i < count; ++i) {
         _spi->transfer(FILLER);
     }
@@ -766,6 +1749,7 @@ void SDCard::_spi_init()
 }
 
 void SDCard::sendDummy(){
+    SD_TRACE_PHASE(SD_TRACE_FILLER);
     for(int k = 0; k < 20;  k++)
     {
     //        while (!(MAP_SPI_getInterruptStatus(EUSCI_A1_SPI_BASE, EUSCI_A_SPI_TRANSMIT_INTERRUPT )));
@@ -775,14 +1759,16 @@ void SDCard::sendDummy(){
     }
 }
 void SDCard::select(){
+    SD_TRACE_PHASE(SD_TRACE_FILLER);
     _spi->transfer(FILLER);
     _spi->transfer(FILLER);
-    MAP_GPIO_setOutputLowOnPin( CS_PORT, CS_PIN );
+    _spi->select(CS_PORT, CS_PIN);
 }
 
 void SDCard::unselect(){
+    SD_TRACE_PHASE(SD_TRACE_FILLER);
     _spi->transfer(FILLER);
-    MAP_GPIO_setOutputHighOnPin( CS_PORT, CS_PIN );
+    _spi->deselect(CS_PORT, CS_PIN);
 }
 
 
@@ -790,8 +1776,8 @@ void SDCard::unselect(){
 uint8_t SDCard::sendCmd(uint8_t cmdNumber, uint32_t payload){
     waitForReady();
 
-    char CMD[6] = {0x40 + cmdNumber, (uint8_t)(payload >> 24), (uint8_t)(payload >> 16), (uint8_t)(payload >> 8), (uint8_t)(payload), (uint8_t) 0};
-    CMD[5] = (getCRC7(CMD, 5) << 1) | 1;
+    uint8_t CMD[6] = {(uint8_t)(0x40 + cmdNumber), (uint8_t)(payload >> 24), (uint8_t)(payload >> 16), (uint8_t)(payload >> 8), (uint8_t)(payload), (uint8_t) 0};
+    CMD[5] = (SDCRC7(CMD, 5) << 1) | 1;
     //Console::log(" #CMD: %x %x %x %x %x %x", CMD[0],CMD[1],CMD[2],CMD[3],CMD[4],CMD[5]);
 
     for(int j = 0; j < 6; j++){
@@ -807,14 +1793,9 @@ uint8_t SDCard::sendCmd(uint8_t cmdNumber, uint32_t payload){
 }
 
 void SDCard::waitForReady(){
-    uint8_t reply;
-    do {
-        reply = _spi->transfer(FILLER);
-    } while ((reply) != 0xff);
+    _wait_ready(SD_COMMAND_TIMEOUT);
 }
 
 void SDCard::getArray(uint8_t Buff[], int size){
-    for(int k = 0; k < size; k++){
-        Buff[k] = _spi->transfer(0xff);
-    }
+    _spi->read(Buff, size, 0xff);
 }
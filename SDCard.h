@@ -10,13 +10,50 @@
 #define SDCARD_H_
 
 #include <stdint.h>
-#include <driverlib.h>
-#include "DSPI_A.h"
+#include <stddef.h>
+#include "SPIBus.h"
+#include "BlockDevice.h"
+#include "SDCardInfo.h"
+#if SD_TRACE_ENABLED
+#include "SDTrace.h"
+#endif
 //#include "Console.h"
 
 #define SD_INIT_FREQUENCY 200000
-#define SD_TRX_FREQUENCY  20000000
-#define SD_CRC_ENABLED    0
+#ifndef SD_TRX_FREQUENCY
+#define SD_TRX_FREQUENCY  20000000    /*!< Data transfer clock, above SD_MAX_FREQUENCY it needs High-Speed */
+#endif
+#define SD_MAX_FREQUENCY  25000000    /*!< Default speed limit, until TRAN_SPEED is known */
+#define SD_HIGH_SPEED_FREQUENCY  50000000   /*!< High-Speed mode limit */
+#ifndef SD_HIGH_SPEED_ENABLED
+#define SD_HIGH_SPEED_ENABLED    1      /*!< Switch to High-Speed with CMD6 when supported and the clock asks for it */
+#endif
+#ifndef SD_CRC_ENABLED
+#define SD_CRC_ENABLED    0     /*!< CRC7/CRC16 checking of commands and data blocks */
+#endif
+#ifndef SD_CRC_CHUNK
+#define SD_CRC_CHUNK      128   /*!< Bytes per data transfer with the CRC on, the CRC16 of one is computed during the next */
+#endif
+/* Write-back cache: 520 bytes of RAM per sector in every SDCard, off by default */
+#ifndef SD_WRITE_CACHE_SECTORS
+#define SD_WRITE_CACHE_SECTORS      0   /*!< Write-back cache size in sectors, 0 disables it */
+#endif
+#ifndef SD_WRITE_CACHE_HIGH_WATER
+#define SD_WRITE_CACHE_HIGH_WATER   SD_WRITE_CACHE_SECTORS  /*!< Dirty sectors that trigger a write back */
+#endif
+#ifndef SD_WRITE_RETRIES
+#define SD_WRITE_RETRIES            3   /*!< Resumes of a write after a rejected block, 0 disables */
+#endif
+/* Read-ahead: 512 bytes of RAM per sector in every SDCard, off by default */
+#ifndef SD_READAHEAD_SECTORS
+#define SD_READAHEAD_SECTORS        0   /*!< Largest read-ahead window in sectors, 0 disables it */
+#endif
+#ifndef SD_DISCARD_RANGES
+#define SD_DISCARD_RANGES           8   /*!< Freed ranges queued before they are erased on the card */
+#endif
+#ifndef SD_TRACE_ENABLED
+#define SD_TRACE_ENABLED  0     /*!< SPI phase tracer, see SDTrace.h */
+#endif
 
 
 #define BLOCK_SIZE_HC                            512    /*!< Block size supported for SD card is 512 bytes  */
@@ -58,6 +95,11 @@
 #define R1_ADDRESS_ERROR        (1 << 5)
 #define R1_PARAMETER_ERROR      (1 << 6)
 
+/* CMD6 argument */
+#define SD_SWITCH_CHECK          (0x0UL << 31)      /*!< Check mode: query only */
+#define SD_SWITCH_SET            (0x1UL << 31)      /*!< Switch mode */
+#define SD_SWITCH_HIGH_SPEED     (0x00FFFFF1)       /*!< Group 1 function 1, other groups unchanged */
+
 /* R1b Response */
 #define DEVICE_BUSY             (0x00)
 
@@ -72,6 +114,7 @@
 #define R2_OUT_OF_RANGE         (1 << 7)
 
 /* R3 Response : OCR Register */
+#define OCR_POWER_UP            (0x1UL << 31)
 #define OCR_HCS_CCS             (0x1 << 30)
 #define OCR_LOW_VOLTAGE         (0x01 << 24)
 #define OCR_3_3V                (0x1 << 20)
@@ -94,61 +137,30 @@
 #define SPI_READ_ERROR_ECC_C     (0x1 << 2)  /*!< Card ECC failed */
 #define SPI_READ_ERROR_OFR       (0x1 << 3)  /*!< Out of Range */
 
-class SDCard
+/* Card state kept across MCU resets, for the warm start in init(). The
+ * application places it in RAM that is not cleared at start-up */
+#define SD_RETAINED_MAGIC        0x53445752  /*!< "SDWR" */
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t cardType;
+    uint64_t sectors;
+    uint32_t eraseSize;
+    uint32_t burstSectors;
+    uint32_t maxSck;
+    uint32_t transferSck;
+    SDCardInfo info;
+    uint16_t crc;                   /*!< SDCRC16 of the fields above */
+} SDCardRetained;
+
+class SDCard: public BlockDevice
 {
 private:
-    DSPI_A* _spi;
-
-    char CRC7Table[256] = {
-        0x00, 0x09, 0x12, 0x1B, 0x24, 0x2D, 0x36, 0x3F,
-        0x48, 0x41, 0x5A, 0x53, 0x6C, 0x65, 0x7E, 0x77,
-        0x19, 0x10, 0x0B, 0x02, 0x3D, 0x34, 0x2F, 0x26,
-        0x51, 0x58, 0x43, 0x4A, 0x75, 0x7C, 0x67, 0x6E,
-        0x32, 0x3B, 0x20, 0x29, 0x16, 0x1F, 0x04, 0x0D,
-        0x7A, 0x73, 0x68, 0x61, 0x5E, 0x57, 0x4C, 0x45,
-        0x2B, 0x22, 0x39, 0x30, 0x0F, 0x06, 0x1D, 0x14,
-        0x63, 0x6A, 0x71, 0x78, 0x47, 0x4E, 0x55, 0x5C,
-        0x64, 0x6D, 0x76, 0x7F, 0x40, 0x49, 0x52, 0x5B,
-        0x2C, 0x25, 0x3E, 0x37, 0x08, 0x01, 0x1A, 0x13,
-        0x7D, 0x74, 0x6F, 0x66, 0x59, 0x50, 0x4B, 0x42,
-        0x35, 0x3C, 0x27, 0x2E, 0x11, 0x18, 0x03, 0x0A,
-        0x56, 0x5F, 0x44, 0x4D, 0x72, 0x7B, 0x60, 0x69,
-        0x1E, 0x17, 0x0C, 0x05, 0x3A, 0x33, 0x28, 0x21,
-        0x4F, 0x46, 0x5D, 0x54, 0x6B, 0x62, 0x79, 0x70,
-        0x07, 0x0E, 0x15, 0x1C, 0x23, 0x2A, 0x31, 0x38,
-        0x41, 0x48, 0x53, 0x5A, 0x65, 0x6C, 0x77, 0x7E,
-        0x09, 0x00, 0x1B, 0x12, 0x2D, 0x24, 0x3F, 0x36,
-        0x58, 0x51, 0x4A, 0x43, 0x7C, 0x75, 0x6E, 0x67,
-        0x10, 0x19, 0x02, 0x0B, 0x34, 0x3D, 0x26, 0x2F,
-        0x73, 0x7A, 0x61, 0x68, 0x57, 0x5E, 0x45, 0x4C,
-        0x3B, 0x32, 0x29, 0x20, 0x1F, 0x16, 0x0D, 0x04,
-        0x6A, 0x63, 0x78, 0x71, 0x4E, 0x47, 0x5C, 0x55,
-        0x22, 0x2B, 0x30, 0x39, 0x06, 0x0F, 0x14, 0x1D,
-        0x25, 0x2C, 0x37, 0x3E, 0x01, 0x08, 0x13, 0x1A,
-        0x6D, 0x64, 0x7F, 0x76, 0x49, 0x40, 0x5B, 0x52,
-        0x3C, 0x35, 0x2E, 0x27, 0x18, 0x11, 0x0A, 0x03,
-        0x74, 0x7D, 0x66, 0x6F, 0x50, 0x59, 0x42, 0x4B,
-        0x17, 0x1E, 0x05, 0x0C, 0x33, 0x3A, 0x21, 0x28,
-        0x5F, 0x56, 0x4D, 0x44, 0x7B, 0x72, 0x69, 0x60,
-        0x0E, 0x07, 0x1C, 0x15, 0x2A, 0x23, 0x38, 0x31,
-        0x46, 0x4F, 0x54, 0x5D, 0x62, 0x6B, 0x70, 0x79
-    };
-
-    char appendCRC7(char CRC, char message_byte)
-    {
-        return CRC7Table[(CRC << 1) ^ message_byte];
-    }
-
-    char getCRC7(char message[], int length)
-    {
-      int i;
-      char CRC = 0;
-
-      for (i = 0; i < length; ++i)
-        CRC = appendCRC7(CRC, message[i]);
-
-      return CRC;
-    }
+    SPIBus* _spi;
+#if SD_TRACE_ENABLED
+    SDTrace _trace;
+#endif
 
     uint32_t CS_PIN;
     uint32_t CS_PORT;
@@ -203,6 +215,17 @@ private:
 
     bool _is_valid_trim(uint64_t addr, uint64_t size);
 
+    int _error;                     /**< SD_BLOCK_DEVICE_* code of the last BlockDevice call */
+    int _bd_error(int err);
+
+    /* Discard queue: freed byte ranges [start, end), merged when they touch */
+    uint64_t _dq_start[SD_DISCARD_RANGES];
+    uint64_t _dq_end[SD_DISCARD_RANGES];
+    int _dq_count;
+    int _dq_cancel(uint64_t addr, uint64_t size);
+    void _dq_remove(int index);
+    int _erase_range(uint64_t addr, uint64_t size);
+
     uint32_t _init_sck;             /**< Initial SPI frequency */
     uint32_t _transfer_sck;         /**< SPI frequency during data transfer/after initialization */
 
@@ -210,9 +233,17 @@ private:
     void _spi_init();
     uint8_t _cmd_spi(SDCard::cmdSupported cmd, uint32_t arg);
     void _spi_wait(uint8_t count);
-
+    int _data_transfer(const uint8_t *tx, uint8_t *rx, uint32_t length, uint16_t *crc = 0);
+
+    /* Wait loops */
+    uint32_t (*_millis)(void);      /**< Monotonic millisecond time source, optional */
+    void (*_yield)(void);           /**< Called between polls, optional */
+    uint32_t _polls;                /**< Polls in the current ms without a time source */
+    uint32_t _poll_ms;              /**< ms counted from the polls, wraps at 2^32 */
+    uint32_t _now();
+    void _poll_idle();
     bool _wait_token(uint8_t token);        /**< Wait for token */
-    bool _wait_ready(int timeous_ms = 300);    /**< 300ms default wait for card to be ready */
+    bool _wait_ready(uint32_t timeout_ms = 300);    /**< 300ms default wait for card to be ready */
     int _read(uint8_t *buffer, uint32_t length);
     int _read_bytes(uint8_t *buffer, uint32_t length);
     uint8_t _write(const uint8_t *buffer, uint8_t token, uint32_t length);
@@ -220,38 +251,124 @@ private:
 
     static const uint32_t _block_size;
     uint32_t _erase_size;
+    uint32_t _burst_sectors;        /**< Most sectors pre-erased with ACMD23, 0 disables */
+    uint32_t _erase_timeout;        /**< ms allowed for the next CMD38 */
+    uint32_t _max_sck;              /**< Fastest SPI frequency for the card */
+    SDCardInfo _info;
+    SDCardRetained *_retained;      /**< Retained card state, optional */
+    int _warm_start();
+    void _save_retained();
+    void _read_card_info();
+    int _switch_func(uint32_t arg, uint8_t *status);
+    void _high_speed();
     bool _is_initialized;
-    bool _crc_on = 0;  //please leave off for now
+    bool _wr_open;                  /**< Multiple block write (CMD25) in progress */
+    uint64_t _wr_next;              /**< Byte address of the next block of the open write */
+    uint64_t _wr_start;             /**< Byte address the last CMD25 started at */
+    uint64_t _wr_landed;            /**< Bytes of the last run the card confirmed */
+    bool _rd_open;                  /**< Multiple block read (CMD18) in progress */
+    uint64_t _rd_next;              /**< Byte address following the last block read */
+    bool _card_busy;                /**< Card may still be programming the last block written */
+    int _begin_read(uint64_t addr);
+    int _read_single(uint8_t *buffer, uint64_t addr);
+    int _read_blocks(uint8_t *buffer, uint64_t addr, uint64_t blockCnt);
+    int _program_blocks(const uint8_t *buffer, uint64_t addr, uint64_t blockCnt);
+    int _resume_write(uint64_t *addr);
+
+    /* Write-back cache */
+#if SD_WRITE_CACHE_SECTORS
+    uint8_t _wc_data[SD_WRITE_CACHE_SECTORS][BLOCK_SIZE_HC];
+    uint64_t _wc_addr[SD_WRITE_CACHE_SECTORS];  /**< Byte address of each dirty sector */
+    int _wc_count;                              /**< Dirty sectors in the cache */
+#endif
+    /* Read-ahead */
+#if SD_READAHEAD_SECTORS
+    uint8_t _ra_data[SD_READAHEAD_SECTORS][BLOCK_SIZE_HC];
+    uint64_t _ra_addr;                          /**< Byte address of the first prefetched sector */
+    uint64_t _ra_count;                         /**< Prefetched sectors */
+    uint64_t _ra_used;                          /**< Prefetched sectors already consumed */
+    uint64_t _ra_window;                        /**< Sectors prefetched at the next sequential read, 0 when off */
+#endif
+    int _read_ahead(uint8_t *buffer, uint64_t addr, uint64_t blockCnt);
+    void _ra_invalidate();
+
+    int _wc_find(uint64_t addr);
+    const uint8_t *_wc_lookup(uint64_t addr);
+    int _wc_store(const uint8_t *buffer, uint64_t addr);
+    int _wc_flush();
+    void _wc_discard(uint64_t addr, uint64_t size);
+    bool _crc_on;                   /**< CRC checking of commands and data, SD_CRC_ENABLED */
     uint32_t _init_ref_count;
 
 public:
-    SDCard(DSPI_A* DSPI_in, uint32_t CS_port, uint32_t CS_pin);
+    SDCard(SPIBus* DSPI_in, uint32_t CS_port, uint32_t CS_pin);
     ~SDCard();
 
-    bool is_valid_read(uint64_t addr, uint64_t size) const
-        {
-            return (
-                       addr % get_read_size() == 0 &&
-                       size % get_read_size() == 0 &&
-                       addr + size <= this->size());
-        }
-
-    bool is_valid_program(uint64_t addr, uint64_t size) const
-    {
-        return (
-                   addr % get_program_size() == 0 &&
-                   size % get_program_size() == 0 &&
-                   addr + size <= this->size());
-    }
-
+    /* Time source for the timeouts and a hook called while waiting on the
+     * card, e.g. to run other tasks. The card stays selected during yield,
+     * so it must not use this SPI bus or this SDCard.
+     * Without a time source the timeouts are poll budgets, not time: set
+     * one whenever the wait limits have to hold in milliseconds (slow
+     * cards, long erases, a yield hook that takes time) */
+    void setTimeSource(uint32_t (*millis)(void), void (*yield)(void) = 0);
+
+    /* Retained RAM for a warm start: init() first probes the card at full
+     * speed with the state saved there and only runs the full
+     * identification when the card is no longer in transfer state or
+     * reports another CID */
+    void setRetained(SDCardRetained *retained);
+
+    /* The BlockDevice methods (init, deinit, read, program, erase, trim,
+     * sync) return BD_ERROR_* codes like every other BlockDevice, error()
+     * gives the SD_BLOCK_DEVICE_* code behind the last one. The SD
+     * specific calls below return SD_BLOCK_DEVICE_* codes */
     int init();
     int deinit();
     int read(void *buffer, uint64_t addr, uint64_t size);
     int program(const void *buffer, uint64_t addr, uint64_t size);
     int trim(uint64_t addr, uint64_t size);
+    int error() const
+        {
+            return _error;
+        }
+
+    /* erase() and trim() only queue the range, the card erases it on
+     * flush_discards(), which sync() calls. Programs cancel queued ranges */
+    int erase(uint64_t addr, uint64_t size);
+    int flush_discards();
+
+    /* Streaming write: keeps CMD25 open across calls, the card only receives
+     * 'Stop Tran' on end_write(), sync() or when any other command is needed */
+    int begin_write(uint64_t addr, uint32_t blocks = 0);    /**< blocks: expected burst, pre-erased */
+    int write_block(const void *buffer);
+    int end_write();
+
+    /* After a rejected block: blocks since begin_write() the card programmed
+     * without error (ACMD22). program() uses it to resume from the first
+     * block that did not land, up to SD_WRITE_RETRIES times.
+     * get_programmed_size(): bytes of the last run sent to the card (a
+     * program() past the write cache, or a cache write back) that landed */
+    int num_written_blocks(uint32_t *blocks);
+    uint64_t get_programmed_size() const
+        {
+            return _wr_landed;
+        }
+
+    /* A program returns once the card accepted the data, the card programs
+     * the block in the background. is_busy() polls the busy signal,
+     * wait_idle() blocks until programming completes */
+    bool is_busy();
+    int wait_idle();
+
+    /* Streaming read: read() keeps CMD18 open while the addresses follow on,
+     * end_read() sends CMD12. Writes, trim and sync() close it as well */
+    int end_read();
     uint64_t get_read_size() const;
     uint64_t get_program_size() const;
     uint64_t size() const;
+
+    /* Transfer clock, capped by the card. Before init() it only sets the
+     * clock init() aims for: above 25MHz that switches to High-Speed */
     int frequency(uint64_t freq);
     const char *get_type() const;
 
@@ -263,18 +380,21 @@ public:
     void waitForReady();
     void getArray(uint8_t Buff[], int size);
     void sendDummy();
-    int sync()
-        {
-            return 0;
-        }
-    int erase(uint64_t addr, uint64_t size)
+    int sync();
+    const SDCardInfo *info() const
         {
-            return 0;
+            return &_info;
         }
     uint64_t get_erase_size() const
         {
             return get_program_size();
         }
+#if SD_TRACE_ENABLED
+    SDTrace *trace()
+        {
+            return &_trace;
+        }
+#endif
 
 };
 
@@ -0,0 +1,82 @@
+/*
+ * SDCardInfo.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "SDCardInfo.h"
+#include <string.h>
+
+// TRAN_SPEED time value, in tenths
+static const uint8_t tranSpeedValue[16] = {
+    0, 10, 12, 13, 15, 20, 25, 30, 35, 40, 45, 50, 55, 60, 70, 80
+};
+
+// SD Status AU_SIZE, in KiB
+static const uint32_t auSizeKiB[16] = {
+    0, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 12288, 16384, 24576, 32768, 65536
+};
+
+// SD Status SPEED_CLASS
+static const uint8_t speedClassValue[5] = {
+    0, 2, 4, 6, 10
+};
+
+void SDCardInfo::clear()
+{
+    memset(this, 0, sizeof(*this));
+}
+
+uint32_t SDCardInfo::bits(const uint8_t *data, uint32_t size, int msb, int lsb)
+{
+    uint32_t value = 0;
+    for (int position = msb; position >= lsb; position--) {
+        uint32_t byte = size - 1 - (position >> 3);
+        value = (value << 1) | ((data[byte] >> (position & 0x7)) & 1);
+    }
+    return value;
+}
+
+void SDCardInfo::update()
+{
+    tranSpeed = 0;
+    if (valid & SD_INFO_CSD) {
+        // TRAN_SPEED: csd[103:96], unit 100kbit/s * 10^[2:0], time value [6:3]
+        uint32_t ts = bits(csd, sizeof(csd), 103, 96);
+        uint32_t unit = 10000;      // 100kbit/s, time value in tenths
+        for (uint32_t i = 0; i < (ts & 0x7); i++) {
+            unit *= 10;
+        }
+        if ((ts & 0x7) < 4) {
+            tranSpeed = unit * tranSpeedValue[(ts >> 3) & 0xF];
+        }
+    }
+
+    auSize = 0;
+    speedClass = 0;
+    eraseTimeout = 0;
+    eraseOffset = 0;
+    if (valid & SD_INFO_SSR) {
+        uint32_t sc = bits(ssr, sizeof(ssr), 447, 440);          // SPEED_CLASS
+        speedClass = (sc < sizeof(speedClassValue)) ? speedClassValue[sc] : 0;
+        auSize = auSizeKiB[bits(ssr, sizeof(ssr), 431, 428)] * 1024;   // AU_SIZE
+
+        // ERASE_TIMEOUT seconds to erase ERASE_SIZE AUs, plus ERASE_OFFSET
+        uint32_t eraseSize = bits(ssr, sizeof(ssr), 423, 408);
+        if (eraseSize) {
+            eraseTimeout = (bits(ssr, sizeof(ssr), 407, 402) * 1000 + eraseSize - 1) / eraseSize;
+            eraseOffset = bits(ssr, sizeof(ssr), 401, 400) * 1000;
+        }
+    }
+
+    sdSpec = (valid & SD_INFO_SCR) ? bits(scr, sizeof(scr), 59, 56) : 0;
+
+    manufacturer = 0;
+    serial = 0;
+    memset(product, 0, sizeof(product));
+    if (valid & SD_INFO_CID) {
+        manufacturer = cid[0];                                  // MID: cid[127:120]
+        memcpy(product, &cid[3], 5);                            // PNM: cid[103:64]
+        serial = bits(cid, sizeof(cid), 55, 24);                // PSN
+    }
+}
@@ -0,0 +1,53 @@
+/*
+ * SDCardInfo.h
+ *
+ *  Created on: 17 Oct 2026
+ *
+ *  Cached card registers (CSD, CID, SCR and the 512 bit SD Status) and the
+ *  values SDCard derives from them to configure itself: maximum clock,
+ *  allocation unit, speed class and erase timing.
+ */
+
+#ifndef SDCARDINFO_H_
+#define SDCARDINFO_H_
+
+#include <stdint.h>
+
+/* Registers read from the card, bits of SDCardInfo::valid */
+#define SD_INFO_CSD              (1 << 0)
+#define SD_INFO_CID              (1 << 1)
+#define SD_INFO_SCR              (1 << 2)
+#define SD_INFO_SSR              (1 << 3)
+
+class SDCardInfo
+{
+public:
+    // No constructor: the info is also kept in retained RAM (SDCardRetained)
+    void clear();
+
+    // Recompute the derived values from the registers marked valid
+    void update();
+
+    // Bits msb..lsb of a register of size bytes, sent MSB first
+    static uint32_t bits( const uint8_t *data, uint32_t size, int msb, int lsb );
+
+    /* raw registers */
+    uint8_t csd[16];
+    uint8_t cid[16];
+    uint8_t scr[8];
+    uint8_t ssr[64];
+    uint8_t valid;
+
+    /* derived */
+    uint32_t tranSpeed;         /*!< Maximum clock from the CSD TRAN_SPEED, Hz, 0 if unknown */
+    uint32_t auSize;            /*!< Allocation unit in bytes, 0 if unknown */
+    uint8_t speedClass;         /*!< Speed class: 0, 2, 4, 6 or 10 */
+    uint32_t eraseTimeout;      /*!< ms to erase one AU, 0 if unknown */
+    uint32_t eraseOffset;       /*!< ms added once to every erase */
+    uint8_t sdSpec;             /*!< SCR SD_SPEC */
+    uint8_t manufacturer;       /*!< CID MID */
+    char product[6];            /*!< CID PNM, 0 terminated */
+    uint32_t serial;            /*!< CID PSN */
+};
+
+#endif /* SDCARDINFO_H_ */
@@ -0,0 +1,429 @@
+/*
+ * SDRaid.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "SDRaid.h"
+#include "SDCRC.h"
+#include <string.h>
+
+static void put32(uint8_t *p, uint32_t value)
+{
+    p[0] = value;
+    p[1] = value >> 8;
+    p[2] = value >> 16;
+    p[3] = value >> 24;
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+SDRaid::SDRaid(BlockDevice **members, uint32_t count, uint8_t mode, uint32_t stripe)
+{
+    if (count > SD_RAID_MAX_MEMBERS) {
+        count = SD_RAID_MAX_MEMBERS;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        this->_members[i] = members[i];
+    }
+    this->_count = count;
+    this->_mode = mode;
+    this->_stripe_size = (stripe ? stripe : 1) * BLOCK_SIZE_HC;
+    this->_failed = 0;
+    this->_generation = 0;
+    this->_next = 0;
+    this->_size = 0;
+}
+
+int SDRaid::init()
+{
+    int status = BD_ERROR_OK;
+    uint64_t smallest = 0;
+    uint32_t all = (1u << _count) - 1;
+
+    if (!_count) {
+        return BD_ERROR_DEVICE_ERROR;
+    }
+
+    _failed = 0;
+    for (uint32_t i = 0; i < _count; i++) {
+        int err = _members[i]->init();
+        if (BD_ERROR_OK != err) {
+            // a mirror keeps working on the remaining members
+            _failed |= (1 << i);
+            status = err;
+            continue;
+        }
+        if (!smallest || (_members[i]->size() < smallest)) {
+            smallest = _members[i]->size();
+        }
+    }
+
+    if (SD_RAID1 == _mode) {
+        uint32_t generation[SD_RAID_MAX_MEMBERS];
+        uint32_t dropped[SD_RAID_MAX_MEMBERS];
+        uint32_t valid = 0;
+        uint32_t newest = 0;
+        uint32_t mask = 0;
+
+        if (_failed == all) {
+            return status;
+        }
+
+        // The newest superblock tells which members hold the data: the ones
+        // it dropped and the ones that missed it stay out until rebuild()
+        for (uint32_t i = 0; i < _count; i++) {
+            if (!(_failed & (1 << i)) &&
+                (BD_ERROR_OK == _read_super(i, &generation[i], &dropped[i]))) {
+                valid |= (1 << i);
+                if (generation[i] > newest) {
+                    newest = generation[i];
+                    mask = dropped[i] & all;
+                }
+            }
+        }
+        _generation = newest;
+        if (valid) {
+            for (uint32_t i = 0; i < _count; i++) {
+                if (!(valid & (1 << i)) || (generation[i] != newest)) {
+                    _failed |= (1 << i);
+                }
+            }
+            _failed |= mask;
+        }
+        // a new mirror, or members lost since the last superblock
+        if (!valid || (_failed != mask)) {
+            _write_super();
+        }
+        if (_failed == all) {
+            return BD_ERROR_DEVICE_ERROR;
+        }
+
+        smallest = 0;
+        for (uint32_t i = 0; i < _count; i++) {
+            if (!(_failed & (1 << i)) &&
+                (!smallest || (_members[i]->size() < smallest))) {
+                smallest = _members[i]->size();
+            }
+        }
+        _size = smallest - BLOCK_SIZE_HC;
+        return BD_ERROR_OK;
+    }
+
+    if (_failed) {
+        return status;
+    }
+    // Whole stripe units only
+    _size = (smallest - smallest % _stripe_size) * _count;
+    return BD_ERROR_OK;
+}
+
+int SDRaid::deinit()
+{
+    for (uint32_t i = 0; i < _count; i++) {
+        _members[i]->deinit();
+    }
+    _size = 0;
+    return BD_ERROR_OK;
+}
+
+int SDRaid::read(void *buffer, uint64_t addr, uint64_t size)
+{
+    if (!is_valid_read(addr, size)) {
+        return BD_ERROR_PARAMETER;
+    }
+    if (SD_RAID1 == _mode) {
+        return _mirror_read(static_cast<uint8_t *>(buffer), addr, size);
+    }
+    return _stripe(&SDRaid::_read, static_cast<uint8_t *>(buffer), addr, size);
+}
+
+int SDRaid::program(const void *buffer, uint64_t addr, uint64_t size)
+{
+    if (!is_valid_program(addr, size)) {
+        return BD_ERROR_PARAMETER;
+    }
+    // the members only read the buffer
+    uint8_t *data = const_cast<uint8_t *>(static_cast<const uint8_t *>(buffer));
+    if (SD_RAID1 == _mode) {
+        return _mirror(&SDRaid::_program, data, addr, size);
+    }
+    return _stripe(&SDRaid::_program, data, addr, size);
+}
+
+int SDRaid::erase(uint64_t addr, uint64_t size)
+{
+    if (!is_valid_program(addr, size)) {
+        return BD_ERROR_PARAMETER;
+    }
+    if (SD_RAID1 == _mode) {
+        return _mirror(&SDRaid::_erase, 0, addr, size);
+    }
+    return _stripe(&SDRaid::_erase, 0, addr, size);
+}
+
+int SDRaid::trim(uint64_t addr, uint64_t size)
+{
+    if (!is_valid_program(addr, size)) {
+        return BD_ERROR_PARAMETER;
+    }
+    if (SD_RAID1 == _mode) {
+        return _mirror(&SDRaid::_trim, 0, addr, size);
+    }
+    return _stripe(&SDRaid::_trim, 0, addr, size);
+}
+
+// Every member is synced even after an error, so that a failing card does
+// not leave data pending on the others. RAID0 returns the first error, a
+// mirror drops the failing members and only fails when none is left
+int SDRaid::sync()
+{
+    if (SD_RAID1 == _mode) {
+        return _mirror(&SDRaid::_sync, 0, 0, 0);
+    }
+
+    int status = BD_ERROR_OK;
+    for (uint32_t i = 0; i < _count; i++) {
+        int err = _members[i]->sync();
+        if ((BD_ERROR_OK == status) && (BD_ERROR_OK != err)) {
+            status = err;
+        }
+    }
+    return status;
+}
+
+uint64_t SDRaid::get_read_size() const
+{
+    return BLOCK_SIZE_HC;
+}
+
+uint64_t SDRaid::get_program_size() const
+{
+    return BLOCK_SIZE_HC;
+}
+
+uint64_t SDRaid::get_erase_size() const
+{
+    return BLOCK_SIZE_HC;
+}
+
+uint64_t SDRaid::size() const
+{
+    return _size;
+}
+
+const char *SDRaid::get_type() const
+{
+    return (SD_RAID1 == _mode) ? "RAID1" : "RAID0";
+}
+
+// Copy the mirror onto the member sector by sector, then write a superblock
+// that lists it again
+int SDRaid::rebuild(uint32_t member)
+{
+    uint8_t sector[BLOCK_SIZE_HC];
+    int status;
+
+    if ((SD_RAID1 != _mode) || (member >= _count) || !_size) {
+        return BD_ERROR_PARAMETER;
+    }
+    if (!(_failed & (1 << member))) {
+        return BD_ERROR_OK;
+    }
+    if (_members[member]->size() < _size + BLOCK_SIZE_HC) {
+        return BD_ERROR_PARAMETER;
+    }
+
+    for (uint64_t addr = 0; addr < _size; addr += BLOCK_SIZE_HC) {
+        if (BD_ERROR_OK != (status = _mirror_read(sector, addr, BLOCK_SIZE_HC))) {
+            return status;
+        }
+        if (BD_ERROR_OK != (status = _members[member]->program(sector, addr, BLOCK_SIZE_HC))) {
+            return status;
+        }
+    }
+    if (BD_ERROR_OK != (status = _members[member]->sync())) {
+        return status;
+    }
+
+    _failed &= ~(1 << member);
+    _write_super();
+    return (_failed & (1 << member)) ? BD_ERROR_DEVICE_ERROR : BD_ERROR_OK;
+}
+
+// Striping: the range is cut on the stripe units and each piece goes to
+// its member, in address order so consecutive units alternate between the
+// members and each member's part of the range stays contiguous on the card
+int SDRaid::_stripe(Operation op, uint8_t *buffer, uint64_t addr, uint64_t size)
+{
+    int status = BD_ERROR_OK;
+
+    while ((BD_ERROR_OK == status) && size) {
+        uint64_t unit = addr / _stripe_size;
+        uint64_t offset = addr % _stripe_size;
+        uint64_t length = _stripe_size - offset;
+        if (length > size) {
+            length = size;
+        }
+
+        uint32_t member = unit % _count;
+        uint64_t memberAddr = (unit / _count) * _stripe_size + offset;
+        status = (this->*op)(member, buffer, memberAddr, length);
+
+        if (buffer) {
+            buffer += length;
+        }
+        addr += length;
+        size -= length;
+    }
+    return status;
+}
+
+// Mirroring: every member gets the request, members that fail are left out
+// (degraded) as long as one of them still holds the data
+int SDRaid::_mirror(Operation op, uint8_t *buffer, uint64_t addr, uint64_t size)
+{
+    int status = BD_ERROR_DEVICE_ERROR;
+    bool written = false;
+    uint32_t failed = _failed;
+
+    for (uint32_t i = 0; i < _count; i++) {
+        if (_failed & (1 << i)) {
+            continue;
+        }
+        int err = (this->*op)(i, buffer, addr, size);
+        if (BD_ERROR_OK == err) {
+            written = true;
+        } else {
+            _failed |= (1 << i);
+            status = err;
+        }
+    }
+    // the dropped members must not serve reads after the next init()
+    if (written && (_failed != failed)) {
+        _write_super();
+    }
+    return written ? BD_ERROR_OK : status;
+}
+
+// Mirror reads go to a member that is not programming, falling back to the
+// other members when the read fails
+int SDRaid::_mirror_read(uint8_t *buffer, uint64_t addr, uint64_t size)
+{
+    int status = BD_ERROR_DEVICE_ERROR;
+    uint32_t first = _count;
+
+    for (uint32_t i = 0; i < _count; i++) {
+        uint32_t member = (_next + i) % _count;
+        if (!(_failed & (1 << member)) && !_members[member]->is_busy()) {
+            first = member;
+            break;
+        }
+    }
+    if (first == _count) {
+        // all busy: rotate
+        first = _next;
+    }
+    _next = (first + 1) % _count;
+
+    for (uint32_t i = 0; i < _count; i++) {
+        uint32_t member = (first + i) % _count;
+        if (_failed & (1 << member)) {
+            continue;
+        }
+        status = _read(member, buffer, addr, size);
+        if (BD_ERROR_OK == status) {
+            return status;
+        }
+    }
+    return status;
+}
+
+int SDRaid::_read(uint32_t member, uint8_t *buffer, uint64_t addr, uint64_t size)
+{
+    return _members[member]->read(buffer, addr, size);
+}
+
+int SDRaid::_program(uint32_t member, uint8_t *buffer, uint64_t addr, uint64_t size)
+{
+    return _members[member]->program(buffer, addr, size);
+}
+
+int SDRaid::_erase(uint32_t member, uint8_t *buffer, uint64_t addr, uint64_t size)
+{
+    return _members[member]->erase(addr, size);
+}
+
+int SDRaid::_trim(uint32_t member, uint8_t *buffer, uint64_t addr, uint64_t size)
+{
+    return _members[member]->trim(addr, size);
+}
+
+int SDRaid::_sync(uint32_t member, uint8_t *buffer, uint64_t addr, uint64_t size)
+{
+    return _members[member]->sync();
+}
+
+// Superblock in the last sector of the member: "SDR1", generation, failed
+// mask, member count and index, little endian, followed by the CRC16
+int SDRaid::_read_super(uint32_t member, uint32_t *generation, uint32_t *failed)
+{
+    uint8_t sector[BLOCK_SIZE_HC];
+    uint64_t size = _members[member]->size();
+    int status;
+
+    if (size < 2 * BLOCK_SIZE_HC) {
+        return BD_ERROR_PARAMETER;
+    }
+    if (BD_ERROR_OK != (status = _members[member]->read(sector, size - BLOCK_SIZE_HC, BLOCK_SIZE_HC))) {
+        return status;
+    }
+
+    uint16_t crc = (sector[SD_RAID_SUPER_SIZE - 2] << 8) | sector[SD_RAID_SUPER_SIZE - 1];
+    if ((SD_RAID_MAGIC != get32(&sector[0])) ||
+        (SDCRC16(sector, SD_RAID_SUPER_SIZE - 2) != crc) ||
+        (sector[12] != _count) || (sector[13] != member)) {
+        return BD_ERROR_DEVICE_ERROR;
+    }
+    *generation = get32(&sector[4]);
+    *failed = get32(&sector[8]);
+    return BD_ERROR_OK;
+}
+
+// Write a new superblock generation to the members in use, a member that
+// does not take it is dropped and the next generation leaves it out
+void SDRaid::_write_super()
+{
+    uint8_t sector[BLOCK_SIZE_HC];
+    bool retry = true;
+
+    while (retry) {
+        retry = false;
+        _generation++;
+        for (uint32_t i = 0; i < _count; i++) {
+            if (_failed & (1 << i)) {
+                continue;
+            }
+            memset(sector, 0, sizeof(sector));
+            put32(&sector[0], SD_RAID_MAGIC);
+            put32(&sector[4], _generation);
+            put32(&sector[8], _failed);
+            sector[12] = _count;
+            sector[13] = i;
+            uint16_t crc = SDCRC16(sector, SD_RAID_SUPER_SIZE - 2);
+            sector[SD_RAID_SUPER_SIZE - 2] = crc >> 8;
+            sector[SD_RAID_SUPER_SIZE - 1] = crc;
+
+            uint64_t addr = _members[i]->size() - BLOCK_SIZE_HC;
+            if ((BD_ERROR_OK != _members[i]->program(sector, addr, BLOCK_SIZE_HC)) ||
+                (BD_ERROR_OK != _members[i]->sync())) {
+                _failed |= (1 << i);
+                retry = true;
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,104 @@
+/*
+ * SDRaid.h
+ *
+ *  Created on: 17 Oct 2026
+ *
+ *  Block device over several SDCards (or any other BlockDevice with
+ *  512 byte blocks).
+ *  SD_RAID0 stripes the sectors over the members in units of stripe
+ *  sectors, SD_RAID1 mirrors every sector on all members.
+ *  Programs return once a card accepted the data (SDCard non-blocking
+ *  program), so the requests are interleaved over the members: one card
+ *  programs while the next one receives its data. The transfers
+ *  themselves are issued one member after the other and do not overlap,
+ *  also when the members sit on different SPI buses: only the programming
+ *  inside the cards runs in parallel.
+ *  A mirror member that fails a program, erase, trim or sync is dropped
+ *  and the mirror keeps running degraded on the others: the operation
+ *  still returns BD_ERROR_OK, so check degraded() / failed() after
+ *  sync() to find out that a card has to be replaced.
+ *  The mirror keeps a superblock in the last sector of every member (not
+ *  part of size()): a generation count and the failed mask, rewritten on
+ *  the remaining members whenever one is dropped. init() takes the newest
+ *  superblock, so a dropped member stays out across init() and power
+ *  cycles, and so does a member with an older or no superblock (a stale
+ *  or new card). rebuild() copies the mirror onto such a member and takes
+ *  it back.
+ */
+
+#ifndef SDRAID_H_
+#define SDRAID_H_
+
+#include <stdint.h>
+#include "SDCard.h"
+
+#define SD_RAID_MAX_MEMBERS      4
+
+/* Modes */
+#define SD_RAID0                 0           /*!< Striping */
+#define SD_RAID1                 1           /*!< Mirroring */
+
+/* Mirror superblock */
+#define SD_RAID_MAGIC            0x31524453  /*!< "SDR1" */
+#define SD_RAID_SUPER_SIZE       18          /*!< Bytes used in the sector, with the CRC16 */
+
+class SDRaid: public BlockDevice
+{
+public:
+    SDRaid( BlockDevice **members, uint32_t count, uint8_t mode, uint32_t stripe = 8 );
+
+    int init();
+    int deinit();
+    int read(void *buffer, uint64_t addr, uint64_t size);
+    int program(const void *buffer, uint64_t addr, uint64_t size);
+    int erase(uint64_t addr, uint64_t size);
+    int trim(uint64_t addr, uint64_t size);
+    int sync();
+
+    // Copy the mirror onto an initialized member left out by failed() and
+    // use it again, e.g. after replacing a card
+    int rebuild(uint32_t member);
+
+    uint64_t get_read_size() const;
+    uint64_t get_program_size() const;
+    uint64_t get_erase_size() const;
+    uint64_t size() const;
+    const char *get_type() const;
+
+    // Mirror members that failed and are no longer used, one bit per member
+    uint32_t failed() const
+        {
+            return _failed;
+        }
+
+    // The mirror runs on fewer members than it was built with
+    bool degraded() const
+        {
+            return (SD_RAID1 == _mode) && (_failed != 0);
+        }
+
+private:
+    typedef int (SDRaid::*Operation)(uint32_t member, uint8_t *buffer, uint64_t addr, uint64_t size);
+
+    int _stripe(Operation op, uint8_t *buffer, uint64_t addr, uint64_t size);
+    int _mirror(Operation op, uint8_t *buffer, uint64_t addr, uint64_t size);
+    int _read(uint32_t member, uint8_t *buffer, uint64_t addr, uint64_t size);
+    int _program(uint32_t member, uint8_t *buffer, uint64_t addr, uint64_t size);
+    int _erase(uint32_t member, uint8_t *buffer, uint64_t addr, uint64_t size);
+    int _trim(uint32_t member, uint8_t *buffer, uint64_t addr, uint64_t size);
+    int _sync(uint32_t member, uint8_t *buffer, uint64_t addr, uint64_t size);
+    int _mirror_read(uint8_t *buffer, uint64_t addr, uint64_t size);
+    int _read_super(uint32_t member, uint32_t *generation, uint32_t *failed);
+    void _write_super();
+
+    BlockDevice *_members[SD_RAID_MAX_MEMBERS];
+    uint32_t _count;
+    uint8_t _mode;
+    uint32_t _stripe_size;          /**< Bytes per stripe unit */
+    uint32_t _failed;               /**< Members left out of the mirror */
+    uint32_t _generation;           /**< Mirror superblock generation */
+    uint32_t _next;                 /**< Mirror member for the next read when all are busy */
+    uint64_t _size;
+};
+
+#endif /* SDRAID_H_ */
@@ -0,0 +1,160 @@
+/*
+ * SDTrace.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "SDTrace.h"
+#include <string.h>
+
+SDTrace::SDTrace()
+{
+    _bus = 0;
+    _clock = 0;
+    reset();
+}
+
+void SDTrace::attach(SPIBus *bus)
+{
+    _bus = bus;
+}
+
+void SDTrace::setClock(uint32_t (*clock)( void ))
+{
+    _clock = clock;
+}
+
+void SDTrace::reset( void )
+{
+    memset(records, 0, sizeof(records));
+    memset(totalBytes, 0, sizeof(totalBytes));
+    memset(totalTime, 0, sizeof(totalTime));
+    recordCount = 0;
+    _current = 0;
+    _phase = SD_TRACE_FILLER;
+    _phaseStart = _now();
+    _depth = 0;
+}
+
+// Operations can nest (e.g. a read flushing a write): only the outer one is recorded
+void SDTrace::begin(uint32_t operation, uint32_t address)
+{
+    if (_depth++) {
+        return;
+    }
+    phase(SD_TRACE_FILLER);
+    _current = &records[recordCount % SD_TRACE_RECORDS];
+    memset(_current, 0, sizeof(SDTraceRecord));
+    _current->operation = operation;
+    _current->address = address;
+    _current->start = _phaseStart;
+    recordCount++;
+}
+
+// Close the running phase and account its time
+void SDTrace::phase(uint32_t phase)
+{
+    uint32_t now = _now();
+    uint32_t elapsed = now - _phaseStart;
+
+    totalTime[_phase] += elapsed;
+    if (_current) {
+        _current->time[_phase] += elapsed;
+    }
+    _phase = phase;
+    _phaseStart = now;
+}
+
+void SDTrace::end( void )
+{
+    if (!_depth || --_depth) {
+        return;
+    }
+    phase(SD_TRACE_FILLER);
+    if (_current) {
+        _current->end = _phaseStart;
+        _current = 0;
+    }
+}
+
+void SDTrace::_count(size_t length)
+{
+    totalBytes[_phase] += length;
+    if (_current) {
+        _current->bytes[_phase] += length;
+    }
+}
+
+uint32_t SDTrace::_now( void )
+{
+    return _clock ? _clock() : 0;
+}
+
+void SDTrace::initMaster(unsigned int speed)
+{
+    _bus->initMaster(speed);
+}
+
+unsigned int SDTrace::maxFrequency( void )
+{
+    return _bus->maxFrequency();
+}
+
+uint8_t SDTrace::transfer(uint8_t data)
+{
+    _count(1);
+    return _bus->transfer(data);
+}
+
+bool SDTrace::transfer(const uint8_t *tx, uint8_t *rx, size_t length)
+{
+    _count(length);
+    return _bus->transfer(tx, rx, length);
+}
+
+bool SDTrace::write(const uint8_t *tx, size_t length)
+{
+    _count(length);
+    return _bus->write(tx, length);
+}
+
+bool SDTrace::read(uint8_t *rx, size_t length, uint8_t fill)
+{
+    _count(length);
+    return _bus->read(rx, length, fill);
+}
+
+void SDTrace::initChipSelect(uint32_t port, uint32_t pin)
+{
+    _bus->initChipSelect(port, pin);
+}
+
+void SDTrace::select(uint32_t port, uint32_t pin)
+{
+    _bus->select(port, pin);
+}
+
+void SDTrace::deselect(uint32_t port, uint32_t pin)
+{
+    _bus->deselect(port, pin);
+}
+
+bool SDTrace::startTransfer(const uint8_t *tx, uint8_t *rx, size_t length,
+                            uint8_t fill, void (*callback)( void ))
+{
+    if (!_bus->startTransfer(tx, rx, length, fill, callback)) {
+        return false;
+    }
+    _count(length);
+    return true;
+}
+
+bool SDTrace::transferDone( void )
+{
+    return _bus->transferDone();
+}
+
+void SDTrace::abortTransfer( void )
+{
+    _bus->abortTransfer();
+}
@@ -0,0 +1,96 @@
+/*
+ * SDTrace.h
+ *
+ *  Created on: 17 Oct 2026
+ *
+ *  SPI level tracer for SDCard, compiled in with SD_TRACE_ENABLED.
+ *  It sits between SDCard and the real bus, counts every byte against the
+ *  protocol phase set by SDCard and keeps a per-operation breakdown of
+ *  bytes and time in a fixed RAM ring. The records only contain 32 bit
+ *  fields, so a raw memory dump of the ring can be decoded on the host
+ *  (host/SDTraceDecoder).
+ */
+
+#ifndef SDTRACE_H_
+#define SDTRACE_H_
+
+#include <stdint.h>
+#include "SPIBus.h"
+
+#define SD_TRACE_RECORDS         32          /*!< Operations kept in the ring */
+
+/* Phases */
+#define SD_TRACE_COMMAND         0           /*!< Command packet */
+#define SD_TRACE_RESPONSE        1           /*!< NCR wait, R1..R7 and data response tokens */
+#define SD_TRACE_BUSY            2           /*!< Busy polling */
+#define SD_TRACE_TOKEN           3           /*!< Start token search and data tokens */
+#define SD_TRACE_DATA            4           /*!< Data block payload */
+#define SD_TRACE_CRC             5           /*!< Data block CRC16 */
+#define SD_TRACE_FILLER          6           /*!< Dummy clocks around chip-select */
+#define SD_TRACE_PHASES          7
+
+/* Operations */
+#define SD_TRACE_OP_NONE         0
+#define SD_TRACE_OP_INIT         1
+#define SD_TRACE_OP_READ         2
+#define SD_TRACE_OP_PROGRAM      3
+#define SD_TRACE_OP_TRIM         4
+#define SD_TRACE_OP_SYNC         5
+
+typedef struct
+{
+    uint32_t operation;
+    uint32_t address;                       /*!< First byte address of the operation */
+    uint32_t start;                         /*!< Timestamp at begin() */
+    uint32_t end;                           /*!< Timestamp at end() */
+    uint32_t bytes[SD_TRACE_PHASES];        /*!< Bytes clocked per phase */
+    uint32_t time[SD_TRACE_PHASES];         /*!< Clock ticks spent per phase */
+} SDTraceRecord;
+
+class SDTrace : public SPIBus
+{
+public:
+    SDTrace();
+
+    // The traced bus and the timestamp source (e.g. a free running timer)
+    void attach( SPIBus *bus );
+    void setClock( uint32_t (*clock)( void ) );
+
+    void begin( uint32_t operation, uint32_t address );
+    void phase( uint32_t phase );
+    void end( void );
+    void reset( void );
+
+    /* SPIBus: forwarded to the traced bus */
+    virtual void initMaster( unsigned int speed );
+    virtual unsigned int maxFrequency( void );
+    virtual uint8_t transfer( uint8_t data );
+    virtual bool transfer( const uint8_t *tx, uint8_t *rx, size_t length );
+    virtual bool write( const uint8_t *tx, size_t length );
+    virtual bool read( uint8_t *rx, size_t length, uint8_t fill );
+    virtual void initChipSelect( uint32_t port, uint32_t pin );
+    virtual void select( uint32_t port, uint32_t pin );
+    virtual void deselect( uint32_t port, uint32_t pin );
+    virtual bool startTransfer( const uint8_t *tx, uint8_t *rx, size_t length,
+                                uint8_t fill, void (*callback)( void ) );
+    virtual bool transferDone( void );
+    virtual void abortTransfer( void );
+
+    SDTraceRecord records[SD_TRACE_RECORDS];
+    uint32_t recordCount;                   /*!< Records written since reset, the ring keeps the last SD_TRACE_RECORDS */
+    uint32_t totalBytes[SD_TRACE_PHASES];   /*!< Bytes per phase since reset, also outside operations */
+    uint32_t totalTime[SD_TRACE_PHASES];
+
+private:
+    void _count( size_t length );
+    uint32_t _now( void );
+
+    SPIBus *_bus;
+    uint32_t (*_clock)( void );
+    SDTraceRecord *_current;
+    uint32_t _phase;
+    uint32_t _phaseStart;
+    uint8_t _depth;
+};
+
+#endif /* SDTRACE_H_ */
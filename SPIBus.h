@@ -0,0 +1,66 @@
+/*
+ * SPIBus.h
+ *
+ *  Created on: 17 Oct 2026
+ *
+ *  Abstract SPI master transport used by SDCard. DSPI_A implements it on
+ *  the MSP432 eUSCI modules, host/HostSPI implements it on Linux on top of
+ *  an in-process device model.
+ */
+
+#ifndef SPIBUS_H_
+#define SPIBUS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+class SPIBus
+{
+public:
+    virtual ~SPIBus() {}
+
+    // (Re)configure the bus as master with the given SCK frequency in Hz
+    virtual void initMaster( unsigned int speed ) = 0;
+
+    // Fastest SCK frequency the bus can generate, 0 when it has no limit
+    virtual unsigned int maxFrequency( void )
+    {
+        return 0;
+    }
+
+    // Read and write 1 byte of data
+    virtual uint8_t transfer( uint8_t data ) = 0;
+
+    // Block transfers: tx = 0 sends the fill byte, rx = 0 discards the received data.
+    // They return false when received bytes were lost (e.g. an RX overrun),
+    // the data in rx is then incomplete
+    virtual bool transfer( const uint8_t *tx, uint8_t *rx, size_t length ) = 0;
+    virtual bool write( const uint8_t *tx, size_t length ) = 0;
+    virtual bool read( uint8_t *rx, size_t length, uint8_t fill ) = 0;
+
+    // Chip-select handling, active low
+    virtual void initChipSelect( uint32_t port, uint32_t pin ) = 0;
+    virtual void select( uint32_t port, uint32_t pin ) = 0;
+    virtual void deselect( uint32_t port, uint32_t pin ) = 0;
+
+    // Optional background transfer (e.g. DMA): returns false when not
+    // available, the caller then falls back to the blocking calls
+    virtual bool startTransfer( const uint8_t *tx, uint8_t *rx, size_t length,
+                                uint8_t fill, void (*callback)( void ) )
+    {
+        return false;
+    }
+    virtual bool transferDone( void )
+    {
+        return true;
+    }
+
+    // Stop a background transfer that did not complete in time: the buffers
+    // are no longer touched afterwards and the next transfer starts clean,
+    // the callback is not called
+    virtual void abortTransfer( void )
+    {
+    }
+};
+
+#endif /* SPIBUS_H_ */
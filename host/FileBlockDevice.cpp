@@ -0,0 +1,149 @@
+/*
+ * FileBlockDevice.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "FileBlockDevice.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <string.h>
+
+FileBlockDevice::FileBlockDevice(const char *path, uint64_t size, uint32_t blockSize)
+{
+    this->_path = path;
+    this->_fd = -1;
+    this->_size = 0;
+    this->_requested_size = size;
+    this->_block_size = blockSize;
+}
+
+FileBlockDevice::~FileBlockDevice()
+{
+    deinit();
+}
+
+int FileBlockDevice::init()
+{
+    if (_fd >= 0) {
+        return BD_ERROR_OK;
+    }
+    _fd = open(_path, O_RDWR | O_CREAT, 0644);
+    if (_fd < 0) {
+        return BD_ERROR_DEVICE_ERROR;
+    }
+
+    uint64_t size = _requested_size;
+    if (!size) {
+        // block devices report 0 in st_size
+        off_t end = lseek(_fd, 0, SEEK_END);
+        if (end < 0) {
+            deinit();
+            return BD_ERROR_DEVICE_ERROR;
+        }
+        size = end;
+    } else {
+        struct stat st;
+        if ((fstat(_fd, &st) == 0) && S_ISREG(st.st_mode) &&
+            ((uint64_t)st.st_size < size) && (ftruncate(_fd, size) != 0)) {
+            deinit();
+            return BD_ERROR_DEVICE_ERROR;
+        }
+    }
+    _size = size - size % _block_size;
+    return BD_ERROR_OK;
+}
+
+int FileBlockDevice::deinit()
+{
+    if (_fd >= 0) {
+        fsync(_fd);
+        close(_fd);
+        _fd = -1;
+    }
+    return BD_ERROR_OK;
+}
+
+int FileBlockDevice::read(void *buffer, uint64_t addr, uint64_t size)
+{
+    if ((_fd < 0) || !is_valid_read(addr, size)) {
+        return BD_ERROR_PARAMETER;
+    }
+    uint8_t *p = static_cast<uint8_t *>(buffer);
+    while (size) {
+        ssize_t n = pread(_fd, p, size, addr);
+        if (n < 0) {
+            return BD_ERROR_DEVICE_ERROR;
+        }
+        if (n == 0) {
+            // sparse tail of a file that was never written
+            memset(p, 0, size);
+            break;
+        }
+        p += n;
+        addr += n;
+        size -= n;
+    }
+    return BD_ERROR_OK;
+}
+
+int FileBlockDevice::program(const void *buffer, uint64_t addr, uint64_t size)
+{
+    if ((_fd < 0) || !is_valid_program(addr, size)) {
+        return BD_ERROR_PARAMETER;
+    }
+    const uint8_t *p = static_cast<const uint8_t *>(buffer);
+    while (size) {
+        ssize_t n = pwrite(_fd, p, size, addr);
+        if (n <= 0) {
+            return BD_ERROR_DEVICE_ERROR;
+        }
+        p += n;
+        addr += n;
+        size -= n;
+    }
+    return BD_ERROR_OK;
+}
+
+// Like an SD card in SPI mode erase leaves the data undefined: nothing to do
+int FileBlockDevice::erase(uint64_t addr, uint64_t size)
+{
+    if ((_fd < 0) || !is_valid_erase(addr, size)) {
+        return BD_ERROR_PARAMETER;
+    }
+    return BD_ERROR_OK;
+}
+
+int FileBlockDevice::sync()
+{
+    if (_fd < 0) {
+        return BD_ERROR_PARAMETER;
+    }
+    return (fsync(_fd) == 0) ? BD_ERROR_OK : BD_ERROR_DEVICE_ERROR;
+}
+
+uint64_t FileBlockDevice::get_read_size() const
+{
+    return _block_size;
+}
+
+uint64_t FileBlockDevice::get_program_size() const
+{
+    return _block_size;
+}
+
+uint64_t FileBlockDevice::get_erase_size() const
+{
+    return _block_size;
+}
+
+uint64_t FileBlockDevice::size() const
+{
+    return _size;
+}
+
+const char *FileBlockDevice::get_type() const
+{
+    return "FILE";
+}
@@ -0,0 +1,46 @@
+/*
+ * FileBlockDevice.h
+ *
+ *  Created on: 17 Oct 2026
+ *
+ *  BlockDevice on a Linux file or raw device (e.g. /dev/sdb or a dd image
+ *  of a card) using pread/pwrite, so images written by the target can be
+ *  inspected and LittleFS can run on the host.
+ */
+
+#ifndef HOST_FILEBLOCKDEVICE_H_
+#define HOST_FILEBLOCKDEVICE_H_
+
+#include <stdint.h>
+#include "BlockDevice.h"
+
+class FileBlockDevice : public BlockDevice
+{
+public:
+    /* size 0 takes the size of the existing file, otherwise the file is
+     * created or extended to size bytes */
+    FileBlockDevice( const char *path, uint64_t size = 0, uint32_t blockSize = 512 );
+    ~FileBlockDevice();
+
+    virtual int init();
+    virtual int deinit();
+    virtual int read(void *buffer, uint64_t addr, uint64_t size);
+    virtual int program(const void *buffer, uint64_t addr, uint64_t size);
+    virtual int erase(uint64_t addr, uint64_t size);
+    virtual int sync();
+
+    virtual uint64_t get_read_size() const;
+    virtual uint64_t get_program_size() const;
+    virtual uint64_t get_erase_size() const;
+    virtual uint64_t size() const;
+    virtual const char *get_type() const;
+
+private:
+    const char *_path;
+    int _fd;
+    uint64_t _size;
+    uint64_t _requested_size;
+    uint32_t _block_size;
+};
+
+#endif /* HOST_FILEBLOCKDEVICE_H_ */
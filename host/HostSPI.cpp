@@ -0,0 +1,127 @@
+/*
+ * HostSPI.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "HostSPI.h"
+
+HostSPI::HostSPI(SPIDevice *device)
+{
+    this->_device = device;
+    this->_selected = false;
+    this->clock = 0;
+    this->maxClock = 0;
+    this->lostByte = 0;
+    this->overruns = 0;
+    resetCounters();
+}
+
+void HostSPI::resetCounters( void )
+{
+    this->bytes = 0;
+    this->selectedBytes = 0;
+    this->selects = 0;
+    this->busTime = 0;
+    this->idleTime = 0;
+}
+
+void HostSPI::idle(double seconds)
+{
+    this->idleTime += seconds;
+    this->_device->elapse(seconds);
+}
+
+void HostSPI::initMaster(unsigned int speed)
+{
+    if (this->maxClock && (speed > this->maxClock)) {
+        speed = this->maxClock;
+    }
+    this->clock = speed;
+}
+
+unsigned int HostSPI::maxFrequency( void )
+{
+    return this->maxClock;
+}
+
+uint8_t HostSPI::transfer(uint8_t data)
+{
+    this->bytes++;
+    if (this->clock)
+    {
+        this->busTime += 8.0 / this->clock;
+        this->_device->elapse(8.0 / this->clock);
+    }
+
+    // MISO is pulled up while the device is not selected
+    if (!this->_selected)
+    {
+        return 0xFF;
+    }
+    this->selectedBytes++;
+    return this->_device->exchange(data);
+}
+
+bool HostSPI::transfer(const uint8_t *tx, uint8_t *rx, size_t length)
+{
+    return _block(tx, rx, length, 0xFF);
+}
+
+bool HostSPI::write(const uint8_t *tx, size_t length)
+{
+    return _block(tx, 0, length, 0xFF);
+}
+
+bool HostSPI::read(uint8_t *rx, size_t length, uint8_t fill)
+{
+    return _block(0, rx, length, fill);
+}
+
+/**** Block transfer: once bytes reaches lostByte, one received byte is
+ * dropped the way an RX overrun on the target does ****/
+bool HostSPI::_block(const uint8_t *tx, uint8_t *rx, size_t length, uint8_t fill)
+{
+    bool complete = true;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        uint8_t data = transfer(tx ? tx[i] : fill);
+        if (this->lostByte && (this->bytes >= this->lostByte))
+        {
+            this->lostByte = 0;
+            this->overruns++;
+            complete = false;
+            continue;
+        }
+        if (rx)
+        {
+            rx[i] = data;
+        }
+    }
+    return complete;
+}
+
+void HostSPI::initChipSelect(uint32_t port, uint32_t pin)
+{
+    this->_selected = false;
+}
+
+void HostSPI::select(uint32_t port, uint32_t pin)
+{
+    if (!this->_selected)
+    {
+        this->selects++;
+        this->_selected = true;
+        this->_device->select(true);
+    }
+}
+
+void HostSPI::deselect(uint32_t port, uint32_t pin)
+{
+    if (this->_selected)
+    {
+        this->_selected = false;
+        this->_device->select(false);
+    }
+}
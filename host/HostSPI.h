@@ -0,0 +1,83 @@
+/*
+ * HostSPI.h
+ *
+ *  Created on: 17 Oct 2026
+ *
+ *  SPIBus implementation for Linux builds: every byte is exchanged with an
+ *  in-process device model, so SDCard can run off-target with exact
+ *  traffic counts. Every byte advances the simulated time of the device by
+ *  8 clocks at the configured speed.
+ */
+
+#ifndef HOST_HOSTSPI_H_
+#define HOST_HOSTSPI_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "SPIBus.h"
+
+// Device model connected to the bus
+class SPIDevice
+{
+public:
+    virtual ~SPIDevice() {}
+
+    // Chip-select edge
+    virtual void select( bool selected ) = 0;
+
+    // One full byte on the bus: MOSI in, MISO out
+    virtual uint8_t exchange( uint8_t mosi ) = 0;
+
+    // Simulated time passed: a byte clocked at the bus speed, or idle time
+    virtual void elapse( double seconds ) {}
+};
+
+class HostSPI : public SPIBus
+{
+public:
+    HostSPI( SPIDevice *device );
+
+    virtual void initMaster( unsigned int speed );
+    virtual unsigned int maxFrequency( void );
+    virtual uint8_t transfer( uint8_t data );
+    virtual bool transfer( const uint8_t *tx, uint8_t *rx, size_t length );
+    virtual bool write( const uint8_t *tx, size_t length );
+    virtual bool read( uint8_t *rx, size_t length, uint8_t fill );
+
+    virtual void initChipSelect( uint32_t port, uint32_t pin );
+    virtual void select( uint32_t port, uint32_t pin );
+    virtual void deselect( uint32_t port, uint32_t pin );
+
+    void resetCounters( void );
+
+    // Let the device run for a while without clocks, e.g. host processing
+    void idle( double seconds );
+
+    // Simulated wall-clock time: bus activity plus idle time
+    double elapsed( void ) const
+    {
+        return this->busTime + this->idleTime;
+    }
+
+    /* traffic counters */
+    uint64_t bytes;             /*!< Bytes clocked on the bus */
+    uint64_t selectedBytes;     /*!< Bytes clocked with chip-select asserted */
+    uint32_t selects;           /*!< Chip-select assertions */
+    double busTime;             /*!< Seconds of SCK activity at the configured clock */
+    double idleTime;            /*!< Seconds passed through idle() */
+    unsigned int clock;         /*!< Current SCK frequency in Hz */
+    unsigned int maxClock;      /*!< Emulated bus limit in Hz, 0 for none */
+
+    /* fault injection */
+    uint64_t lostByte;          /*!< Once bytes reaches it, a block transfer loses a
+                                     received byte like an RX overrun; one-shot, 0 for none */
+    uint32_t overruns;          /*!< Received bytes lost through lostByte */
+
+private:
+    bool _block( const uint8_t *tx, uint8_t *rx, size_t length, uint8_t fill );
+
+    SPIDevice *_device;
+    bool _selected;
+};
+
+#endif /* HOST_HOSTSPI_H_ */
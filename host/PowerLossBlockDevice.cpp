@@ -0,0 +1,123 @@
+/*
+ * PowerLossBlockDevice.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "PowerLossBlockDevice.h"
+
+PowerLossBlockDevice::PowerLossBlockDevice(BlockDevice *bd)
+{
+    this->_bd = bd;
+    this->_powered = true;
+    this->_cut = 0;
+    resetCounters();
+}
+
+void PowerLossBlockDevice::cutAfter(uint32_t count)
+{
+    _cut = count;
+}
+
+void PowerLossBlockDevice::powerOn( void )
+{
+    _powered = true;
+    _cut = 0;
+    resetCounters();
+}
+
+void PowerLossBlockDevice::resetCounters( void )
+{
+    this->reads = 0;
+    this->programs = 0;
+    this->erases = 0;
+    this->readBytes = 0;
+}
+
+int PowerLossBlockDevice::init()
+{
+    return _powered ? _bd->init() : BD_ERROR_DEVICE_ERROR;
+}
+
+int PowerLossBlockDevice::deinit()
+{
+    return _powered ? _bd->deinit() : BD_ERROR_DEVICE_ERROR;
+}
+
+int PowerLossBlockDevice::read(void *buffer, uint64_t addr, uint64_t size)
+{
+    if (!_powered) {
+        return BD_ERROR_DEVICE_ERROR;
+    }
+    this->reads++;
+    this->readBytes += size;
+    return _bd->read(buffer, addr, size);
+}
+
+int PowerLossBlockDevice::program(const void *buffer, uint64_t addr, uint64_t size)
+{
+    if (!_powered) {
+        return BD_ERROR_DEVICE_ERROR;
+    }
+    this->programs++;
+    if (_cut && !--_cut) {
+        // torn program: the leading blocks made it
+        uint64_t blocks = size / get_program_size();
+        uint64_t written = (blocks / 2) * get_program_size();
+        if (written) {
+            _bd->program(buffer, addr, written);
+        }
+        _powered = false;
+        return BD_ERROR_DEVICE_ERROR;
+    }
+    return _bd->program(buffer, addr, size);
+}
+
+int PowerLossBlockDevice::erase(uint64_t addr, uint64_t size)
+{
+    if (!_powered) {
+        return BD_ERROR_DEVICE_ERROR;
+    }
+    this->erases++;
+    return _bd->erase(addr, size);
+}
+
+int PowerLossBlockDevice::trim(uint64_t addr, uint64_t size)
+{
+    return _powered ? _bd->trim(addr, size) : BD_ERROR_DEVICE_ERROR;
+}
+
+int PowerLossBlockDevice::sync()
+{
+    return _powered ? _bd->sync() : BD_ERROR_DEVICE_ERROR;
+}
+
+bool PowerLossBlockDevice::is_busy()
+{
+    return _powered && _bd->is_busy();
+}
+
+uint64_t PowerLossBlockDevice::get_read_size() const
+{
+    return _bd->get_read_size();
+}
+
+uint64_t PowerLossBlockDevice::get_program_size() const
+{
+    return _bd->get_program_size();
+}
+
+uint64_t PowerLossBlockDevice::get_erase_size() const
+{
+    return _bd->get_erase_size();
+}
+
+uint64_t PowerLossBlockDevice::size() const
+{
+    return _bd->size();
+}
+
+const char *PowerLossBlockDevice::get_type() const
+{
+    return _bd->get_type();
+}
@@ -0,0 +1,63 @@
+/*
+ * PowerLossBlockDevice.h
+ *
+ *  Created on: 17 Oct 2026
+ *
+ *  BlockDevice wrapper that cuts the power during a chosen program call:
+ *  that program only lands partially (the leading half of its blocks) and
+ *  every later call fails until powerOn(). Counts the calls, so the cost
+ *  of mounting and recovering after the cut can be measured.
+ */
+
+#ifndef HOST_POWERLOSSBLOCKDEVICE_H_
+#define HOST_POWERLOSSBLOCKDEVICE_H_
+
+#include <stdint.h>
+#include "BlockDevice.h"
+
+class PowerLossBlockDevice : public BlockDevice
+{
+public:
+    PowerLossBlockDevice( BlockDevice *bd );
+
+    // Power fails during the program call number count from now, 0 never
+    void cutAfter( uint32_t count );
+
+    // Power is back: calls reach the device again, counters restart
+    void powerOn( void );
+
+    bool powered( void ) const
+    {
+        return _powered;
+    }
+
+    void resetCounters( void );
+
+    virtual int init();
+    virtual int deinit();
+    virtual int read(void *buffer, uint64_t addr, uint64_t size);
+    virtual int program(const void *buffer, uint64_t addr, uint64_t size);
+    virtual int erase(uint64_t addr, uint64_t size);
+    virtual int trim(uint64_t addr, uint64_t size);
+    virtual int sync();
+    virtual bool is_busy();
+
+    virtual uint64_t get_read_size() const;
+    virtual uint64_t get_program_size() const;
+    virtual uint64_t get_erase_size() const;
+    virtual uint64_t size() const;
+    virtual const char *get_type() const;
+
+    /* counters */
+    uint32_t reads;
+    uint32_t programs;
+    uint32_t erases;
+    uint64_t readBytes;
+
+private:
+    BlockDevice *_bd;
+    bool _powered;
+    uint32_t _cut;              /*!< Program calls left before the power fails, 0 never */
+};
+
+#endif /* HOST_POWERLOSSBLOCKDEVICE_H_ */
@@ -0,0 +1,603 @@
+/*
+ * SDCardModel.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "SDCardModel.h"
+#include "SDCRC.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+/* R1 bits, same as SDCard.h */
+#define MODEL_R1_IDLE_STATE         (1 << 0)
+#define MODEL_R1_ILLEGAL_COMMAND    (1 << 2)
+#define MODEL_R1_COM_CRC_ERROR      (1 << 3)
+#define MODEL_R1_ADDRESS_ERROR      (1 << 5)
+
+#define MODEL_DATA_ACCEPTED         (0xE5)
+#define MODEL_DATA_CRC_ERROR        (0xEB)
+#define MODEL_DATA_WRITE_ERROR      (0xED)
+#define MODEL_START_BLOCK           (0xFE)
+#define MODEL_START_BLK_MUL_WRITE   (0xFC)
+#define MODEL_STOP_TRAN             (0xFD)
+#define MODEL_ERROR_OUT_OF_RANGE    (0x08)
+
+#define MODEL_AU_SECTORS            ((16384u << (SD_MODEL_AU_SIZE - 1)) / SD_MODEL_BLOCK_SIZE)
+#define MODEL_PAGE_SIZE             4096
+
+// Inverse of SDCardInfo::bits(), for a register of size bytes
+static void set_bits(uint8_t *data, uint32_t size, int msb, int lsb, uint32_t value)
+{
+    for (int position = lsb; position <= msb; position++) {
+        uint32_t byte = size - 1 - (position >> 3);
+        uint32_t bit = position & 0x7;
+        if (value & (1u << (position - lsb))) {
+            data[byte] |= (1 << bit);
+        } else {
+            data[byte] &= ~(1 << bit);
+        }
+    }
+}
+
+SDCardModel::SDCardModel(uint32_t sectors, const char *imagePath)
+{
+    void *map = MAP_FAILED;
+    uint64_t units = ((uint64_t)sectors + SD_MODEL_SIZE_UNIT - 1) / SD_MODEL_SIZE_UNIT;
+
+    // the CSD only describes whole units, at least one
+    if (units == 0) {
+        units = 1;
+    } else if (units > UINT32_MAX / SD_MODEL_SIZE_UNIT) {
+        units = UINT32_MAX / SD_MODEL_SIZE_UNIT;
+    }
+    this->sectors = (uint32_t)(units * SD_MODEL_SIZE_UNIT);
+    _mapSize = (size_t)this->sectors * SD_MODEL_BLOCK_SIZE;
+    _fd = -1;
+    // pages are only allocated once written, so large cards cost little
+    if (imagePath) {
+        _fd = open(imagePath, O_RDWR | O_CREAT, 0644);
+        if ((_fd >= 0) && (ftruncate(_fd, _mapSize) == 0)) {
+            map = mmap(0, _mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+        }
+    } else {
+        map = mmap(0, _mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    }
+    this->image = (map == MAP_FAILED) ? 0 : (uint8_t *)map;
+
+    this->timing.ncr = SD_MODEL_NCR;
+    this->timing.nac = SD_MODEL_NAC;
+    this->timing.programBusy = SD_MODEL_PROGRAM_BUSY;
+    this->timing.eraseBusy = SD_MODEL_ERASE_BUSY;
+    this->timing.auPenalty = SD_MODEL_AU_PENALTY;
+    this->time = 0;
+
+    this->commands = 0;
+    this->blocksRead = 0;
+    this->blocksWritten = 0;
+    this->erases = 0;
+    this->crcErrors = 0;
+    this->writeErrors = 0;
+    this->rejectBlock = 0;
+    this->auChanges = 0;
+    this->busyTime = 0;
+    this->highSpeedSupported = true;
+    this->serial = SD_MODEL_SERIAL;
+    _powerUp();
+}
+
+SDCardModel::~SDCardModel()
+{
+    if (this->image) {
+        munmap(this->image, _mapSize);
+    }
+    if (_fd >= 0) {
+        close(_fd);
+    }
+}
+
+void SDCardModel::powerOff( void )
+{
+    _powered = false;
+}
+
+void SDCardModel::powerOn( void )
+{
+    _powerUp();
+}
+
+// Protocol state after power up, the content stays
+void SDCardModel::_powerUp( void )
+{
+    _powered = true;
+    _state = STATE_COMMAND;
+    _idle = true;
+    _appCmd = false;
+    _acmd41 = 0;
+    _multiple = false;
+    _address = 0;
+    _wellWritten = 0;
+    _eraseStart = 0;
+    _eraseEnd = 0;
+    _busy = 0;
+    _busyUntil = 0;
+    _accessPending = false;
+    _accessReady = 0;
+    _openAU = 0xFFFFFFFF;
+    _crcOn = false;
+    _highSpeed = false;
+    _cmdLength = 0;
+    _dataLength = 0;
+    _outHead = 0;
+    _outTail = 0;
+}
+
+void SDCardModel::elapse(double seconds)
+{
+    this->time += seconds;
+}
+
+void SDCardModel::select(bool selected)
+{
+    // a command is always sent in one chip-select window
+    _cmdLength = 0;
+}
+
+uint8_t SDCardModel::exchange(uint8_t mosi)
+{
+    uint8_t miso;
+
+    // an unpowered card leaves MISO pulled up
+    if (!_powered) {
+        return 0xFF;
+    }
+
+    // MISO: queued response bytes, then busy, then idle high. Read data
+    // follows once the access time since the command or last block passed
+    if ((_outHead == _outTail) && ((_state == STATE_READ_SINGLE) || (_state == STATE_READ_MULTIPLE))) {
+        if (!_accessPending) {
+            _accessPending = true;
+            _accessReady = this->time + this->timing.nac * 1e-6;
+        }
+        if (this->time >= _accessReady) {
+            _accessPending = false;
+            if (_address < this->sectors) {
+                _queue(MODEL_START_BLOCK);
+                _queueBlock(&this->image[(size_t)_address * SD_MODEL_BLOCK_SIZE], SD_MODEL_BLOCK_SIZE);
+                _address++;
+                this->blocksRead++;
+            } else {
+                _queue(MODEL_ERROR_OUT_OF_RANGE);
+            }
+            if (_state == STATE_READ_SINGLE) {
+                _state = STATE_COMMAND;
+            }
+        }
+    }
+    if (_outHead != _outTail) {
+        miso = _out[_outTail];
+        _outTail = (_outTail + 1) % SD_MODEL_QUEUE_SIZE;
+    } else if (_busy || (this->time < _busyUntil)) {
+        miso = 0x00;
+        if (_busy) {
+            _busy--;
+        }
+    } else {
+        miso = 0xFF;
+    }
+
+    // MOSI
+    switch (_state) {
+        case STATE_WRITE_DATA:
+            _dataBuffer[_dataLength++] = mosi;
+            if (_dataLength == sizeof(_dataBuffer)) {
+                uint16_t crc = ((uint16_t)_dataBuffer[SD_MODEL_BLOCK_SIZE] << 8) | _dataBuffer[SD_MODEL_BLOCK_SIZE + 1];
+                if (_crcOn && (SDCRC16(_dataBuffer, SD_MODEL_BLOCK_SIZE) != crc)) {
+                    this->crcErrors++;
+                    _queue(MODEL_DATA_CRC_ERROR);
+                } else if (this->rejectBlock && !--this->rejectBlock) {
+                    this->writeErrors++;
+                    _queue(MODEL_DATA_WRITE_ERROR);
+                } else if (_address < this->sectors) {
+                    double busy = this->timing.programBusy * 1e-6;
+                    memcpy(&this->image[(size_t)_address * SD_MODEL_BLOCK_SIZE], _dataBuffer, SD_MODEL_BLOCK_SIZE);
+                    this->blocksWritten++;
+                    if (_address / MODEL_AU_SECTORS != _openAU) {
+                        // the card closes its open AU and sets up another one
+                        _openAU = _address / MODEL_AU_SECTORS;
+                        this->auChanges++;
+                        busy += this->timing.auPenalty * 1e-6;
+                    }
+                    _wellWritten++;
+                    _queue(MODEL_DATA_ACCEPTED);
+                    _setBusy(busy);
+                } else {
+                    _queue(MODEL_DATA_WRITE_ERROR);
+                }
+                _address++;
+                _busy = 1;
+                _state = _multiple ? STATE_WRITE_TOKEN : STATE_COMMAND;
+            }
+            return miso;
+
+        case STATE_WRITE_TOKEN:
+            if ((!_multiple && (mosi == MODEL_START_BLOCK)) || (_multiple && (mosi == MODEL_START_BLK_MUL_WRITE))) {
+                _state = STATE_WRITE_DATA;
+                _dataLength = 0;
+                return miso;
+            }
+            if (_multiple && (mosi == MODEL_STOP_TRAN)) {
+                _state = STATE_COMMAND;
+                _busy = 1;
+                return miso;
+            }
+            break;      // be lenient: a command also terminates the write
+
+        default:
+            break;
+    }
+
+    // command parser
+    if (_cmdLength == 0) {
+        if ((mosi & 0xC0) != 0x40) {
+            return miso;
+        }
+    }
+    _cmdBuffer[_cmdLength++] = mosi;
+    if (_cmdLength == sizeof(_cmdBuffer)) {
+        uint32_t arg = ((uint32_t)_cmdBuffer[1] << 24) | ((uint32_t)_cmdBuffer[2] << 16) |
+                       ((uint32_t)_cmdBuffer[3] << 8) | _cmdBuffer[4];
+        uint8_t cmd = _cmdBuffer[0] & 0x3F;
+        _cmdLength = 0;
+        this->commands++;
+        // CMD0 and CMD8 always carry a checked CRC7, the rest after CMD59
+        if ((_crcOn || (cmd == 0) || (cmd == 8)) &&
+            (_cmdBuffer[5] != (uint8_t)((SDCRC7(_cmdBuffer, 5) << 1) | 1))) {
+            this->crcErrors++;
+            _queueR1(MODEL_R1_COM_CRC_ERROR);
+            return miso;
+        }
+        _command(cmd, arg);
+    }
+    return miso;
+}
+
+void SDCardModel::_command(uint8_t cmd, uint32_t arg)
+{
+    bool app = _appCmd;
+    _appCmd = false;
+
+    if (_state != STATE_READ_MULTIPLE || cmd != 12) {
+        _state = STATE_COMMAND;
+    }
+    _accessPending = false;
+
+    if (app) {
+        switch (cmd) {
+            case 41:
+                if (++_acmd41 >= SD_MODEL_ACMD41_COUNT) {
+                    _idle = false;
+                }
+                _queueR1(0);
+                return;
+            case 23:
+                _queueR1(0);
+                return;
+            case 22: {
+                uint8_t count[4] = {(uint8_t)(_wellWritten >> 24), (uint8_t)(_wellWritten >> 16),
+                                    (uint8_t)(_wellWritten >> 8), (uint8_t)_wellWritten};
+                _queueR1(0);
+                _queue(0xFF);
+                _queue(MODEL_START_BLOCK);
+                _queueBlock(count, sizeof(count));
+                return;
+            }
+            case 13: {
+                uint8_t ssr[64];
+                _buildSSR(ssr);
+                _queueR1(0);
+                _queue(0x00);       // R2 second byte
+                _queue(0xFF);
+                _queue(MODEL_START_BLOCK);
+                _queueBlock(ssr, sizeof(ssr));
+                return;
+            }
+            case 51: {
+                uint8_t scr[8];
+                _buildSCR(scr);
+                _queueR1(0);
+                _queue(0xFF);
+                _queue(MODEL_START_BLOCK);
+                _queueBlock(scr, sizeof(scr));
+                return;
+            }
+            default:
+                break;
+        }
+    }
+
+    switch (cmd) {
+        case 0:
+            _idle = true;
+            _highSpeed = false;
+            _acmd41 = 0;
+            _state = STATE_COMMAND;
+            _flush();
+            _queueR1(0);
+            break;
+
+        case 8:
+            _queueR1(0);
+            _queue(0x00);
+            _queue(0x00);
+            _queue((arg >> 8) & 0x0F);
+            _queue(arg & 0xFF);
+            break;
+
+        case 9: {
+            uint8_t csd[16];
+            _buildCSD(csd);
+            _queueR1(0);
+            _queue(0xFF);
+            _queue(MODEL_START_BLOCK);
+            _queueBlock(csd, sizeof(csd));
+            break;
+        }
+
+        case 6: {
+            // switch status: group 1 offers default and High-Speed
+            uint8_t status[64];
+            uint32_t function = arg & 0xF;
+            bool supported = (function == 0) || ((function == 1) && this->highSpeedSupported);
+            memset(status, 0, sizeof(status));
+            set_bits(status, 64, 511, 496, 100);                    // max current: 100mA
+            set_bits(status, 64, 415, 400, this->highSpeedSupported ? 0x8003 : 0x8001);
+            set_bits(status, 64, 379, 376, (function == 0xF) ? (_highSpeed ? 1 : 0) : (supported ? function : 0xF));
+            if ((arg & 0x80000000) && supported) {
+                _highSpeed = (function == 1);
+            }
+            _queueR1(0);
+            _queue(0xFF);
+            _queue(MODEL_START_BLOCK);
+            _queueBlock(status, sizeof(status));
+            break;
+        }
+
+        case 10: {
+            uint8_t cid[16];
+            _buildCID(cid);
+            _queueR1(0);
+            _queue(0xFF);
+            _queue(MODEL_START_BLOCK);
+            _queueBlock(cid, sizeof(cid));
+            break;
+        }
+
+        case 12:
+            // discard the block being streamed, stuff byte then R1b
+            _flush();
+            _state = STATE_COMMAND;
+            _queue(0xFF);
+            _queue(_r1());
+            _busy = 1;
+            break;
+
+        case 13:
+            _queueR1(0);
+            _queue(0x00);
+            break;
+
+        case 16:
+            _queueR1(0);
+            break;
+
+        case 59:
+            _crcOn = arg & 1;
+            _queueR1(0);
+            break;
+
+        case 17:
+            if (arg >= this->sectors) {
+                _queueR1(MODEL_R1_ADDRESS_ERROR);
+                break;
+            }
+            _queueR1(0);
+            _address = arg;
+            _state = STATE_READ_SINGLE;
+            break;
+
+        case 18:
+            if (arg >= this->sectors) {
+                _queueR1(MODEL_R1_ADDRESS_ERROR);
+                break;
+            }
+            _queueR1(0);
+            _address = arg;
+            _state = STATE_READ_MULTIPLE;
+            break;
+
+        case 24:
+        case 25:
+            if (arg >= this->sectors) {
+                _queueR1(MODEL_R1_ADDRESS_ERROR);
+                break;
+            }
+            _queueR1(0);
+            _address = arg;
+            _wellWritten = 0;
+            _multiple = (cmd == 25);
+            _state = STATE_WRITE_TOKEN;
+            break;
+
+        case 32:
+            _eraseStart = arg;
+            _queueR1(0);
+            break;
+
+        case 33:
+            _eraseEnd = arg;
+            _queueR1(0);
+            break;
+
+        case 38:
+            if ((_eraseStart > _eraseEnd) || (_eraseEnd >= this->sectors)) {
+                _queueR1(MODEL_R1_ADDRESS_ERROR);
+                break;
+            }
+            _zero(_eraseStart, (uint64_t)_eraseEnd - _eraseStart + 1);
+            this->erases++;
+            _queueR1(0);
+            _busy = 1;
+            _setBusy((_eraseEnd / MODEL_AU_SECTORS - _eraseStart / MODEL_AU_SECTORS + 1) *
+                     (this->timing.eraseBusy * 1e-6));
+            break;
+
+        case 55:
+            _appCmd = true;
+            _queueR1(0);
+            break;
+
+        case 58: {
+            uint32_t ocr = 0x40FF8000;          // CCS, 2.7-3.6V
+            if (!_idle) {
+                ocr |= 0x80000000;              // power up completed
+            }
+            _queueR1(0);
+            _queue(ocr >> 24);
+            _queue(ocr >> 16);
+            _queue(ocr >> 8);
+            _queue(ocr);
+            break;
+        }
+
+        default:
+            _queueR1(MODEL_R1_ILLEGAL_COMMAND);
+            break;
+    }
+}
+
+uint8_t SDCardModel::_r1( void ) const
+{
+    return _idle ? MODEL_R1_IDLE_STATE : 0x00;
+}
+
+// NCR, then R1
+void SDCardModel::_queueR1(uint8_t flags)
+{
+    uint32_t ncr = this->timing.ncr;
+    if (ncr < 1) {
+        ncr = 1;
+    } else if (ncr > 8) {
+        ncr = 8;
+    }
+    while (ncr--) {
+        _queue(0xFF);
+    }
+    _queue(_r1() | flags);
+}
+
+// Busy from now on, the card works during the response bytes already
+void SDCardModel::_setBusy(double seconds)
+{
+    _busyUntil = this->time + seconds;
+    this->busyTime += seconds;
+}
+
+// Erased content reads as zero. Whole pages are released, so erasing a
+// large range does not allocate it
+void SDCardModel::_zero(uint64_t sector, uint64_t count)
+{
+    size_t start = sector * SD_MODEL_BLOCK_SIZE;
+    size_t end = (sector + count) * SD_MODEL_BLOCK_SIZE;
+    size_t first = (start + MODEL_PAGE_SIZE - 1) & ~(size_t)(MODEL_PAGE_SIZE - 1);
+    size_t last = end & ~(size_t)(MODEL_PAGE_SIZE - 1);
+
+    if (first >= last) {
+        memset(&this->image[start], 0x00, end - start);
+        return;
+    }
+    memset(&this->image[start], 0x00, first - start);
+    memset(&this->image[last], 0x00, end - last);
+    if (_fd >= 0) {
+        if (fallocate(_fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, first, last - first) != 0) {
+            memset(&this->image[first], 0x00, last - first);
+        }
+    } else {
+        madvise(&this->image[first], last - first, MADV_DONTNEED);
+    }
+}
+
+void SDCardModel::_queue(uint8_t data)
+{
+    _out[_outHead] = data;
+    _outHead = (_outHead + 1) % SD_MODEL_QUEUE_SIZE;
+}
+
+// Data block followed by its CRC16, cards always send a valid one
+void SDCardModel::_queueBlock(const uint8_t *data, size_t length)
+{
+    uint16_t crc = SDCRC16(data, length);
+    for (size_t i = 0; i < length; i++) {
+        _queue(data[i]);
+    }
+    _queue(crc >> 8);
+    _queue(crc);
+}
+
+void SDCardModel::_flush( void )
+{
+    _outHead = 0;
+    _outTail = 0;
+}
+
+// CSD version 2.0 (SDHC / SDXC)
+void SDCardModel::_buildCSD(uint8_t *csd) const
+{
+    memset(csd, 0, 16);
+    set_bits(csd, 16, 127, 126, 1);                     // CSD_STRUCTURE
+    set_bits(csd, 16, 119, 112, 0x0E);                  // TAAC
+    set_bits(csd, 16, 103, 96, _highSpeed ? 0x5A : 0x32);   // TRAN_SPEED: 50 / 25MHz
+    set_bits(csd, 16, 95, 84, 0x5B5);                   // CCC
+    set_bits(csd, 16, 83, 80, 9);                       // READ_BL_LEN: 512
+    set_bits(csd, 16, 69, 48, this->sectors / SD_MODEL_SIZE_UNIT - 1);   // C_SIZE
+    set_bits(csd, 16, 46, 46, 1);                       // ERASE_BLK_EN
+    set_bits(csd, 16, 45, 39, 0x7F);                    // SECTOR_SIZE
+    set_bits(csd, 16, 28, 26, 2);                       // R2W_FACTOR
+    set_bits(csd, 16, 25, 22, 9);                       // WRITE_BL_LEN: 512
+    set_bits(csd, 16, 0, 0, 1);                         // always 1
+}
+
+void SDCardModel::_buildCID(uint8_t *cid) const
+{
+    memset(cid, 0, 16);
+    set_bits(cid, 16, 127, 120, 0x03);              // MID
+    memcpy(&cid[1], "SD", 2);                       // OID
+    memcpy(&cid[3], "MODEL", 5);                    // PNM
+    set_bits(cid, 16, 63, 56, 0x10);                // PRV: 1.0
+    set_bits(cid, 16, 55, 24, this->serial);        // PSN
+    set_bits(cid, 16, 19, 8, 0x14A);                // MDT: 2020-10
+    set_bits(cid, 16, 0, 0, 1);                     // always 1
+}
+
+void SDCardModel::_buildSCR(uint8_t *scr) const
+{
+    memset(scr, 0, 8);
+    set_bits(scr, 8, 59, 56, 2);                    // SD_SPEC: 2.00 / 3.0x
+    set_bits(scr, 8, 51, 48, 0x5);                  // SD_BUS_WIDTHS: 1 and 4 bit
+    set_bits(scr, 8, 47, 47, 1);                    // SD_SPEC3
+    set_bits(scr, 8, 33, 32, 0x2);                  // CMD_SUPPORT: CMD23
+}
+
+void SDCardModel::_buildSSR(uint8_t *ssr) const
+{
+    memset(ssr, 0, 64);
+    set_bits(ssr, 64, 447, 440, 4);                 // SPEED_CLASS: class 10
+    set_bits(ssr, 64, 439, 432, 10);                // PERFORMANCE_MOVE: 10MB/s
+    set_bits(ssr, 64, 431, 428, SD_MODEL_AU_SIZE);  // AU_SIZE
+    set_bits(ssr, 64, 423, 408, 8);                 // ERASE_SIZE: 8 AUs
+    set_bits(ssr, 64, 407, 402, 2);                 // ERASE_TIMEOUT: 2s
+    set_bits(ssr, 64, 401, 400, 1);                 // ERASE_OFFSET: 1s
+}
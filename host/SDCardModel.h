@@ -0,0 +1,141 @@
+/*
+ * SDCardModel.h
+ *
+ *  Created on: 17 Oct 2026
+ *
+ *  In-process model of an SDHC card in SPI mode. It parses the commands
+ *  byte by byte and answers with R1/R3/R7 responses, data tokens and busy
+ *  signalling, as seen on MISO. Data blocks carry their CRC16.
+ *  Command CRC7s and the CRC of written blocks are checked once CMD59
+ *  enables it, CMD0 and CMD8 are always checked.
+ *
+ *  The card runs on the simulated time HostSPI passes with every clocked
+ *  byte (elapse()): NCR is counted in bytes, the read access time, program
+ *  and erase busy and the penalty for opening another AU are times in
+ *  SDCardTiming, so the number of polls depends on the SPI clock like on
+ *  a real card. The content lives in a lazily allocated mapping, either
+ *  anonymous or a sparse image file.
+ */
+
+#ifndef HOST_SDCARDMODEL_H_
+#define HOST_SDCARDMODEL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "HostSPI.h"
+
+#define SD_MODEL_BLOCK_SIZE     512
+#define SD_MODEL_QUEUE_SIZE     1024        /*!< MISO bytes waiting to be clocked out */
+#define SD_MODEL_ACMD41_COUNT   2           /*!< ACMD41 calls before leaving the idle state */
+#define SD_MODEL_AU_SIZE        5           /*!< SD Status AU_SIZE code: 256 KiB */
+#define SD_MODEL_SERIAL         0x12345678  /*!< CID PSN */
+#define SD_MODEL_SIZE_UNIT      1024        /*!< Sectors per CSD 2.0 C_SIZE unit: 512 KiB */
+
+/* Default timing */
+#define SD_MODEL_NCR            1           /*!< Bytes before R1, 1 to 8 */
+#define SD_MODEL_NAC            100         /*!< us, command or previous block to data token */
+#define SD_MODEL_PROGRAM_BUSY   250         /*!< us, busy after each written block */
+#define SD_MODEL_ERASE_BUSY     2000        /*!< us, CMD38 busy per AU in the range */
+#define SD_MODEL_AU_PENALTY     1500        /*!< us, extra busy when a write moves to another AU */
+
+typedef struct SDCardTiming
+{
+    uint32_t ncr;               /*!< Bytes between a command and its R1 */
+    uint32_t nac;               /*!< us before a data token */
+    uint32_t programBusy;       /*!< us of busy after a written block */
+    uint32_t eraseBusy;         /*!< us of CMD38 busy per AU */
+    uint32_t auPenalty;         /*!< us added to the program busy of the first block written in another AU */
+} SDCardTiming;
+
+class SDCardModel : public SPIDevice
+{
+public:
+    /* sectors: rounded up to whole SD_MODEL_SIZE_UNIT, the granularity of
+     * the capacity in the CSD; imagePath: sparse image file created or
+     * reused as card content, 0 for an anonymous mapping that is lost
+     * with the model */
+    SDCardModel( uint32_t sectors, const char *imagePath = 0 );
+    virtual ~SDCardModel();
+
+    virtual void select( bool selected );
+    virtual uint8_t exchange( uint8_t mosi );
+    virtual void elapse( double seconds );
+
+    /* Power loss: while off the card ignores the bus, on power up it is in
+     * the idle state again with the content it had programmed */
+    void powerOff( void );
+    void powerOn( void );
+
+    uint8_t *image;             /*!< Card content: sectors * 512 bytes, 0 if the mapping failed */
+    uint32_t sectors;
+    bool highSpeedSupported;    /*!< CMD6 offers High-Speed in group 1 */
+    uint32_t serial;            /*!< Product serial number in the CID */
+    SDCardTiming timing;
+    uint32_t rejectBlock;       /*!< Written blocks until one gets a write error, 1 the next, 0 never */
+    double time;                /*!< Simulated seconds since power up */
+
+    /* counters */
+    uint32_t commands;
+    uint32_t blocksRead;
+    uint32_t blocksWritten;
+    uint32_t erases;
+    uint32_t crcErrors;         /*!< Commands and written blocks rejected on their CRC */
+    uint32_t writeErrors;       /*!< Blocks rejected through rejectBlock */
+    uint32_t auChanges;         /*!< Writes that paid the AU penalty */
+    double busyTime;            /*!< Seconds the card signalled busy */
+
+protected:
+    enum State
+    {
+        STATE_COMMAND,          /*!< Waiting for a command */
+        STATE_WRITE_TOKEN,      /*!< CMD24 / CMD25: waiting for a data token */
+        STATE_WRITE_DATA,       /*!< Receiving a data block */
+        STATE_READ_SINGLE,      /*!< CMD17: one block after NAC */
+        STATE_READ_MULTIPLE     /*!< CMD18: streaming blocks until CMD12 */
+    };
+
+    virtual void _command( uint8_t cmd, uint32_t arg );
+    void _powerUp( void );
+    void _queue( uint8_t data );
+    void _queueBlock( const uint8_t *data, size_t length );
+    void _queueR1( uint8_t flags );
+    uint8_t _r1( void ) const;
+    void _flush( void );
+    void _setBusy( double seconds );
+    void _zero( uint64_t sector, uint64_t count );
+    void _buildCSD( uint8_t *csd ) const;
+    void _buildCID( uint8_t *cid ) const;
+    void _buildSCR( uint8_t *scr ) const;
+    void _buildSSR( uint8_t *ssr ) const;
+
+    State _state;
+    bool _powered;
+    bool _idle;
+    bool _appCmd;
+    uint32_t _acmd41;
+    bool _multiple;
+    uint32_t _address;
+    uint32_t _wellWritten;      /*!< ACMD22: blocks of the last write command programmed */
+    uint32_t _eraseStart;
+    uint32_t _eraseEnd;
+    uint32_t _busy;             /*!< Busy (0x00) bytes still to be clocked out, at least */
+    double _busyUntil;          /*!< Card busy until this time */
+    bool _accessPending;        /*!< Read block waiting for NAC */
+    double _accessReady;        /*!< Data token allowed from this time */
+    uint32_t _openAU;           /*!< AU of the last written block */
+    int _fd;                    /*!< Image file, -1 for an anonymous mapping */
+    size_t _mapSize;
+    bool _crcOn;                /*!< CMD59: written data blocks are checked */
+    bool _highSpeed;            /*!< CMD6 switched to High-Speed */
+
+    uint8_t _cmdBuffer[6];
+    size_t _cmdLength;
+    uint8_t _dataBuffer[SD_MODEL_BLOCK_SIZE + 2];
+    size_t _dataLength;
+
+    uint8_t _out[SD_MODEL_QUEUE_SIZE];
+    size_t _outHead;
+    size_t _outTail;
+};
+
+#endif /* HOST_SDCARDMODEL_H_ */
@@ -0,0 +1,90 @@
+/*
+ * SDTraceDecoder.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "SDTraceDecoder.h"
+#include <string.h>
+
+#define SD_TRACE_OPERATIONS 6
+
+static const char *phaseNames[SD_TRACE_PHASES] = {
+    "command", "response", "busy", "token", "data", "crc", "filler"
+};
+
+static const char *operationNames[SD_TRACE_OPERATIONS] = {
+    "none", "init", "read", "program", "trim", "sync"
+};
+
+static const char *operationName(uint32_t operation)
+{
+    return (operation < SD_TRACE_OPERATIONS) ? operationNames[operation] : "?";
+}
+
+static void printPhases(const uint32_t *bytes, const uint32_t *time, FILE *out)
+{
+    uint64_t totalBytes = 0, totalTime = 0;
+
+    for (int p = 0; p < SD_TRACE_PHASES; p++) {
+        totalBytes += bytes[p];
+        totalTime += time[p];
+    }
+    for (int p = 0; p < SD_TRACE_PHASES; p++) {
+        if (!bytes[p] && !time[p]) {
+            continue;
+        }
+        fprintf(out, "    %-9s %10u bytes %5.1f%%  %10u ticks %5.1f%%\n", phaseNames[p],
+                bytes[p], totalBytes ? 100.0 * bytes[p] / totalBytes : 0.0,
+                time[p], totalTime ? 100.0 * time[p] / totalTime : 0.0);
+    }
+}
+
+void SDTraceDecoder_print(const SDTraceRecord *records, uint32_t recordCount, FILE *out)
+{
+    uint32_t first = (recordCount > SD_TRACE_RECORDS) ? recordCount - SD_TRACE_RECORDS : 0;
+    uint32_t count[SD_TRACE_OPERATIONS];
+    uint32_t bytes[SD_TRACE_OPERATIONS][SD_TRACE_PHASES];
+    uint32_t time[SD_TRACE_OPERATIONS][SD_TRACE_PHASES];
+
+    memset(count, 0, sizeof(count));
+    memset(bytes, 0, sizeof(bytes));
+    memset(time, 0, sizeof(time));
+
+    for (uint32_t i = first; i < recordCount; i++) {
+        const SDTraceRecord *r = &records[i % SD_TRACE_RECORDS];
+        uint32_t op = (r->operation < SD_TRACE_OPERATIONS) ? r->operation : SD_TRACE_OP_NONE;
+
+        fprintf(out, "#%u %s @0x%08x: %u ticks\n", i, operationName(r->operation),
+                r->address, r->end - r->start);
+        printPhases(r->bytes, r->time, out);
+
+        count[op]++;
+        for (int p = 0; p < SD_TRACE_PHASES; p++) {
+            bytes[op][p] += r->bytes[p];
+            time[op][p] += r->time[p];
+        }
+    }
+
+    fprintf(out, "\nSummary (%u of %u operations)\n", recordCount - first, recordCount);
+    for (int op = 0; op < SD_TRACE_OPERATIONS; op++) {
+        if (!count[op]) {
+            continue;
+        }
+        fprintf(out, "  %s x%u\n", operationNames[op], count[op]);
+        printPhases(bytes[op], time[op], out);
+    }
+}
+
+int SDTraceDecoder_printDump(FILE *dump, FILE *out)
+{
+    static SDTraceRecord records[SD_TRACE_RECORDS];
+    uint32_t recordCount;
+
+    if ((fread(records, sizeof(records), 1, dump) != 1) ||
+        (fread(&recordCount, sizeof(recordCount), 1, dump) != 1)) {
+        return -1;
+    }
+    SDTraceDecoder_print(records, recordCount, out);
+    return 0;
+}
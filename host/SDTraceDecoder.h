@@ -0,0 +1,25 @@
+/*
+ * SDTraceDecoder.h
+ *
+ *  Created on: 17 Oct 2026
+ *
+ *  Host side decoder for the SDTrace ring: prints every recorded operation
+ *  with its per-phase bytes and time, followed by a summary per operation
+ *  type showing which phase dominates.
+ */
+
+#ifndef HOST_SDTRACEDECODER_H_
+#define HOST_SDTRACEDECODER_H_
+
+#include <stdio.h>
+#include "SDTrace.h"
+
+// Decode records taken from an SDTrace instance (host builds)
+void SDTraceDecoder_print(const SDTraceRecord *records, uint32_t recordCount, FILE *out);
+
+// Decode a raw target dump of SDTrace::records followed by SDTrace::recordCount
+// (sizeof(SDTrace::records) + 4 bytes starting at &records), returns -1 when
+// the dump is truncated
+int SDTraceDecoder_printDump(FILE *dump, FILE *out);
+
+#endif /* HOST_SDTRACEDECODER_H_ */
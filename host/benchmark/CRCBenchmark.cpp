@@ -0,0 +1,194 @@
+/*
+ * CRCBenchmark.cpp
+ *
+ *  Created on: 17 Oct 2026
+ *
+ *  Compares the lfs_crc kernels: the nibble table (LFS_CRC_SLICES 1),
+ *  slice-by-4, slice-by-8 and, on the MSP432, the CRC32 module
+ *  (LFS_CRC_HW). The kernel is a compile-time choice, so lfs_util.cpp is
+ *  built once per kernel with lfs_crc renamed and all of them are linked
+ *  into this tool. Every kernel is first checked against a bitwise CRC-32
+ *  on random buffers, offsets and seeds, then timed on the call sizes
+ *  littlefs uses: 1 byte (the per-byte loops over on-disk data), 4 (tags),
+ *  the 512 byte cache and a large buffer. JSON on stdout.
+ *
+ *  Build from the repository root:
+ *
+ *      for k in 1 4 8; do
+ *          g++ -O2 -Wall -c -DLFS_CRC_SLICES=$k -Dlfs_crc=lfs_crc_$k \
+ *              littlefs/lfs_util.cpp -o lfs_crc_$k.o
+ *      done
+ *      g++ -O2 -Wall -Ilittlefs host/benchmark/CRCBenchmark.cpp \
+ *          lfs_crc_1.o lfs_crc_4.o lfs_crc_8.o -o crcbench
+ *
+ *      ./crcbench [--bytes n] [--seed n]
+ *
+ *  The CRC32 module only exists on the target: build this file for the
+ *  MSP432 with -DCRC_BENCH_HW, add lfs_util.cpp compiled with
+ *  -DLFS_CRC_HW -Dlfs_crc=lfs_crc_hw, and define CRC_BENCH_NOW() to a
+ *  seconds timer of the application.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Kernels, lfs_crc of lfs_util.cpp built with each setting */
+uint32_t lfs_crc_1(uint32_t crc, const void *buffer, size_t size);
+uint32_t lfs_crc_4(uint32_t crc, const void *buffer, size_t size);
+uint32_t lfs_crc_8(uint32_t crc, const void *buffer, size_t size);
+#if defined(CRC_BENCH_HW)
+uint32_t lfs_crc_hw(uint32_t crc, const void *buffer, size_t size);
+#endif
+
+#define CRC_BENCH_CHECKS        20000       /*!< Random buffers per kernel check */
+#define CRC_BENCH_MAX_CHECK     300         /*!< Largest checked buffer */
+#define CRC_BENCH_LARGE         65536       /*!< Large buffer timing */
+
+typedef struct
+{
+    const char *name;
+    uint32_t (*crc)(uint32_t crc, const void *buffer, size_t size);
+} Kernel;
+
+static const Kernel kernels[] = {
+    { "nibble", lfs_crc_1 },
+    { "slice4", lfs_crc_4 },
+    { "slice8", lfs_crc_8 },
+#if defined(CRC_BENCH_HW)
+    { "hw", lfs_crc_hw },
+#endif
+};
+
+static const size_t sizes[] = { 1, 4, 512, CRC_BENCH_LARGE };
+
+#ifndef CRC_BENCH_NOW
+#define CRC_BENCH_NOW()         host_seconds()
+
+static double host_seconds(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+#endif
+
+static uint32_t rnd(uint32_t *seed)
+{
+    // xorshift32
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 17;
+    *seed ^= *seed << 5;
+    return *seed;
+}
+
+/* Bitwise reference: reflected polynomial 0xedb88320, no final xor, as lfs_crc */
+static uint32_t crc_reference(uint32_t crc, const uint8_t *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320 : 0);
+        }
+    }
+    return crc;
+}
+
+/* Random offsets (alignment), lengths and seeds, returns the mismatches */
+static unsigned crc_check(const Kernel *k, uint8_t *buffer, uint32_t seed)
+{
+    unsigned mismatches = 0;
+
+    for (unsigned i = 0; i < CRC_BENCH_CHECKS; i++) {
+        size_t offset = rnd(&seed) % 8;
+        size_t size = rnd(&seed) % CRC_BENCH_MAX_CHECK;
+        uint32_t start = (i & 1) ? rnd(&seed) : 0xffffffff;
+
+        for (size_t j = 0; j < size; j++) {
+            buffer[offset + j] = (uint8_t)rnd(&seed);
+        }
+        if (k->crc(start, buffer + offset, size) != crc_reference(start, buffer + offset, size)) {
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+/* Calls of size bytes until total bytes are covered, repeated until the
+ * run takes long enough for the timer */
+static double crc_time(const Kernel *k, const uint8_t *buffer, size_t size, size_t total,
+                       uint32_t *crc)
+{
+    size_t calls = (total + size - 1) / size;
+    unsigned rounds = 0;
+    double start = CRC_BENCH_NOW();
+    double elapsed;
+
+    do {
+        for (size_t i = 0; i < calls; i++) {
+            *crc = k->crc(*crc, buffer + (i * size) % CRC_BENCH_LARGE, size);
+        }
+        rounds++;
+        elapsed = CRC_BENCH_NOW() - start;
+    } while (elapsed < 0.1);
+    return elapsed / rounds;
+}
+
+int main(int argc, char **argv)
+{
+    size_t total = 1 << 20;
+    uint32_t seed = 1;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--bytes")) {
+            total = strtoul(argv[i + 1], 0, 0);
+        } else if (!strcmp(argv[i], "--seed")) {
+            seed = strtoul(argv[i + 1], 0, 0);
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (!seed) {
+        seed = 1;
+    }
+    if (!total) {
+        total = 1;
+    }
+
+    // room for the large size at any offset of the timing loop
+    uint8_t *buffer = (uint8_t *)malloc(2 * CRC_BENCH_LARGE);
+    uint32_t fill = seed;
+    for (size_t i = 0; i < 2 * CRC_BENCH_LARGE; i++) {
+        buffer[i] = (uint8_t)rnd(&fill);
+    }
+
+    int failed = 0;
+    printf("{\n  \"bytes\": %llu, \"seed\": %u,\n  \"kernels\": [", (unsigned long long)total, seed);
+    for (size_t n = 0; n < sizeof(kernels) / sizeof(kernels[0]); n++) {
+        const Kernel *k = &kernels[n];
+        uint8_t *check = (uint8_t *)malloc(CRC_BENCH_MAX_CHECK + 8);
+        unsigned mismatches = crc_check(k, check, seed);
+        uint32_t crc = 0xffffffff;
+
+        free(check);
+        failed |= (mismatches != 0);
+        printf("%s\n    {\"name\": \"%s\", \"mismatches\": %u, \"sizes\": [",
+               n ? "," : "", k->name, mismatches);
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            double seconds = crc_time(k, buffer, sizes[s], total, &crc);
+            size_t calls = (total + sizes[s] - 1) / sizes[s];
+            printf("%s{\"size\": %u, \"bytes_per_s\": %.1f, \"ns_per_call\": %.2f}",
+                   s ? ", " : "", (unsigned)sizes[s], calls * sizes[s] / seconds,
+                   seconds * 1e9 / calls);
+        }
+        // keep the result alive
+        printf("], \"crc\": \"%08x\"}", (unsigned)crc);
+    }
+    printf("\n  ]\n}\n");
+    free(buffer);
+    return failed;
+}
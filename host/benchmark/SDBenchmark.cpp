@@ -0,0 +1,601 @@
+/*
+ * SDBenchmark.cpp
+ *
+ *  Created on: 17 Oct 2026
+ *
+ *  Storage benchmark: a fixed set of raw and littlefs workloads on the
+ *  simulated card (SDCard over HostSPI and SDCardModel) or on a
+ *  RAMBlockDevice, reported as JSON on stdout.
+ *
+ *  On the simulator the times are simulated wall-clock time
+ *  (HostSPI::elapsed()), so the results only depend on the code and the
+ *  model timing and can be compared across changes. On the RAM device
+ *  they are host time.
+ *
+ *  Build from the repository root (add -DSD_WRITE_CACHE_SECTORS=n or
+ *  -DSD_READAHEAD_SECTORS=n to measure the SDCard caches):
+ *
+ *      g++ -O2 -Wall -DLFS_NO_DEBUG -DLFS_NO_WARN -DLFS_NO_ERROR \
+ *          -I. -Ihost -Ilittlefs host/benchmark/SDBenchmark.cpp \
+ *          SDCard.cpp SDCardInfo.cpp SDCRC.cpp RAMBlockDevice.cpp \
+ *          littlefs/lfs.cpp littlefs/lfs_util.cpp host/FileBlockDevice.cpp \
+ *          host/HostSPI.cpp host/PowerLossBlockDevice.cpp host/SDCardModel.cpp \
+ *          host/SDTraceDecoder.cpp -o sdbench
+ *
+ *      ./sdbench [--backend sim|ram] [--sectors n] [--clock hz] [--seed n]
+ *                [--ops n] [--image path]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "SDCard.h"
+#include "RAMBlockDevice.h"
+#include "HostSPI.h"
+#include "SDCardModel.h"
+#include "lfs.h"
+
+/* Same geometry as LittleFS.h */
+#define BENCH_BLOCK_SIZE        512
+#define BENCH_CACHE_SIZE        512
+#define BENCH_LOOKAHEAD         8192
+#define BENCH_BLOCKCYCLES       -1
+
+#define BENCH_RAW_CHUNK         (32 * 1024)     /*!< Bytes per call in the sequential workloads */
+#define BENCH_RAW_SPAN          (4 * 1024 * 1024) /*!< Bytes covered by the raw workloads */
+#define BENCH_TRIM_SIZE         (4 * 1024)      /*!< Bytes per call in the trim workload */
+#define BENCH_RECORD_SIZE       64              /*!< Small files and log records */
+#define BENCH_LARGE_FILE        (1024 * 1024)
+#define BENCH_DIR_ENTRIES       64
+
+// Block device in front of the backend, counting the calls
+class CountingBlockDevice : public BlockDevice
+{
+public:
+    CountingBlockDevice( BlockDevice *bd )
+    {
+        this->_bd = bd;
+        reset();
+    }
+
+    void reset( void )
+    {
+        this->reads = 0;
+        this->programs = 0;
+        this->erases = 0;
+        this->trims = 0;
+        this->syncs = 0;
+        this->readBytes = 0;
+        this->programBytes = 0;
+    }
+
+    virtual int init()
+    {
+        return _bd->init();
+    }
+    virtual int deinit()
+    {
+        return _bd->deinit();
+    }
+    virtual int read(void *buffer, uint64_t addr, uint64_t size)
+    {
+        this->reads++;
+        this->readBytes += size;
+        return _bd->read(buffer, addr, size);
+    }
+    virtual int program(const void *buffer, uint64_t addr, uint64_t size)
+    {
+        this->programs++;
+        this->programBytes += size;
+        return _bd->program(buffer, addr, size);
+    }
+    virtual int erase(uint64_t addr, uint64_t size)
+    {
+        this->erases++;
+        return _bd->erase(addr, size);
+    }
+    virtual int trim(uint64_t addr, uint64_t size)
+    {
+        this->trims++;
+        return _bd->trim(addr, size);
+    }
+    virtual int sync()
+    {
+        this->syncs++;
+        return _bd->sync();
+    }
+    virtual bool is_busy()
+    {
+        return _bd->is_busy();
+    }
+    virtual uint64_t get_read_size() const
+    {
+        return _bd->get_read_size();
+    }
+    virtual uint64_t get_program_size() const
+    {
+        return _bd->get_program_size();
+    }
+    virtual uint64_t get_erase_size() const
+    {
+        return _bd->get_erase_size();
+    }
+    virtual uint64_t size() const
+    {
+        return _bd->size();
+    }
+    virtual const char *get_type() const
+    {
+        return _bd->get_type();
+    }
+
+    uint64_t reads;
+    uint64_t programs;
+    uint64_t erases;
+    uint64_t trims;
+    uint64_t syncs;
+    uint64_t readBytes;
+    uint64_t programBytes;
+
+private:
+    BlockDevice *_bd;
+};
+
+typedef struct Bench
+{
+    CountingBlockDevice *bd;
+    HostSPI *spi;               /*!< 0 on the RAM backend */
+    uint32_t seed;
+    uint32_t ops;               /*!< Operations per workload */
+    bool first;
+
+    // workload in progress
+    const char *name;
+    uint64_t count;
+    uint64_t bytes;
+    double startTime;
+    double startHost;
+    uint64_t startSpi;
+    int status;
+
+    // littlefs
+    lfs_t lfs;
+    struct lfs_config config;
+    uint8_t readBuffer[BENCH_CACHE_SIZE];
+    uint8_t progBuffer[BENCH_CACHE_SIZE];
+    uint8_t lookahead[BENCH_LOOKAHEAD];
+    uint8_t fileBuffer[BENCH_CACHE_SIZE];
+    struct lfs_file_config fileConfig;
+} Bench;
+
+static uint8_t data[BENCH_RAW_CHUNK];
+
+// xorshift32: the same sequence on every host
+static uint32_t bench_random(Bench *b)
+{
+    uint32_t x = b->seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    b->seed = x;
+    return x;
+}
+
+static double host_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double bench_time(Bench *b)
+{
+    return b->spi ? b->spi->elapsed() : host_seconds();
+}
+
+static void bench_begin(Bench *b, const char *name)
+{
+    b->name = name;
+    b->count = 0;
+    b->bytes = 0;
+    b->status = 0;
+    b->bd->reset();
+    b->startSpi = b->spi ? b->spi->bytes : 0;
+    b->startHost = host_seconds();
+    b->startTime = bench_time(b);
+}
+
+// first error of the workload
+static void bench_status(Bench *b, int err)
+{
+    if (err < 0 && !b->status) {
+        b->status = err;
+    }
+}
+
+static void bench_op(Bench *b, int err, uint64_t bytes)
+{
+    b->count++;
+    b->bytes += bytes;
+    bench_status(b, err);
+}
+
+static void bench_end(Bench *b)
+{
+    double seconds = bench_time(b) - b->startTime;
+    double host = host_seconds() - b->startHost;
+    uint64_t spiBytes = b->spi ? b->spi->bytes - b->startSpi : 0;
+
+    printf("%s\n    {\"name\": \"%s\", \"status\": %d, \"ops\": %llu, \"bytes\": %llu, "
+           "\"seconds\": %.6f, \"host_seconds\": %.6f, \"ops_per_s\": %.1f, \"bytes_per_s\": %.1f, ",
+           b->first ? "" : ",", b->name, b->status,
+           (unsigned long long)b->count, (unsigned long long)b->bytes, seconds, host,
+           seconds > 0 ? b->count / seconds : 0.0, seconds > 0 ? b->bytes / seconds : 0.0);
+    if (b->spi) {
+        printf("\"spi_bytes\": %llu, \"spi_bytes_per_byte\": %.3f, ",
+               (unsigned long long)spiBytes, b->bytes ? (double)spiBytes / b->bytes : 0.0);
+    }
+    printf("\"bd\": {\"read\": %llu, \"program\": %llu, \"erase\": %llu, \"trim\": %llu, "
+           "\"sync\": %llu, \"read_bytes\": %llu, \"program_bytes\": %llu}}",
+           (unsigned long long)b->bd->reads, (unsigned long long)b->bd->programs,
+           (unsigned long long)b->bd->erases, (unsigned long long)b->bd->trims,
+           (unsigned long long)b->bd->syncs, (unsigned long long)b->bd->readBytes,
+           (unsigned long long)b->bd->programBytes);
+    b->first = false;
+}
+
+////// Raw workloads //////
+
+static uint64_t raw_span(Bench *b)
+{
+    uint64_t span = BENCH_RAW_SPAN;
+    if (span > b->bd->size()) {
+        span = b->bd->size() - b->bd->size() % BENCH_RAW_CHUNK;
+    }
+    return span;
+}
+
+static void raw_sequential(Bench *b, bool write)
+{
+    uint64_t span = raw_span(b);
+
+    bench_begin(b, write ? "raw_seq_write" : "raw_seq_read");
+    for (uint64_t addr = 0; addr + BENCH_RAW_CHUNK <= span; addr += BENCH_RAW_CHUNK) {
+        int err = write ? b->bd->program(data, addr, BENCH_RAW_CHUNK) :
+                          b->bd->read(data, addr, BENCH_RAW_CHUNK);
+        bench_op(b, err, BENCH_RAW_CHUNK);
+    }
+    bench_status(b, b->bd->sync());
+    bench_end(b);
+}
+
+static void raw_random(Bench *b, bool write)
+{
+    uint64_t sectors = raw_span(b) / BENCH_BLOCK_SIZE;
+
+    bench_begin(b, write ? "raw_rand_write" : "raw_rand_read");
+    for (uint32_t i = 0; i < b->ops; i++) {
+        uint64_t addr = (bench_random(b) % sectors) * BENCH_BLOCK_SIZE;
+        int err = write ? b->bd->program(data, addr, BENCH_BLOCK_SIZE) :
+                          b->bd->read(data, addr, BENCH_BLOCK_SIZE);
+        bench_op(b, err, BENCH_BLOCK_SIZE);
+    }
+    bench_status(b, b->bd->sync());
+    bench_end(b);
+}
+
+// Random discards, the card erases them on sync()
+static void raw_trim(Bench *b)
+{
+    uint64_t units = raw_span(b) / BENCH_TRIM_SIZE;
+
+    bench_begin(b, "raw_trim");
+    for (uint32_t i = 0; i < b->ops; i++) {
+        uint64_t addr = (bench_random(b) % units) * BENCH_TRIM_SIZE;
+        bench_op(b, b->bd->trim(addr, BENCH_TRIM_SIZE), BENCH_TRIM_SIZE);
+    }
+    bench_status(b, b->bd->sync());
+    bench_end(b);
+}
+
+////// littlefs workloads //////
+
+static int lfs_bd_read(const struct lfs_config *c, lfs_block_t block,
+                       lfs_off_t off, void *buffer, lfs_size_t size)
+{
+    BlockDevice *bd = (BlockDevice *)c->context;
+    return bd->read(buffer, (uint64_t)block * c->block_size + off, size);
+}
+
+static int lfs_bd_prog(const struct lfs_config *c, lfs_block_t block,
+                       lfs_off_t off, const void *buffer, lfs_size_t size)
+{
+    BlockDevice *bd = (BlockDevice *)c->context;
+    return bd->program(buffer, (uint64_t)block * c->block_size + off, size);
+}
+
+static int lfs_bd_erase(const struct lfs_config *c, lfs_block_t block)
+{
+    BlockDevice *bd = (BlockDevice *)c->context;
+    return bd->erase((uint64_t)block * c->block_size, c->block_size);
+}
+
+static int lfs_bd_sync(const struct lfs_config *c)
+{
+    BlockDevice *bd = (BlockDevice *)c->context;
+    return bd->sync();
+}
+
+static void lfs_setup(Bench *b)
+{
+    memset(&b->config, 0, sizeof(b->config));
+    b->config.context = b->bd;
+    b->config.read = lfs_bd_read;
+    b->config.prog = lfs_bd_prog;
+    b->config.erase = lfs_bd_erase;
+    b->config.sync = lfs_bd_sync;
+    b->config.read_size = BENCH_BLOCK_SIZE;
+    b->config.prog_size = BENCH_BLOCK_SIZE;
+    b->config.block_size = BENCH_BLOCK_SIZE;
+    b->config.block_count = b->bd->size() / BENCH_BLOCK_SIZE;
+    b->config.block_cycles = BENCH_BLOCKCYCLES;
+    b->config.cache_size = BENCH_CACHE_SIZE;
+    b->config.lookahead_size = BENCH_LOOKAHEAD;
+    b->config.read_buffer = b->readBuffer;
+    b->config.prog_buffer = b->progBuffer;
+    b->config.lookahead_buffer = b->lookahead;
+
+    memset(&b->fileConfig, 0, sizeof(b->fileConfig));
+    b->fileConfig.buffer = b->fileBuffer;
+}
+
+// lfs_file_opencfg() only takes the config of a zeroed file
+static int file_open(Bench *b, lfs_file_t *file, const char *path, int flags)
+{
+    memset(file, 0, sizeof(*file));
+    return lfs_file_opencfg(&b->lfs, file, path, flags, &b->fileConfig);
+}
+
+static int file_write(Bench *b, const char *path, const void *buffer, lfs_size_t size)
+{
+    lfs_file_t file;
+    int err = file_open(b, &file, path, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC);
+    if (err) {
+        return err;
+    }
+    lfs_ssize_t res = lfs_file_write(&b->lfs, &file, buffer, size);
+    err = lfs_file_close(&b->lfs, &file);
+    return (res < 0) ? (int)res : err;
+}
+
+static void lfs_mount_workload(Bench *b)
+{
+    bench_begin(b, "lfs_mount");
+    for (uint32_t i = 0; i < b->ops; i++) {
+        int err = lfs_mount(&b->lfs, &b->config);
+        if (!err) {
+            err = lfs_unmount(&b->lfs);
+        }
+        bench_op(b, err, 0);
+    }
+    bench_end(b);
+}
+
+// every file: create and write, stat, remove
+static void lfs_small_files(Bench *b)
+{
+    char path[32];
+    struct lfs_info info;
+
+    bench_begin(b, "lfs_small_files");
+    for (uint32_t i = 0; i < b->ops; i++) {
+        snprintf(path, sizeof(path), "small%u", (unsigned)i);
+        bench_op(b, file_write(b, path, data, BENCH_RECORD_SIZE), BENCH_RECORD_SIZE);
+        bench_op(b, lfs_stat(&b->lfs, path, &info), 0);
+    }
+    for (uint32_t i = 0; i < b->ops; i++) {
+        snprintf(path, sizeof(path), "small%u", (unsigned)i);
+        bench_op(b, lfs_remove(&b->lfs, path), 0);
+    }
+    bench_status(b, b->bd->sync());
+    bench_end(b);
+}
+
+// data logger: one record per write, synced every time
+static void lfs_append_sync(Bench *b)
+{
+    lfs_file_t file;
+
+    bench_begin(b, "lfs_append_sync");
+    int err = file_open(b, &file, "log", LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND);
+    if (err) {
+        bench_op(b, err, 0);
+        bench_end(b);
+        return;
+    }
+    for (uint32_t i = 0; i < b->ops; i++) {
+        lfs_ssize_t res = lfs_file_write(&b->lfs, &file, data, BENCH_RECORD_SIZE);
+        err = (res < 0) ? (int)res : lfs_file_sync(&b->lfs, &file);
+        bench_op(b, err, BENCH_RECORD_SIZE);
+    }
+    bench_status(b, lfs_file_close(&b->lfs, &file));
+    lfs_remove(&b->lfs, "log");
+    bench_end(b);
+}
+
+static void lfs_large_read(Bench *b)
+{
+    lfs_file_t file;
+    int err = 0;
+
+    // not measured: the file to read
+    for (uint32_t offset = 0; !err && (offset < BENCH_LARGE_FILE); offset += BENCH_RAW_CHUNK) {
+        lfs_file_t out;
+        err = file_open(b, &out, "large", LFS_O_WRONLY | LFS_O_CREAT | (offset ? LFS_O_APPEND : LFS_O_TRUNC));
+        if (!err) {
+            lfs_ssize_t res = lfs_file_write(&b->lfs, &out, data, BENCH_RAW_CHUNK);
+            err = lfs_file_close(&b->lfs, &out);
+            if (res < 0) {
+                err = (int)res;
+            }
+        }
+    }
+    b->bd->sync();
+
+    bench_begin(b, "lfs_large_read");
+    if (!err) {
+        err = file_open(b, &file, "large", LFS_O_RDONLY);
+    }
+    if (err) {
+        bench_op(b, err, 0);
+        bench_end(b);
+        return;
+    }
+    for (;;) {
+        lfs_ssize_t res = lfs_file_read(&b->lfs, &file, data, BENCH_RAW_CHUNK);
+        if (res <= 0) {
+            bench_status(b, (int)res);
+            break;
+        }
+        bench_op(b, 0, res);
+    }
+    lfs_file_close(&b->lfs, &file);
+    bench_end(b);
+    lfs_remove(&b->lfs, "large");
+}
+
+static void lfs_dir_list(Bench *b)
+{
+    char path[32];
+    struct lfs_info info;
+    lfs_dir_t dir;
+    int err = lfs_mkdir(&b->lfs, "dir");
+
+    // not measured: the entries to list
+    for (uint32_t i = 0; !err && (i < BENCH_DIR_ENTRIES); i++) {
+        snprintf(path, sizeof(path), "dir/entry%u", (unsigned)i);
+        err = file_write(b, path, data, BENCH_RECORD_SIZE);
+    }
+    b->bd->sync();
+
+    bench_begin(b, "lfs_dir_list");
+    for (uint32_t i = 0; !err && (i < b->ops / BENCH_DIR_ENTRIES + 1); i++) {
+        err = lfs_dir_open(&b->lfs, &dir, "dir");
+        if (err) {
+            break;
+        }
+        for (;;) {
+            int res = lfs_dir_read(&b->lfs, &dir, &info);
+            if (res <= 0) {
+                err = res;
+                break;
+            }
+            bench_op(b, 0, 0);
+        }
+        lfs_dir_close(&b->lfs, &dir);
+    }
+    bench_status(b, err);
+    bench_end(b);
+}
+
+int main(int argc, char **argv)
+{
+    const char *backend = "sim";
+    const char *image = 0;
+    uint32_t sectors = 65536;
+    unsigned int clock = 25000000;
+    Bench *b = (Bench *)calloc(1, sizeof(Bench));
+
+    b->seed = 1;
+    b->ops = 256;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--backend")) {
+            backend = argv[i + 1];
+        } else if (!strcmp(argv[i], "--sectors")) {
+            sectors = strtoul(argv[i + 1], 0, 0);
+        } else if (!strcmp(argv[i], "--clock")) {
+            clock = strtoul(argv[i + 1], 0, 0);
+        } else if (!strcmp(argv[i], "--seed")) {
+            b->seed = strtoul(argv[i + 1], 0, 0);
+        } else if (!strcmp(argv[i], "--ops")) {
+            b->ops = strtoul(argv[i + 1], 0, 0);
+        } else if (!strcmp(argv[i], "--image")) {
+            image = argv[i + 1];
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (!b->seed) {
+        b->seed = 1;
+    }
+    uint32_t seed = b->seed;
+
+    SDCardModel *model = 0;
+    SDCard *sd = 0;
+    uint8_t *ram = 0;
+    BlockDevice *device;
+    if (!strcmp(backend, "ram")) {
+        ram = (uint8_t *)calloc(sectors, BENCH_BLOCK_SIZE);
+        device = new RAMBlockDevice(ram, (uint64_t)sectors * BENCH_BLOCK_SIZE);
+    } else {
+        model = new SDCardModel(sectors, image);
+        b->spi = new HostSPI(model);
+        b->spi->maxClock = clock;
+        sd = new SDCard(b->spi, 0, 0);
+        device = sd;
+    }
+    b->bd = new CountingBlockDevice(device);
+
+    int err = b->bd->init();
+    if (err) {
+        fprintf(stderr, "init failed: %d\n", err);
+        return 1;
+    }
+    for (uint32_t i = 0; i < sizeof(data); i++) {
+        data[i] = bench_random(b);
+    }
+
+    printf("{\n  \"backend\": \"%s\", \"type\": \"%s\", \"size\": %llu, \"seed\": %u, \"ops\": %u,",
+           backend, b->bd->get_type(), (unsigned long long)b->bd->size(), (unsigned)seed, (unsigned)b->ops);
+    if (b->spi) {
+        printf(" \"clock\": %u,", b->spi->clock);
+    }
+    printf("\n  \"workloads\": [");
+    b->first = true;
+
+    raw_sequential(b, true);
+    raw_sequential(b, false);
+    raw_random(b, true);
+    raw_random(b, false);
+    raw_trim(b);
+
+    lfs_setup(b);
+    err = lfs_format(&b->lfs, &b->config);
+    if (!err) {
+        lfs_mount_workload(b);
+        err = lfs_mount(&b->lfs, &b->config);
+    }
+    if (!err) {
+        lfs_small_files(b);
+        lfs_append_sync(b);
+        lfs_large_read(b);
+        lfs_dir_list(b);
+        lfs_unmount(&b->lfs);
+    } else {
+        fprintf(stderr, "littlefs failed: %d\n", err);
+    }
+    printf("\n  ]");
+    if (model) {
+        printf(",\n  \"card\": {\"commands\": %u, \"blocks_read\": %u, \"blocks_written\": %u, "
+               "\"erases\": %u, \"au_changes\": %u, \"busy_seconds\": %.6f}",
+               (unsigned)model->commands, (unsigned)model->blocksRead, (unsigned)model->blocksWritten,
+               (unsigned)model->erases, (unsigned)model->auChanges, model->busyTime);
+    }
+    printf("\n}\n");
+
+    b->bd->deinit();
+    return err ? 1 : 0;
+}
@@ -0,0 +1,783 @@
+/*
+ * SDPowerLoss.cpp
+ *
+ *  Created on: 17 Oct 2026
+ *
+ *  Power-loss harness for littlefs: every iteration formats a fresh device,
+ *  runs the same file workload and cuts the power at program call number
+ *  iteration * every (PowerLossBlockDevice). After power up it measures
+ *  what recovery costs and checks the file tree:
+ *
+ *  - lfs_mount_async (as LittleFS runs it, with the gstate scan): steps
+ *    and block reads
+ *  - lfs_mount: block reads and time
+ *  - the first write after mounting, which runs lfs_fs_forceconsistency
+ *    (gstate moves and the deorphan pass): block reads, programs and time
+ *  - every file holds one complete version, the one before or after the
+ *    operation the power cut interrupted, nothing else is in the tree
+ *
+ *  Iterations run on all cores. The summary is JSON on stdout, times are
+ *  simulated on the sim backend and host time on the RAM backend.
+ *
+ *  Build from the repository root:
+ *
+ *      g++ -O2 -pthread -Wall -DLFS_NO_DEBUG -DLFS_NO_WARN -DLFS_NO_ERROR \
+ *          -I. -Ihost -Ilittlefs host/powerloss/SDPowerLoss.cpp \
+ *          SDCard.cpp SDCardInfo.cpp SDCRC.cpp RAMBlockDevice.cpp \
+ *          littlefs/lfs.cpp littlefs/lfs_util.cpp host/FileBlockDevice.cpp \
+ *          host/HostSPI.cpp host/PowerLossBlockDevice.cpp host/SDCardModel.cpp \
+ *          host/SDTraceDecoder.cpp -o sdpowerloss
+ *
+ *      ./sdpowerloss [--backend ram|sim] [--iterations n] [--every n] [--ops n]
+ *                    [--jobs n] [--seed n] [--sectors n] [--detail 1]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include "SDCard.h"
+#include "RAMBlockDevice.h"
+#include "HostSPI.h"
+#include "SDCardModel.h"
+#include "PowerLossBlockDevice.h"
+#include "lfs.h"
+
+/* Same block and cache size as LittleFS.h, lookahead for the small volume */
+#define PL_BLOCK_SIZE           512
+#define PL_CACHE_SIZE           512
+#define PL_LOOKAHEAD            512
+#define PL_BLOCKCYCLES          -1
+
+#define PL_DIRS                 4
+#define PL_SLOTS                16          /*!< Files in the workload, spread over the directories */
+#define PL_TMP_DIRS             2           /*!< Directories the workload creates and removes */
+#define PL_RECORD_SIZE          32          /*!< Log record */
+#define PL_MAX_FILE             (16 + 1500)
+#define PL_NAME_SIZE            32
+
+typedef struct Options
+{
+    bool sim;
+    uint32_t iterations;
+    uint32_t every;
+    uint32_t ops;
+    uint32_t seed;
+    uint32_t sectors;
+} Options;
+
+typedef struct Result
+{
+    bool cut;                   /*!< The power cut hit the workload */
+    int mountAsyncErr;
+    uint32_t mountAsyncSteps;
+    uint32_t mountAsyncReads;
+    int mountErr;
+    uint32_t mountReads;
+    double mountSeconds;
+    int writeErr;
+    uint32_t writeReads;
+    uint32_t writePrograms;
+    double writeSeconds;
+    const char *failure;        /*!< First check that failed, 0 if recovered */
+    char path[PL_NAME_SIZE];
+} Result;
+
+/* Workload operations */
+enum Operation
+{
+    OP_NONE,
+    OP_WRITE,                   /*!< Replace a file with a new version */
+    OP_APPEND,                  /*!< One record to the log */
+    OP_REMOVE,
+    OP_RENAME,                  /*!< Move a file to a free slot in another directory: gstate move */
+    OP_MKDIR,                   /*!< Orphan until the parent is updated */
+    OP_RMDIR
+};
+
+// Expected content: committed state and the operation the cut may have
+// interrupted
+typedef struct Expected
+{
+    uint32_t version[PL_SLOTS]; /*!< 0: no file */
+    uint32_t records;
+    bool dirs[PL_TMP_DIRS];
+    Operation op;
+    int slot;
+    int target;                 /*!< OP_RENAME destination */
+    uint32_t newVersion;        /*!< OP_WRITE */
+} Expected;
+
+class Worker
+{
+public:
+    Worker( const Options *options );
+    ~Worker();
+
+    void run( uint32_t iteration, Result *result );
+
+private:
+    void _powerUp( bool fresh );
+    void _powerLoss( void );
+    double _time( void );
+    int _open( lfs_file_t *file, const char *path, int flags );
+    int _writeSlot( int slot, uint32_t version );
+    int _appendLog( uint32_t record );
+    void _workload( Expected *expected );
+    const char *_verify( const Expected *expected, char *path );
+    const char *_verifySlot( const Expected *expected, int slot, char *path, uint32_t *found );
+
+    const Options *_options;
+    uint8_t *_ram;
+    SDCardModel *_model;
+    HostSPI *_spi;
+    BlockDevice *_device;
+    PowerLossBlockDevice *_bd;
+
+    lfs_t _lfs;
+    struct lfs_config _config;
+    uint8_t _readBuffer[PL_CACHE_SIZE];
+    uint8_t _progBuffer[PL_CACHE_SIZE];
+    uint8_t _lookahead[PL_LOOKAHEAD];
+    uint8_t _fileBuffer[PL_CACHE_SIZE];
+    struct lfs_file_config _fileConfig;
+    uint8_t _data[PL_MAX_FILE];
+    uint8_t _check[PL_MAX_FILE];
+};
+
+static uint32_t pl_hash(uint32_t a, uint32_t b, uint32_t c)
+{
+    uint32_t h = 2166136261u;
+    h = (h ^ a) * 16777619u;
+    h = (h ^ b) * 16777619u;
+    h = (h ^ c) * 16777619u;
+    return h ^ (h >> 15);
+}
+
+static void slot_path(int slot, char *path)
+{
+    snprintf(path, PL_NAME_SIZE, "d%d/f%d", slot % PL_DIRS, slot);
+}
+
+// Version header, then bytes derived from the version, which stays the
+// same when the file is renamed
+static uint32_t file_content(uint32_t version, uint8_t *data)
+{
+    uint32_t length = 16 + pl_hash(version, 0, 0xFFFFFFFF) % (PL_MAX_FILE - 16);
+    memcpy(&data[0], &version, 4);
+    memcpy(&data[4], &length, 4);
+    for (uint32_t i = 8; i < length; i++) {
+        data[i] = pl_hash(version, 0, i);
+    }
+    return length;
+}
+
+// Versions a slot may hold after the cut
+static bool accepts(const Expected *expected, int slot, uint32_t version)
+{
+    if (version == expected->version[slot]) {
+        return true;
+    }
+    if (expected->slot == slot) {
+        switch (expected->op) {
+            case OP_WRITE:
+                return version == expected->newVersion;
+            case OP_REMOVE:
+            case OP_RENAME:
+                return version == 0;
+            default:
+                break;
+        }
+    }
+    if ((expected->op == OP_RENAME) && (expected->target == slot)) {
+        return version == expected->version[expected->slot];
+    }
+    return false;
+}
+
+static void record_content(uint32_t record, uint8_t *data)
+{
+    for (uint32_t i = 0; i < PL_RECORD_SIZE; i++) {
+        data[i] = pl_hash(PL_SLOTS, record, i);
+    }
+}
+
+static double host_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int lfs_bd_read(const struct lfs_config *c, lfs_block_t block,
+                       lfs_off_t off, void *buffer, lfs_size_t size)
+{
+    BlockDevice *bd = (BlockDevice *)c->context;
+    return bd->read(buffer, (uint64_t)block * c->block_size + off, size);
+}
+
+static int lfs_bd_prog(const struct lfs_config *c, lfs_block_t block,
+                       lfs_off_t off, const void *buffer, lfs_size_t size)
+{
+    BlockDevice *bd = (BlockDevice *)c->context;
+    return bd->program(buffer, (uint64_t)block * c->block_size + off, size);
+}
+
+static int lfs_bd_erase(const struct lfs_config *c, lfs_block_t block)
+{
+    BlockDevice *bd = (BlockDevice *)c->context;
+    return bd->erase((uint64_t)block * c->block_size, c->block_size);
+}
+
+static int lfs_bd_sync(const struct lfs_config *c)
+{
+    BlockDevice *bd = (BlockDevice *)c->context;
+    return bd->sync();
+}
+
+Worker::Worker(const Options *options)
+{
+    this->_options = options;
+    this->_ram = 0;
+    this->_model = 0;
+    this->_spi = 0;
+    this->_device = 0;
+    this->_bd = 0;
+    if (!options->sim) {
+        _ram = (uint8_t *)malloc((size_t)options->sectors * PL_BLOCK_SIZE);
+    }
+
+    memset(&_fileConfig, 0, sizeof(_fileConfig));
+    _fileConfig.buffer = _fileBuffer;
+}
+
+Worker::~Worker()
+{
+    delete _device;
+    delete _spi;
+    delete _model;
+    delete _bd;
+    free(_ram);
+}
+
+// fresh: a new, zeroed card, otherwise power returns on the same content
+void Worker::_powerUp(bool fresh)
+{
+    if (_options->sim) {
+        if (fresh) {
+            delete _device;
+            delete _spi;
+            delete _model;
+            _model = new SDCardModel(_options->sectors);
+            _spi = new HostSPI(_model);
+        } else {
+            _model->powerOn();
+        }
+        _device = new SDCard(_spi, 0, 0);
+    } else if (fresh) {
+        memset(_ram, 0, (size_t)_options->sectors * PL_BLOCK_SIZE);
+        delete _device;
+        _device = new RAMBlockDevice(_ram, (uint64_t)_options->sectors * PL_BLOCK_SIZE);
+    }
+
+    delete _bd;
+    _bd = new PowerLossBlockDevice(_device);
+    _bd->init();
+
+    memset(&_config, 0, sizeof(_config));
+    _config.context = _bd;
+    _config.read = lfs_bd_read;
+    _config.prog = lfs_bd_prog;
+    _config.erase = lfs_bd_erase;
+    _config.sync = lfs_bd_sync;
+    _config.read_size = PL_BLOCK_SIZE;
+    _config.prog_size = PL_BLOCK_SIZE;
+    _config.block_size = PL_BLOCK_SIZE;
+    _config.block_count = _bd->size() / PL_BLOCK_SIZE;
+    _config.block_cycles = PL_BLOCKCYCLES;
+    _config.cache_size = PL_CACHE_SIZE;
+    _config.lookahead_size = PL_LOOKAHEAD;
+    _config.read_buffer = _readBuffer;
+    _config.prog_buffer = _progBuffer;
+    _config.lookahead_buffer = _lookahead;
+}
+
+// Everything not on the medium is lost: the SDCard caches go with the card
+void Worker::_powerLoss( void )
+{
+    if (_options->sim) {
+        _model->powerOff();
+        delete _device;
+        _device = 0;
+    }
+}
+
+double Worker::_time( void )
+{
+    return _spi ? _spi->elapsed() : host_seconds();
+}
+
+// lfs_file_opencfg() only takes the config of a zeroed file
+int Worker::_open(lfs_file_t *file, const char *path, int flags)
+{
+    memset(file, 0, sizeof(*file));
+    return lfs_file_opencfg(&_lfs, file, path, flags, &_fileConfig);
+}
+
+int Worker::_writeSlot(int slot, uint32_t version)
+{
+    char path[PL_NAME_SIZE];
+    lfs_file_t file;
+
+    slot_path(slot, path);
+    uint32_t length = file_content(version, _data);
+    int err = _open(&file, path, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC);
+    if (err) {
+        return err;
+    }
+    lfs_ssize_t res = lfs_file_write(&_lfs, &file, _data, length);
+    err = lfs_file_close(&_lfs, &file);
+    return (res < 0) ? (int)res : err;
+}
+
+int Worker::_appendLog(uint32_t record)
+{
+    lfs_file_t file;
+
+    record_content(record, _data);
+    int err = _open(&file, "log", LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND);
+    if (err) {
+        return err;
+    }
+    lfs_ssize_t res = lfs_file_write(&_lfs, &file, _data, PL_RECORD_SIZE);
+    err = lfs_file_close(&_lfs, &file);
+    return (res < 0) ? (int)res : err;
+}
+
+// The same sequence in every iteration, only the cut moves
+void Worker::_workload(Expected *expected)
+{
+    char path[PL_NAME_SIZE];
+    char target[PL_NAME_SIZE];
+
+    for (uint32_t op = 0; op < _options->ops; op++) {
+        uint32_t r = pl_hash(_options->seed, op, 0);
+        int slot = (r >> 8) % PL_SLOTS;
+        int next = (slot + 1) % PL_SLOTS;
+        int choice = r % 100;
+        int err;
+
+        expected->slot = slot;
+        slot_path(slot, path);
+        if (choice < 20) {
+            expected->op = OP_APPEND;
+            err = _appendLog(expected->records);
+            if (!err) {
+                expected->records++;
+            }
+        } else if ((choice < 30) && expected->version[slot]) {
+            expected->op = OP_REMOVE;
+            err = lfs_remove(&_lfs, path);
+            if (!err) {
+                expected->version[slot] = 0;
+            }
+        } else if ((choice < 40) && expected->version[slot] && !expected->version[next]) {
+            // the next slot is in the next directory
+            expected->op = OP_RENAME;
+            expected->target = next;
+            slot_path(next, target);
+            err = lfs_rename(&_lfs, path, target);
+            if (!err) {
+                expected->version[next] = expected->version[slot];
+                expected->version[slot] = 0;
+            }
+        } else if (choice < 48) {
+            int d = slot % PL_TMP_DIRS;
+            expected->op = expected->dirs[d] ? OP_RMDIR : OP_MKDIR;
+            expected->slot = d;
+            snprintf(path, sizeof(path), "t%d", d);
+            err = expected->dirs[d] ? lfs_remove(&_lfs, path) : lfs_mkdir(&_lfs, path);
+            if (!err) {
+                expected->dirs[d] = !expected->dirs[d];
+            }
+        } else {
+            // the operation number: each version is unique
+            expected->op = OP_WRITE;
+            expected->newVersion = op + 1;
+            err = _writeSlot(slot, expected->newVersion);
+            if (!err) {
+                expected->version[slot] = expected->newVersion;
+            }
+        }
+        if (err) {
+            return;
+        }
+        expected->op = OP_NONE;
+    }
+}
+
+const char *Worker::_verifySlot(const Expected *expected, int slot, char *path, uint32_t *found)
+{
+    lfs_file_t file;
+    uint32_t version;
+
+    *found = 0;
+    slot_path(slot, path);
+    int err = _open(&file, path, LFS_O_RDONLY);
+    if (err == LFS_ERR_NOENT) {
+        return accepts(expected, slot, 0) ? 0 : "file lost";
+    }
+    if (err) {
+        return "open failed";
+    }
+    lfs_ssize_t length = lfs_file_read(&_lfs, &file, _check, sizeof(_check));
+    lfs_file_close(&_lfs, &file);
+    if (length < 0) {
+        return "read failed";
+    }
+    if (length == 0) {
+        // created by the interrupted open, the data never got committed
+        if ((expected->op == OP_WRITE) && (expected->slot == slot) && !expected->version[slot]) {
+            return 0;
+        }
+        return "empty file";
+    }
+    if (length < 8) {
+        return "short file";
+    }
+    memcpy(&version, _check, 4);
+    if (!accepts(expected, slot, version)) {
+        return "unexpected version";
+    }
+    if (((uint32_t)length != file_content(version, _data)) || memcmp(_check, _data, length)) {
+        return "corrupt content";
+    }
+    *found = version;
+    return 0;
+}
+
+const char *Worker::_verify(const Expected *expected, char *path)
+{
+    const char *failure;
+    lfs_file_t file;
+    lfs_dir_t dir;
+    struct lfs_info info;
+
+    uint32_t found[PL_SLOTS];
+    for (int slot = 0; slot < PL_SLOTS; slot++) {
+        failure = _verifySlot(expected, slot, path, &found[slot]);
+        if (failure) {
+            return failure;
+        }
+        for (int other = 0; found[slot] && (other < slot); other++) {
+            if (found[other] == found[slot]) {
+                return "file in two places";
+            }
+        }
+    }
+
+    // log: whole records, the committed ones plus the interrupted one
+    strcpy(path, "log");
+    int err = _open(&file, path, LFS_O_RDONLY);
+    if (err && (err != LFS_ERR_NOENT)) {
+        return "open failed";
+    }
+    uint32_t records = 0;
+    while (!err) {
+        lfs_ssize_t res = lfs_file_read(&_lfs, &file, _check, PL_RECORD_SIZE);
+        if (res == 0) {
+            break;
+        }
+        record_content(records, _data);
+        if ((res != PL_RECORD_SIZE) || memcmp(_check, _data, PL_RECORD_SIZE)) {
+            lfs_file_close(&_lfs, &file);
+            return "corrupt log";
+        }
+        records++;
+    }
+    if (!err) {
+        lfs_file_close(&_lfs, &file);
+    }
+    if ((records != expected->records) &&
+        !((expected->op == OP_APPEND) && (records == expected->records + 1))) {
+        return "log records lost";
+    }
+
+    for (int d = 0; d < PL_TMP_DIRS; d++) {
+        bool pending = ((expected->op == OP_MKDIR) || (expected->op == OP_RMDIR)) && (expected->slot == d);
+        snprintf(path, PL_NAME_SIZE, "t%d", d);
+        err = lfs_stat(&_lfs, path, &info);
+        if ((err && (err != LFS_ERR_NOENT)) || (!err && (info.type != LFS_TYPE_DIR))) {
+            return "stat failed";
+        }
+        if ((!err != expected->dirs[d]) && !pending) {
+            return "directory state";
+        }
+    }
+
+    // nothing in the tree but the workload files
+    for (int d = -1; d < PL_DIRS; d++) {
+        if (d < 0) {
+            strcpy(path, "/");
+        } else {
+            snprintf(path, PL_NAME_SIZE, "d%d", d);
+        }
+        memset(&dir, 0, sizeof(dir));
+        if (lfs_dir_open(&_lfs, &dir, path)) {
+            return "directory lost";
+        }
+        while (lfs_dir_read(&_lfs, &dir, &info) > 0) {
+            int slot;
+            if (!strcmp(info.name, ".") || !strcmp(info.name, "..")) {
+                continue;
+            }
+            if (d < 0) {
+                if (!strcmp(info.name, "log") || !strcmp(info.name, "after") ||
+                    ((info.type == LFS_TYPE_DIR) && (sscanf(info.name, "d%d", &slot) == 1) && (slot < PL_DIRS)) ||
+                    ((info.type == LFS_TYPE_DIR) && (sscanf(info.name, "t%d", &slot) == 1) && (slot < PL_TMP_DIRS))) {
+                    continue;
+                }
+            } else if ((sscanf(info.name, "f%d", &slot) == 1) && (slot < PL_SLOTS) && (slot % PL_DIRS == d)) {
+                continue;
+            }
+            lfs_dir_close(&_lfs, &dir);
+            return "unexpected entry";
+        }
+        lfs_dir_close(&_lfs, &dir);
+    }
+    return 0;
+}
+
+void Worker::run(uint32_t iteration, Result *result)
+{
+    Expected expected;
+    lfs_file_t file;
+    lfs_mdir_t dir;
+    lfs_block_t cycle;
+    uint8_t state;
+    double start;
+
+    memset(result, 0, sizeof(*result));
+    memset(&expected, 0, sizeof(expected));
+
+    // a formatted device with the directories, power stays on
+    _powerUp(true);
+    memset(&_lfs, 0, sizeof(_lfs));
+    int err = lfs_format(&_lfs, &_config);
+    if (!err) {
+        err = lfs_mount(&_lfs, &_config);
+    }
+    for (int d = 0; !err && (d < PL_DIRS); d++) {
+        char path[PL_NAME_SIZE];
+        snprintf(path, sizeof(path), "d%d", d);
+        err = lfs_mkdir(&_lfs, path);
+    }
+    if (!err) {
+        err = _bd->sync();
+    }
+    if (err) {
+        result->failure = "setup failed";
+        return;
+    }
+
+    _bd->cutAfter(iteration * _options->every);
+    _workload(&expected);
+    result->cut = !_bd->powered();
+    if (!result->cut) {
+        expected.op = OP_NONE;
+    }
+
+    // unclean shutdown, then power up on the same content
+    _powerLoss();
+    _powerUp(false);
+
+    memset(&_lfs, 0, sizeof(_lfs));
+    state = 0;
+    do {
+        result->mountAsyncErr = lfs_mount_async(&_lfs, &_config, &state, &dir, &cycle, true);
+        result->mountAsyncSteps++;
+    } while (!result->mountAsyncErr && (state != 3));
+    result->mountAsyncReads = _bd->reads;
+    if (!result->mountAsyncErr) {
+        lfs_unmount(&_lfs);
+    }
+
+    _bd->resetCounters();
+    memset(&_lfs, 0, sizeof(_lfs));
+    start = _time();
+    result->mountErr = lfs_mount(&_lfs, &_config);
+    result->mountSeconds = _time() - start;
+    result->mountReads = _bd->reads;
+    if (result->mountErr) {
+        result->failure = "mount failed";
+        return;
+    }
+
+    // first write: lfs_fs_forceconsistency repairs what the cut left
+    _bd->resetCounters();
+    start = _time();
+    record_content(0, _data);
+    result->writeErr = _open(&file, "after", LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC);
+    if (!result->writeErr) {
+        lfs_ssize_t res = lfs_file_write(&_lfs, &file, _data, PL_RECORD_SIZE);
+        result->writeErr = lfs_file_close(&_lfs, &file);
+        if (res < 0) {
+            result->writeErr = (int)res;
+        }
+    }
+    if (!result->writeErr) {
+        result->writeErr = _bd->sync();
+    }
+    result->writeSeconds = _time() - start;
+    result->writeReads = _bd->reads;
+    result->writePrograms = _bd->programs;
+    if (result->writeErr) {
+        result->failure = "first write failed";
+        return;
+    }
+
+    result->failure = _verify(&expected, result->path);
+    lfs_unmount(&_lfs);
+    _bd->deinit();
+}
+
+static void print_stat(const char *name, std::vector<double> values, bool last)
+{
+    double sum = 0;
+
+    std::sort(values.begin(), values.end());
+    for (size_t i = 0; i < values.size(); i++) {
+        sum += values[i];
+    }
+    if (values.empty()) {
+        values.push_back(0);
+    }
+    printf("    \"%s\": {\"min\": %.6g, \"mean\": %.6g, \"p50\": %.6g, \"p99\": %.6g, \"max\": %.6g}%s\n",
+           name, values[0], sum / values.size(), values[values.size() / 2],
+           values[(values.size() * 99) / 100], values[values.size() - 1], last ? "" : ",");
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    uint32_t jobs = std::thread::hardware_concurrency();
+    bool detail = false;
+
+    options.sim = false;
+    options.iterations = 1000;
+    options.every = 1;
+    options.ops = 200;
+    options.seed = 1;
+    options.sectors = 2048;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--backend")) {
+            options.sim = !strcmp(argv[i + 1], "sim");
+        } else if (!strcmp(argv[i], "--iterations")) {
+            options.iterations = strtoul(argv[i + 1], 0, 0);
+        } else if (!strcmp(argv[i], "--every")) {
+            options.every = strtoul(argv[i + 1], 0, 0);
+        } else if (!strcmp(argv[i], "--ops")) {
+            options.ops = strtoul(argv[i + 1], 0, 0);
+        } else if (!strcmp(argv[i], "--jobs")) {
+            jobs = strtoul(argv[i + 1], 0, 0);
+        } else if (!strcmp(argv[i], "--seed")) {
+            options.seed = strtoul(argv[i + 1], 0, 0);
+        } else if (!strcmp(argv[i], "--sectors")) {
+            options.sectors = strtoul(argv[i + 1], 0, 0);
+        } else if (!strcmp(argv[i], "--detail")) {
+            detail = strtoul(argv[i + 1], 0, 0);
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (!jobs) {
+        jobs = 1;
+    }
+    if (!options.every) {
+        options.every = 1;
+    }
+
+    // iteration n cuts at program n * every
+    std::vector<Result> results(options.iterations);
+    std::atomic<uint32_t> next(0);
+    std::vector<std::thread> threads;
+    for (uint32_t j = 0; j < jobs; j++) {
+        threads.push_back(std::thread([&]() {
+            Worker worker(&options);
+            for (uint32_t i = next++; i < options.iterations; i = next++) {
+                worker.run(i + 1, &results[i]);
+            }
+        }));
+    }
+    for (size_t j = 0; j < threads.size(); j++) {
+        threads[j].join();
+    }
+
+    std::vector<double> mountReads, mountAsyncReads, mountAsyncSteps, mountSeconds;
+    std::vector<double> writeReads, writePrograms, writeSeconds;
+    uint32_t cuts = 0;
+    uint32_t failures = 0;
+    for (uint32_t i = 0; i < options.iterations; i++) {
+        const Result *r = &results[i];
+        cuts += r->cut;
+        failures += (r->failure != 0);
+        if (!r->cut) {
+            continue;
+        }
+        mountAsyncSteps.push_back(r->mountAsyncSteps);
+        mountAsyncReads.push_back(r->mountAsyncReads);
+        if (!r->mountErr) {
+            mountReads.push_back(r->mountReads);
+            mountSeconds.push_back(r->mountSeconds);
+        }
+        if (!r->mountErr && !r->writeErr) {
+            writeReads.push_back(r->writeReads);
+            writePrograms.push_back(r->writePrograms);
+            writeSeconds.push_back(r->writeSeconds);
+        }
+    }
+
+    printf("{\n  \"backend\": \"%s\", \"iterations\": %u, \"every\": %u, \"ops\": %u, \"seed\": %u, "
+           "\"sectors\": %u, \"jobs\": %u,\n",
+           options.sim ? "sim" : "ram", (unsigned)options.iterations, (unsigned)options.every,
+           (unsigned)options.ops, (unsigned)options.seed, (unsigned)options.sectors, (unsigned)jobs);
+    printf("  \"cuts\": %u, \"failures\": %u,\n", (unsigned)cuts, (unsigned)failures);
+    printf("  \"recovery\": {\n");
+    print_stat("mount_async_steps", mountAsyncSteps, false);
+    print_stat("mount_async_reads", mountAsyncReads, false);
+    print_stat("mount_reads", mountReads, false);
+    print_stat("mount_seconds", mountSeconds, false);
+    print_stat("first_write_reads", writeReads, false);
+    print_stat("first_write_programs", writePrograms, false);
+    print_stat("first_write_seconds", writeSeconds, true);
+    printf("  },\n  \"failed\": [");
+    for (uint32_t i = 0, n = 0; i < options.iterations; i++) {
+        const Result *r = &results[i];
+        if (r->failure) {
+            printf("%s\n    {\"iteration\": %u, \"failure\": \"%s\", \"path\": \"%s\", \"mount\": %d, \"write\": %d}",
+                   n++ ? "," : "", (unsigned)(i + 1), r->failure, r->path, r->mountErr, r->writeErr);
+        }
+    }
+    printf("\n  ]");
+    if (detail) {
+        printf(",\n  \"detail\": [");
+        for (uint32_t i = 0; i < options.iterations; i++) {
+            const Result *r = &results[i];
+            printf("%s\n    {\"iteration\": %u, \"cut\": %s, \"mount_async_steps\": %u, \"mount_async_reads\": %u, "
+                   "\"mount_reads\": %u, \"mount_seconds\": %.6f, \"first_write_reads\": %u, "
+                   "\"first_write_programs\": %u, \"first_write_seconds\": %.6f}",
+                   i ? "," : "", (unsigned)(i + 1), r->cut ? "true" : "false", (unsigned)r->mountAsyncSteps,
+                   (unsigned)r->mountAsyncReads, (unsigned)r->mountReads, r->mountSeconds,
+                   (unsigned)r->writeReads, (unsigned)r->writePrograms, r->writeSeconds);
+        }
+        printf("\n  ]");
+    }
+    printf("\n}\n");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,197 @@
+/*
+ * BlockDeviceTest.cpp
+ *
+ *  Created on: 17 Oct 2026
+ *
+ *  Host test of the BlockDevice implementations. Covered: RAMBlockDevice
+ *  and FileBlockDevice round trips, erase, geometry, contents kept across
+ *  deinit()/init() and the rejected calls (not initialized, misaligned,
+ *  out of range, missing file); the mapping of the SDCard errors onto
+ *  BD_ERROR_* with the SD_BLOCK_DEVICE_* code left in error().
+ *
+ *  Build and run from the repository root:
+ *
+ *      g++ -Wall -I. -Ihost host/test/BlockDeviceTest.cpp RAMBlockDevice.cpp \
+ *          SDCard.cpp SDCardInfo.cpp SDCRC.cpp host/FileBlockDevice.cpp \
+ *          host/HostSPI.cpp host/SDCardModel.cpp -o blockdevicetest
+ *      ./blockdevicetest
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+#include "RAMBlockDevice.h"
+#include "FileBlockDevice.h"
+#include "SDCard.h"
+#include "HostSPI.h"
+#include "SDCardModel.h"
+
+#define SECTOR                  512
+#define DEVICE_SIZE             (32 * SECTOR)
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { \
+        printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+static void pattern(uint8_t *buffer, size_t length, uint8_t seed)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        buffer[i] = (uint8_t)(seed + i * 13);
+    }
+}
+
+/* Behaviour every device shares, on an initialized device of DEVICE_SIZE */
+static void checkDevice(BlockDevice *bd)
+{
+    uint8_t w[4 * SECTOR], r[4 * SECTOR];
+
+    CHECK(bd->size() == DEVICE_SIZE);
+    CHECK(bd->get_read_size() == SECTOR);
+    CHECK(bd->get_program_size() == SECTOR);
+
+    pattern(w, sizeof(w), 0x5C);
+    CHECK(bd->program(w, 4 * SECTOR, sizeof(w)) == BD_ERROR_OK);
+    CHECK(bd->sync() == BD_ERROR_OK);
+    CHECK(bd->read(r, 4 * SECTOR, sizeof(r)) == BD_ERROR_OK);
+    CHECK(memcmp(r, w, sizeof(r)) == 0);
+
+    // last sector, then one past the end
+    CHECK(bd->program(w, DEVICE_SIZE - SECTOR, SECTOR) == BD_ERROR_OK);
+    CHECK(bd->read(r, DEVICE_SIZE - SECTOR, SECTOR) == BD_ERROR_OK);
+    CHECK(memcmp(r, w, SECTOR) == 0);
+    CHECK(bd->read(r, DEVICE_SIZE, SECTOR) == BD_ERROR_PARAMETER);
+    CHECK(bd->program(w, DEVICE_SIZE - SECTOR, 2 * SECTOR) == BD_ERROR_PARAMETER);
+
+    // misaligned address or size
+    CHECK(bd->read(r, 1, SECTOR) == BD_ERROR_PARAMETER);
+    CHECK(bd->read(r, 0, SECTOR + 1) == BD_ERROR_PARAMETER);
+    CHECK(bd->program(w, SECTOR / 2, SECTOR) == BD_ERROR_PARAMETER);
+    CHECK(bd->erase(0, SECTOR / 2) == BD_ERROR_PARAMETER);
+    CHECK(bd->erase(0, SECTOR) == BD_ERROR_OK);
+    CHECK(bd->trim(0, SECTOR) == BD_ERROR_OK);
+}
+
+static void testRAM(void)
+{
+    std::vector<uint8_t> memory(DEVICE_SIZE + SECTOR / 2, 0);
+    RAMBlockDevice bd(&memory[0], memory.size());
+    uint8_t w[SECTOR], r[SECTOR];
+
+    // whole blocks only, nothing before init()
+    CHECK(bd.read(r, 0, SECTOR) == BD_ERROR_PARAMETER);
+    CHECK(bd.init() == BD_ERROR_OK);
+    checkDevice(&bd);
+    CHECK(strcmp(bd.get_type(), "RAM") == 0);
+
+    // erased sectors read back as 0xFF
+    CHECK(bd.erase(SECTOR, SECTOR) == BD_ERROR_OK);
+    CHECK(bd.read(r, SECTOR, SECTOR) == BD_ERROR_OK);
+    memset(w, 0xFF, sizeof(w));
+    CHECK(memcmp(r, w, sizeof(r)) == 0);
+
+    // the buffer keeps the contents across deinit()/init()
+    pattern(w, sizeof(w), 0x99);
+    CHECK(bd.program(w, 2 * SECTOR, SECTOR) == BD_ERROR_OK);
+    CHECK(bd.deinit() == BD_ERROR_OK);
+    CHECK(bd.program(w, 2 * SECTOR, SECTOR) == BD_ERROR_PARAMETER);
+    CHECK(bd.init() == BD_ERROR_OK);
+    CHECK(bd.read(r, 2 * SECTOR, SECTOR) == BD_ERROR_OK);
+    CHECK(memcmp(r, w, sizeof(r)) == 0);
+}
+
+static void testFile(void)
+{
+    char path[] = "/tmp/blockdevicetestXXXXXX";
+    int fd = mkstemp(path);
+    uint8_t w[SECTOR], r[SECTOR];
+
+    CHECK(fd >= 0);
+    close(fd);
+    {
+        // created empty: extended to the requested size, reads as zero
+        FileBlockDevice bd(path, DEVICE_SIZE);
+        CHECK(bd.read(r, 0, SECTOR) == BD_ERROR_PARAMETER);
+        CHECK(bd.sync() == BD_ERROR_PARAMETER);
+        CHECK(bd.init() == BD_ERROR_OK);
+        CHECK(bd.read(r, 8 * SECTOR, SECTOR) == BD_ERROR_OK);
+        memset(w, 0, sizeof(w));
+        CHECK(memcmp(r, w, sizeof(r)) == 0);
+        checkDevice(&bd);
+        CHECK(strcmp(bd.get_type(), "FILE") == 0);
+
+        pattern(w, sizeof(w), 0x77);
+        CHECK(bd.program(w, 10 * SECTOR, SECTOR) == BD_ERROR_OK);
+        CHECK(bd.deinit() == BD_ERROR_OK);
+    }
+    {
+        // size 0 takes the size of the existing file
+        FileBlockDevice bd(path);
+        CHECK(bd.init() == BD_ERROR_OK);
+        CHECK(bd.size() == DEVICE_SIZE);
+        CHECK(bd.read(r, 10 * SECTOR, SECTOR) == BD_ERROR_OK);
+        CHECK(memcmp(r, w, sizeof(r)) == 0);
+    }
+    unlink(path);
+
+    FileBlockDevice missing("/nonexistent/blockdevicetest.img", DEVICE_SIZE);
+    CHECK(missing.init() == BD_ERROR_DEVICE_ERROR);
+}
+
+/* Nothing on the bus: MISO stays low */
+class NoCard : public SPIDevice
+{
+public:
+    virtual void select(bool selected) {}
+    virtual uint8_t exchange(uint8_t mosi)
+    {
+        return 0x00;
+    }
+};
+
+static void testSDErrors(void)
+{
+    SDCardModel card(65536);
+    HostSPI spi(&card);
+    SDCard sd(&spi, 0, 0);
+    uint8_t buffer[SECTOR];
+
+    // before init(): the size is 0, every address is out of range
+    CHECK(sd.read(buffer, 0, SECTOR) == BD_ERROR_PARAMETER);
+    CHECK(sd.error() == SD_BLOCK_DEVICE_ERROR_PARAMETER);
+
+    CHECK(sd.init() == BD_ERROR_OK);
+    CHECK(sd.error() == SD_BLOCK_DEVICE_OK);
+    CHECK(sd.read(buffer, 1, SECTOR) == BD_ERROR_PARAMETER);
+    CHECK(sd.error() == SD_BLOCK_DEVICE_ERROR_PARAMETER);
+    CHECK(sd.trim(0, SECTOR / 2) == BD_ERROR_PARAMETER);
+    CHECK(sd.read(buffer, 0, SECTOR) == BD_ERROR_OK);
+    CHECK(sd.error() == SD_BLOCK_DEVICE_OK);
+
+    // card errors are device errors, error() tells which
+    NoCard none;
+    HostSPI bus(&none);
+    SDCard absent(&bus, 0, 0);
+    CHECK(absent.init() == BD_ERROR_DEVICE_ERROR);
+    CHECK(absent.error() < SD_BLOCK_DEVICE_OK);
+    CHECK(absent.error() != SD_BLOCK_DEVICE_ERROR_PARAMETER);
+}
+
+int main()
+{
+    testRAM();
+    testFile();
+    testSDErrors();
+
+    if (failures)
+    {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("BlockDevice: all tests passed\n");
+    return 0;
+}
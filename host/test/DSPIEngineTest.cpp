@@ -0,0 +1,787 @@
+/*
+ * DSPIEngineTest.cpp
+ *
+ *  Created on: 17 Oct 2026
+ *
+ *  Host test of the DSPI_A transaction queue (DSPIEngine) against a
+ *  simulated eUSCI SPI module: TXBUF feeding the shift register, RXBUF
+ *  with RXIFG / UCOE, and the module interrupt delivered whenever IE & IFG
+ *  while it is not masked. The device on the other side answers every
+ *  byte with its bitwise inverse. Covered: ring wrap-around, a full ring,
+ *  fill-byte and receive-only transactions, chip-select sequencing
+ *  (including DSPI_TRANSACTION_KEEP_CS), a late ISR losing a byte to
+ *  an overrun and a polled transfer reporting UCOE to its caller. The
+ *  DMA mode runs on FakeDMAController: channel sequencing, byte
+ *  accounting, fill and sink transfers, rejected starts, a completion
+ *  interrupt racing transferDone() and an aborted transfer.
+ *
+ *  Build and run from the repository root:
+ *
+ *      g++ -Wall -I. -Ihost/test host/test/DSPIEngineTest.cpp \
+ *          host/test/FakeDMAController.cpp DSPIEngine.cpp -o dspienginetest
+ *      ./dspienginetest
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "DSPIEngine.h"
+#include "FakeDMAController.h"
+
+#define TXBUF_UNTOUCHED         0xFFFF      /*!< The engine only writes bytes to TXBUF */
+#define MAX_TICKS               100000
+#define DMA_TX                  DMA_CH2_TX  /*!< Channels the module triggers */
+#define DMA_RX                  DMA_CH3_RX
+#define DMA_CH2_TX              0x02000002
+#define DMA_CH3_RX              0x02000003
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { \
+        printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+/* Chip-select pins and interrupt masking, with the order of the events.
+ * The DMA completion interrupt is delivered as soon as it is raised,
+ * or when the critical section that held it off ends */
+class FakePlatform : public DSPIPlatform
+{
+public:
+    uint32_t csLow;                 /*!< Pins currently asserted, port 1 only */
+    int masked;
+    bool critical;
+    bool dmaPending;
+    bool raiseOnEnter;              /*!< Raise the DMA interrupt inside the next critical section */
+    unsigned dmaDelivered;
+    DSPIEngine *engine;
+    std::vector<int> events;        /*!< +pin on select, -pin on deselect */
+
+    FakePlatform() : csLow(0), masked(0), critical(false), dmaPending(false),
+        raiseOnEnter(false), dmaDelivered(0), engine(0) {}
+
+    void raiseDMA(void)
+    {
+        dmaPending = true;
+        if (!critical)
+        {
+            deliverDMA();
+        }
+    }
+    void deliverDMA(void)
+    {
+        dmaPending = false;
+        dmaDelivered++;
+        engine->handleDMAInterrupt();
+    }
+
+    virtual void select(uint32_t port, uint32_t pin)
+    {
+        CHECK(port == 1);
+        csLow |= pin;
+        events.push_back((int)pin);
+    }
+    virtual void deselect(uint32_t port, uint32_t pin)
+    {
+        CHECK(port == 1);
+        CHECK(csLow & pin);
+        csLow &= ~pin;
+        events.push_back(-(int)pin);
+    }
+    virtual void disableInterrupt(void)
+    {
+        masked++;
+    }
+    virtual void enableInterrupt(void)
+    {
+        CHECK(masked > 0);
+        masked--;
+    }
+    virtual bool enterCritical(void)
+    {
+        bool was = critical;
+        critical = true;
+        if (raiseOnEnter)
+        {
+            raiseOnEnter = false;
+            raiseDMA();
+        }
+        return was;
+    }
+    virtual void exitCritical(bool was)
+    {
+        CHECK(critical);
+        critical = was;
+        if (!critical && dmaPending)
+        {
+            deliverDMA();
+        }
+    }
+};
+
+/* eUSCI SPI master: TXBUF -> shift register -> RXBUF, one byte per tick */
+class SimSPI
+{
+public:
+    uint16_t IE, IFG, STATW, RXBUF, TXBUF;
+    FakePlatform platform;
+    DSPIEngine engine;
+    FakeDMAController *dma;
+    uint32_t txChannel;
+    uint32_t rxChannel;
+
+    bool txFull;                    /*!< TXBUF holds a byte */
+    uint8_t txData;
+    bool shifting;
+    uint8_t shiftData;
+    uint32_t shiftCS;               /*!< Chip-selects asserted when the byte started */
+    unsigned latency;               /*!< Ticks the ISR is held off once it is pending */
+
+    std::vector<uint8_t> mosi;
+    std::vector<uint32_t> mosiCS;
+
+    SimSPI() : IE(0), IFG(DSPI_IFG_TXIFG), STATW(0), RXBUF(0), TXBUF(TXBUF_UNTOUCHED),
+        engine(registers(), &platform), dma(0), txChannel(0), rxChannel(0), txFull(false),
+        txData(0), shifting(false), shiftData(0), shiftCS(0), latency(0)
+    {
+        platform.engine = &engine;
+    }
+
+    void attach(FakeDMAController *controller)
+    {
+        dma = controller;
+        txChannel = controller->assign(DMA_TX);
+        rxChannel = controller->assign(DMA_RX);
+        engine.setDMA(controller, txChannel, rxChannel);
+        controller->onStop = stopped;
+        controller->context = this;
+    }
+
+    /* Both channels stopped: the module shifts out what it already has */
+    static void stopped(void *context, uint32_t channel)
+    {
+        SimSPI *sim = (SimSPI *)context;
+        if (channel == sim->rxChannel)
+        {
+            while (sim->STATW & DSPI_STATW_BUSY)
+            {
+                sim->tick();
+            }
+        }
+    }
+
+    DSPI_Registers registers()
+    {
+        DSPI_Registers r = { &IE, &IFG, &STATW, &RXBUF, &TXBUF };
+        return r;
+    }
+
+    bool pending()
+    {
+        return !platform.masked && (IE & IFG & (DSPI_IE_TXIE | DSPI_IE_RXIE));
+    }
+
+    /* Run the ISR, applying what the hardware does on the register accesses:
+     * reading RXBUF clears RXIFG and UCOE (a running queue reads it
+     * whenever RXIFG is set), writing TXBUF clears TXIFG */
+    void isr()
+    {
+        bool rx = (IFG & DSPI_IFG_RXIFG) && !engine.queueIdle();
+        TXBUF = TXBUF_UNTOUCHED;
+        engine.handleInterrupt();
+        if (rx)
+        {
+            IFG &= ~DSPI_IFG_RXIFG;
+            STATW &= ~DSPI_STATW_OE;
+        }
+        if (TXBUF != TXBUF_UNTOUCHED)
+        {
+            written();
+        }
+    }
+
+    void written()
+    {
+        CHECK(IFG & DSPI_IFG_TXIFG);            // only written when empty
+        CHECK(!txFull);
+        IFG &= ~DSPI_IFG_TXIFG;
+        txFull = true;
+        txData = (uint8_t)TXBUF;
+        load();
+    }
+
+    /* DMA requests: RXIFG triggers the RX channel, TXIFG the TX channel.
+     * The completion interrupt comes from the RX channel */
+    void dmaService()
+    {
+        if (!dma)
+        {
+            return;
+        }
+        if ((IFG & DSPI_IFG_RXIFG) && dma->trigger(rxChannel))
+        {
+            IFG &= ~DSPI_IFG_RXIFG;
+            STATW &= ~DSPI_STATW_OE;
+            if (!dma->running(rxChannel))
+            {
+                platform.raiseDMA();
+            }
+        }
+        if ((IFG & DSPI_IFG_TXIFG) && dma->running(txChannel))
+        {
+            TXBUF = 0;
+            dma->trigger(txChannel);
+            written();
+        }
+    }
+
+    /* Move TXBUF into an idle shift register */
+    void load()
+    {
+        if (txFull && !shifting)
+        {
+            shifting = true;
+            shiftData = txData;
+            shiftCS = platform.csLow;
+            txFull = false;
+            IFG |= DSPI_IFG_TXIFG;
+        }
+        STATW = shifting ? (STATW | DSPI_STATW_BUSY) : (STATW & ~DSPI_STATW_BUSY);
+    }
+
+    /* One byte time */
+    void tick()
+    {
+        if (shifting)
+        {
+            mosi.push_back(shiftData);
+            mosiCS.push_back(shiftCS);
+            if (IFG & DSPI_IFG_RXIFG)
+            {
+                STATW |= DSPI_STATW_OE;
+            }
+            RXBUF = (uint8_t)~shiftData;
+            IFG |= DSPI_IFG_RXIFG;
+            shifting = false;
+        }
+        load();
+        dmaService();
+    }
+
+    /* Run until the DMA transfer is done, polling like SDCard does */
+    bool runDMA()
+    {
+        dmaService();
+        for (int i = 0; i < MAX_TICKS; i++)
+        {
+            if (engine.transferDone())
+            {
+                return true;
+            }
+            tick();
+        }
+        return false;
+    }
+
+    /* Run until the queue is idle, false when it hangs */
+    bool run()
+    {
+        unsigned wait = 0;
+        for (int i = 0; i < MAX_TICKS; i++)
+        {
+            if (pending() && (wait++ >= latency))
+            {
+                while (pending())
+                {
+                    isr();
+                }
+                wait = 0;
+            }
+            if (engine.queueIdle() && !shifting && !txFull)
+            {
+                return true;
+            }
+            tick();
+        }
+        return false;
+    }
+};
+
+/* Completion callbacks, in order */
+static std::vector<int> completed;
+static SimSPI *current;
+
+static void done0(void) { completed.push_back(0); }
+static void done1(void) { completed.push_back(1); }
+static void done2(void) { completed.push_back(2); }
+static void (*const doneCallbacks[3])(void) = { done0, done1, done2 };
+
+/* The chip-select is released once the last byte is shifted in */
+static void doneIdle(void)
+{
+    CHECK(!current->shifting && !current->txFull);
+    completed.push_back(-1);
+}
+
+static DSPI_Transaction transaction(uint32_t pin, const uint8_t *tx, uint8_t *rx,
+                                    size_t length, uint8_t fill = 0xFF)
+{
+    DSPI_Transaction t;
+    memset(&t, 0, sizeof(t));
+    t.csPort = 1;
+    t.csPin = pin;
+    t.tx = tx;
+    t.rx = rx;
+    t.length = length;
+    t.fill = fill;
+    return t;
+}
+
+static void testSingle(void)
+{
+    SimSPI sim;
+    uint8_t tx[37], rx[37];
+
+    current = &sim;
+    completed.clear();
+    for (unsigned i = 0; i < sizeof(tx); i++)
+    {
+        tx[i] = (uint8_t)(i * 7 + 3);
+    }
+    memset(rx, 0, sizeof(rx));
+
+    DSPI_Transaction t = transaction(0x10, tx, rx, sizeof(tx));
+    t.callback = doneIdle;
+    CHECK(sim.engine.enqueue(t));
+    CHECK(!sim.engine.queueIdle());
+    CHECK(sim.platform.masked == 0);
+    CHECK(sim.run());
+
+    CHECK(sim.mosi.size() == sizeof(tx));
+    CHECK(memcmp(sim.mosi.data(), tx, sizeof(tx)) == 0);
+    for (unsigned i = 0; i < sizeof(rx); i++)
+    {
+        CHECK(rx[i] == (uint8_t)~tx[i]);
+        CHECK(sim.mosiCS[i] == 0x10);
+    }
+    CHECK(completed.size() == 1);
+    CHECK(sim.platform.events.size() == 2);
+    CHECK(sim.platform.events[0] == 0x10 && sim.platform.events[1] == -0x10);
+    CHECK(sim.platform.csLow == 0);
+    CHECK((sim.IE & (DSPI_IE_TXIE | DSPI_IE_RXIE)) == 0);
+    CHECK(sim.engine.overruns == 0);
+    CHECK(!sim.engine.enqueue(transaction(0x10, tx, rx, 0)));
+}
+
+static void testFill(void)
+{
+    SimSPI sim;
+    uint8_t rx[20];
+    uint8_t tx[5] = { 1, 2, 3, 4, 5 };
+
+    current = &sim;
+    memset(rx, 0, sizeof(rx));
+
+    // receive only, clocking out the fill byte, then transmit only
+    CHECK(sim.engine.enqueue(transaction(0x1, 0, rx, sizeof(rx), 0xA5)));
+    CHECK(sim.engine.enqueue(transaction(0x1, tx, 0, sizeof(tx))));
+    CHECK(sim.run());
+
+    CHECK(sim.mosi.size() == sizeof(rx) + sizeof(tx));
+    for (unsigned i = 0; i < sizeof(rx); i++)
+    {
+        CHECK(sim.mosi[i] == 0xA5);
+        CHECK(rx[i] == 0x5A);
+    }
+    CHECK(memcmp(&sim.mosi[sizeof(rx)], tx, sizeof(tx)) == 0);
+}
+
+static void testFullRing(void)
+{
+    SimSPI sim;
+    uint8_t tx[DSPI_QUEUE_SIZE][3];
+
+    current = &sim;
+    completed.clear();
+
+    // the first transaction starts straight away, the ring keeps one slot
+    // free to tell full from empty
+    for (int i = 0; i < DSPI_QUEUE_SIZE - 1; i++)
+    {
+        memset(tx[i], i, sizeof(tx[i]));
+        DSPI_Transaction t = transaction(1u << (i % 3), tx[i], 0, sizeof(tx[i]));
+        t.callback = doneCallbacks[i % 3];
+        CHECK(sim.engine.enqueue(t));
+    }
+    CHECK(!sim.engine.enqueue(transaction(0x1, tx[0], 0, 1)));
+    CHECK(sim.run());
+
+    CHECK(completed.size() == DSPI_QUEUE_SIZE - 1);
+    CHECK(sim.mosi.size() == (DSPI_QUEUE_SIZE - 1) * 3);
+    for (size_t i = 0; (i < completed.size()) && (i < sim.mosi.size() / 3); i++)
+    {
+        CHECK(completed[i] == (int)(i % 3));
+        CHECK(sim.mosi[i * 3] == i);
+        CHECK(sim.mosiCS[i * 3] == (1u << (i % 3)));
+    }
+
+    // select / deselect pairs, never two chip-selects asserted at once
+    CHECK(sim.platform.events.size() == 2 * (DSPI_QUEUE_SIZE - 1));
+    for (size_t i = 0; i + 1 < sim.platform.events.size(); i += 2)
+    {
+        CHECK(sim.platform.events[i] > 0);
+        CHECK(sim.platform.events[i + 1] == -sim.platform.events[i]);
+    }
+
+    // room again once drained
+    CHECK(sim.engine.enqueue(transaction(0x1, tx[0], 0, 1)));
+    CHECK(sim.run());
+}
+
+static void testWrapAround(void)
+{
+    SimSPI sim;
+    const int total = DSPI_QUEUE_SIZE * 5 + 3;
+    uint8_t tx[total][4];
+    uint8_t rx[total][4];
+    int queued = 0;
+
+    current = &sim;
+    completed.clear();
+    memset(rx, 0, sizeof(rx));
+
+    // keep adding transactions while the ISR drains the ring, so head and
+    // tail wrap several times at different distances
+    for (int step = 0; (queued < total) && (step < MAX_TICKS); step++)
+    {
+        int burst = 1 + (step % 4);
+        while (burst-- && (queued < total))
+        {
+            size_t length = 1 + (queued % 4);
+            memset(tx[queued], 0x40 + queued, sizeof(tx[queued]));
+            DSPI_Transaction t = transaction(0x2, tx[queued], rx[queued], length);
+            t.callback = done0;
+            if (!sim.engine.enqueue(t))
+            {
+                break;
+            }
+            queued++;
+        }
+        for (int i = 0; i < 3; i++)
+        {
+            while (sim.pending())
+            {
+                sim.isr();
+            }
+            sim.tick();
+        }
+    }
+    CHECK(queued == total);
+    CHECK(sim.run());
+    CHECK((int)completed.size() == total);
+
+    size_t offset = 0;
+    for (int i = 0; i < total; i++)
+    {
+        size_t length = 1 + (i % 4);
+        for (size_t j = 0; j < length; j++)
+        {
+            CHECK((offset + j < sim.mosi.size()) && (sim.mosi[offset + j] == (uint8_t)(0x40 + i)));
+            CHECK(rx[i][j] == (uint8_t)~(0x40 + i));
+        }
+        offset += length;
+    }
+    CHECK(offset == sim.mosi.size());
+}
+
+static void testKeepCS(void)
+{
+    SimSPI sim;
+    uint8_t command[6] = { 0x51, 0, 0, 0, 0, 0xFF };
+    uint8_t data[8];
+
+    current = &sim;
+
+    // command and data phase under one chip-select assertion
+    DSPI_Transaction t = transaction(0x4, command, 0, sizeof(command));
+    t.flags = DSPI_TRANSACTION_KEEP_CS;
+    CHECK(sim.engine.enqueue(t));
+    CHECK(sim.engine.enqueue(transaction(0x4, 0, data, sizeof(data))));
+    CHECK(sim.run());
+
+    for (size_t i = 0; i < sim.mosiCS.size(); i++)
+    {
+        CHECK(sim.mosiCS[i] == 0x4);
+    }
+    // asserted again for the second transaction, released only at the end
+    CHECK(sim.platform.events.size() == 3);
+    CHECK(sim.platform.events[0] == 0x4 && sim.platform.events[1] == 0x4);
+    CHECK(sim.platform.events[2] == -0x4);
+    CHECK(sim.platform.csLow == 0);
+}
+
+static void testOverrun(void)
+{
+    SimSPI sim;
+    uint8_t tx[64], rx[64];
+
+    current = &sim;
+    completed.clear();
+    memset(tx, 0x33, sizeof(tx));
+
+    // a late ISR lets the second byte in flight overwrite RXBUF: the
+    // transaction still completes instead of waiting for the lost byte
+    sim.latency = 2;
+    DSPI_Transaction t = transaction(0x8, tx, rx, sizeof(tx));
+    t.callback = done0;
+    CHECK(sim.engine.enqueue(t));
+    CHECK(sim.run());
+    CHECK(completed.size() == 1);
+    CHECK(sim.engine.overruns > 0);
+    CHECK(sim.mosi.size() == sizeof(tx));
+    CHECK(sim.platform.csLow == 0);
+}
+
+static void testPolledOverrun(void)
+{
+    SimSPI sim;
+    uint8_t tx[8], rx[8];
+
+    // the polled transfer spins on the flags: keep both raised, RXBUF
+    // holding a byte, so that only UCOE decides the outcome
+    memset(tx, 0x33, sizeof(tx));
+    sim.IFG = DSPI_IFG_TXIFG | DSPI_IFG_RXIFG;
+    sim.RXBUF = 0x5A;
+    memset(rx, 0, sizeof(rx));
+    CHECK(sim.engine.transfer(tx, rx, sizeof(rx), 0xFF));
+    CHECK(sim.engine.overruns == 0);
+    CHECK(rx[0] == 0x5A && rx[sizeof(rx) - 1] == 0x5A);
+
+    // UCOE: the caller sees the lost bytes, also without a receive buffer
+    sim.STATW = DSPI_STATW_OE;
+    CHECK(!sim.engine.transfer(tx, rx, sizeof(rx), 0xFF));
+    CHECK(sim.engine.overruns > 0);
+    CHECK(!sim.engine.transfer(0, 0, sizeof(rx), 0xFF));
+    CHECK(sim.engine.transfer(tx, rx, 0, 0xFF));
+}
+
+static unsigned dmaCallbacks;
+static void dmaDone(void) { dmaCallbacks++; }
+
+/* Channel log: both assigned, RX started before TX (TXIFG is already set,
+ * the TX channel starts moving at once), same length */
+static void checkStarts(FakeDMAController &dma, size_t first, size_t length)
+{
+    CHECK(dma.calls.size() == first + 2);
+    if (dma.calls.size() == first + 2)
+    {
+        CHECK(dma.calls[first].op == FakeDMAController::START);
+        CHECK(dma.calls[first].channel == 3);
+        CHECK(dma.calls[first + 1].op == FakeDMAController::START);
+        CHECK(dma.calls[first + 1].channel == 2);
+        CHECK(dma.calls[first].length == length && dma.calls[first + 1].length == length);
+    }
+}
+
+static void testDMA(void)
+{
+    SimSPI sim;
+    FakeDMAController dma(512);
+    uint8_t tx[300], rx[300];
+
+    sim.attach(&dma);
+    CHECK(sim.engine.hasDMA());
+    CHECK(dma.calls.size() == 2);
+    for (unsigned i = 0; i < sizeof(tx); i++)
+    {
+        tx[i] = (uint8_t)(i * 13);
+    }
+    memset(rx, 0, sizeof(rx));
+
+    dmaCallbacks = 0;
+    CHECK(sim.engine.startTransfer(tx, rx, sizeof(tx), 0xFF, dmaDone));
+    checkStarts(dma, 2, sizeof(tx));
+    CHECK(dma.channels[2].flags == DMA_SRC_INCREMENT);
+    CHECK(dma.channels[3].flags == DMA_DST_INCREMENT);
+
+    // one transfer at a time
+    CHECK(!sim.engine.startTransfer(tx, rx, 1, 0xFF, dmaDone));
+    CHECK(!sim.engine.transferDone());
+
+    CHECK(sim.runDMA());
+    CHECK(dmaCallbacks == 1);
+    CHECK(sim.platform.dmaDelivered == 1);
+    CHECK(dma.channels[2].moved == sizeof(tx) && dma.channels[3].moved == sizeof(rx));
+    CHECK(!dma.running(2) && !dma.running(3));
+    CHECK(sim.mosi.size() == sizeof(tx));
+    CHECK(memcmp(sim.mosi.data(), tx, sizeof(tx)) == 0);
+    for (unsigned i = 0; i < sizeof(rx); i++)
+    {
+        CHECK(rx[i] == (uint8_t)~tx[i]);
+    }
+    CHECK(!(sim.IFG & DSPI_IFG_RXIFG));         // nothing left for the next polled transfer
+    CHECK(!sim.platform.critical);
+
+    // rejected: empty, above the controller limit
+    CHECK(!sim.engine.startTransfer(tx, rx, 0, 0xFF, dmaDone));
+    CHECK(!sim.engine.startTransfer(tx, rx, 513, 0xFF, dmaDone));
+    CHECK(dma.calls.size() == 4);
+    CHECK(dma.errors == 0);
+}
+
+static void testDMAFill(void)
+{
+    SimSPI sim;
+    FakeDMAController dma;
+    uint8_t tx[40], rx[64];
+
+    sim.attach(&dma);
+    memset(tx, 0x3C, sizeof(tx));
+    memset(rx, 0, sizeof(rx));
+
+    // receive only: the fill byte is sent from a fixed address
+    dmaCallbacks = 0;
+    CHECK(sim.engine.startTransfer(0, rx, sizeof(rx), 0xA5, dmaDone));
+    CHECK(dma.channels[2].flags == 0);
+    CHECK(sim.runDMA());
+    for (unsigned i = 0; i < sizeof(rx); i++)
+    {
+        CHECK(sim.mosi[i] == 0xA5);
+        CHECK(rx[i] == 0x5A);
+    }
+
+    // transmit only: the RX channel still drains RXBUF, into a sink
+    CHECK(sim.engine.startTransfer(tx, 0, sizeof(tx), 0xFF, 0));
+    CHECK(dma.channels[3].flags == 0);
+    CHECK(sim.runDMA());
+    CHECK(dma.channels[3].moved == sizeof(tx));
+    CHECK(memcmp(&sim.mosi[sizeof(rx)], tx, sizeof(tx)) == 0);
+    CHECK(!(sim.IFG & DSPI_IFG_RXIFG));
+    CHECK(dmaCallbacks == 1);
+    CHECK(dma.errors == 0);
+
+    // no controller attached
+    SimSPI plain;
+    CHECK(!plain.engine.hasDMA());
+    CHECK(!plain.engine.startTransfer(tx, 0, sizeof(tx), 0xFF, 0));
+}
+
+static void testDMARace(void)
+{
+    SimSPI sim;
+    FakeDMAController dma;
+    uint8_t tx[16];
+
+    sim.attach(&dma);
+    memset(tx, 0x11, sizeof(tx));
+
+    // the RX channel completes, transferDone() sees it first and the
+    // completion interrupt arrives while it clears the busy flag: the
+    // interrupt runs once unmasked and must not complete the transfer again
+    dmaCallbacks = 0;
+    CHECK(sim.engine.startTransfer(tx, 0, sizeof(tx), 0xFF, dmaDone));
+    sim.platform.critical = true;               // hold the interrupt off
+    for (int i = 0; (i < MAX_TICKS) && dma.running(3); i++)
+    {
+        sim.tick();
+    }
+    sim.platform.critical = false;
+    sim.platform.dmaPending = false;            // lost in the window below instead
+    sim.platform.raiseOnEnter = true;
+    CHECK(sim.engine.transferDone());
+    CHECK(sim.platform.dmaDelivered == 1);
+    CHECK(dmaCallbacks == 1);
+
+    // and the other way round: interrupt first, then the poll
+    CHECK(sim.engine.startTransfer(tx, 0, sizeof(tx), 0xFF, dmaDone));
+    CHECK(sim.runDMA());
+    CHECK(sim.platform.dmaDelivered == 2);
+    CHECK(sim.engine.transferDone());
+    CHECK(dmaCallbacks == 2);
+    CHECK(dma.errors == 0);
+}
+
+static void testDMAAbort(void)
+{
+    SimSPI sim;
+    FakeDMAController dma;
+    uint8_t tx[100], rx[100], again[8];
+
+    sim.attach(&dma);
+    memset(tx, 0x42, sizeof(tx));
+    memset(rx, 0, sizeof(rx));
+
+    // the deadline expires halfway: both channels stop, the module is idle
+    // and nothing is written to the buffer afterwards
+    dmaCallbacks = 0;
+    CHECK(sim.engine.startTransfer(tx, rx, sizeof(tx), 0xFF, dmaDone));
+    for (int i = 0; i < 40; i++)
+    {
+        sim.tick();
+    }
+    CHECK(!sim.engine.transferDone());
+    size_t moved = dma.channels[3].moved;
+    sim.engine.abortTransfer();
+
+    size_t calls = dma.calls.size();
+    CHECK(dma.calls[calls - 2].op == FakeDMAController::STOP && dma.calls[calls - 2].channel == 2);
+    CHECK(dma.calls[calls - 1].op == FakeDMAController::STOP && dma.calls[calls - 1].channel == 3);
+    CHECK(!dma.running(2) && !dma.running(3));
+    CHECK(!(sim.STATW & DSPI_STATW_BUSY));
+    CHECK(sim.engine.transferDone());
+    CHECK(dmaCallbacks == 0);
+    CHECK(!sim.platform.critical);
+    CHECK(moved < sizeof(rx));
+
+    // RXBUF was read by the abort
+    sim.IFG &= ~DSPI_IFG_RXIFG;
+    sim.STATW &= ~DSPI_STATW_OE;
+    for (int i = 0; i < 100; i++)
+    {
+        sim.tick();
+    }
+    for (size_t i = dma.channels[3].moved; i < sizeof(rx); i++)
+    {
+        CHECK(rx[i] == 0);
+    }
+
+    // the next transfer starts clean
+    size_t sent = sim.mosi.size();
+    memset(again, 0x77, sizeof(again));
+    CHECK(sim.engine.startTransfer(again, rx, sizeof(again), 0xFF, dmaDone));
+    CHECK(sim.runDMA());
+    CHECK(dmaCallbacks == 1);
+    CHECK(sim.mosi.size() == sent + sizeof(again));
+    for (size_t i = 0; i < sizeof(again); i++)
+    {
+        CHECK(rx[i] == 0x88);
+    }
+    CHECK(dma.errors == 0);
+
+    // without a controller it does nothing
+    SimSPI plain;
+    plain.engine.abortTransfer();
+    CHECK(plain.engine.transferDone());
+}
+
+int main()
+{
+    testSingle();
+    testFill();
+    testFullRing();
+    testWrapAround();
+    testKeepCS();
+    testOverrun();
+    testPolledOverrun();
+    testDMA();
+    testDMAFill();
+    testDMARace();
+    testDMAAbort();
+
+    if (failures)
+    {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("DSPIEngine: all tests passed\n");
+    return 0;
+}
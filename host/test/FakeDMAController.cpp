@@ -0,0 +1,103 @@
+/*
+ * FakeDMAController.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "FakeDMAController.h"
+#include <string.h>
+
+FakeDMAController::FakeDMAController(size_t limit)
+{
+    memset(channels, 0, sizeof(channels));
+    this->errors = 0;
+    this->limit = limit;
+    this->onStop = 0;
+    this->context = 0;
+}
+
+uint32_t FakeDMAController::assign(uint32_t mapping)
+{
+    // same encoding as the driverlib DMA_CHn_xxx mappings
+    uint32_t channel = mapping & 0x0F;
+    Call call = { ASSIGN, channel, 0 };
+
+    calls.push_back(call);
+    if ((channel >= FAKE_DMA_CHANNELS) || channels[channel].assigned) {
+        errors++;
+        return channel;
+    }
+    channels[channel].assigned = true;
+    return channel;
+}
+
+void FakeDMAController::start(uint32_t channel, const volatile void *src,
+                              volatile void *dst, size_t length, uint8_t flags)
+{
+    Call call = { START, channel, length };
+
+    calls.push_back(call);
+    if ((channel >= FAKE_DMA_CHANNELS) || !channels[channel].assigned ||
+            channels[channel].enabled || !src || !dst || !length || (length > limit)) {
+        errors++;
+        return;
+    }
+
+    Channel *c = &channels[channel];
+    c->enabled = true;
+    c->done = false;
+    c->src = (const volatile uint8_t *)src;
+    c->dst = (volatile uint8_t *)dst;
+    c->length = length;
+    c->moved = 0;
+    c->flags = flags;
+}
+
+void FakeDMAController::stop(uint32_t channel)
+{
+    Call call = { STOP, channel, 0 };
+
+    calls.push_back(call);
+    if ((channel >= FAKE_DMA_CHANNELS) || !channels[channel].assigned) {
+        errors++;
+        return;
+    }
+    channels[channel].enabled = false;
+    if (onStop) {
+        onStop(context, channel);
+    }
+}
+
+bool FakeDMAController::isDone(uint32_t channel)
+{
+    return (channel < FAKE_DMA_CHANNELS) && channels[channel].done;
+}
+
+size_t FakeDMAController::maxLength() const
+{
+    return limit;
+}
+
+bool FakeDMAController::trigger(uint32_t channel)
+{
+    if (!running(channel)) {
+        return false;
+    }
+
+    Channel *c = &channels[channel];
+    size_t src = (c->flags & DMA_SRC_INCREMENT) ? c->moved : 0;
+    size_t dst = (c->flags & DMA_DST_INCREMENT) ? c->moved : 0;
+
+    c->dst[dst] = c->src[src];
+    c->moved++;
+    if (c->moved == c->length) {
+        c->enabled = false;
+        c->done = true;
+    }
+    return true;
+}
+
+bool FakeDMAController::running(uint32_t channel) const
+{
+    return (channel < FAKE_DMA_CHANNELS) && channels[channel].enabled;
+}
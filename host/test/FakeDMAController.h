@@ -0,0 +1,69 @@
+/*
+ * FakeDMAController.h
+ *
+ *  Created on: 17 Oct 2026
+ *
+ *  DMAController for host tests. Channels move one byte per trigger(),
+ *  which the simulated peripheral calls when its request line (TXIFG /
+ *  RXIFG) is set, and disable themselves once done like the uDMA basic
+ *  mode. Every call is logged, misuse (unassigned channel, restart of a
+ *  running channel, length out of range, stop of an idle channel) is
+ *  counted in errors, and the bytes moved per channel are accounted.
+ */
+
+#ifndef FAKEDMACONTROLLER_H_
+#define FAKEDMACONTROLLER_H_
+
+#include <vector>
+#include "DMAController.h"
+
+#define FAKE_DMA_CHANNELS       8
+
+class FakeDMAController : public DMAController
+{
+public:
+    enum Op { ASSIGN, START, STOP };
+
+    typedef struct
+    {
+        Op op;
+        uint32_t channel;
+        size_t length;
+    } Call;
+
+    typedef struct
+    {
+        bool assigned;
+        bool enabled;
+        bool done;
+        const volatile uint8_t *src;
+        volatile uint8_t *dst;
+        size_t length;
+        size_t moved;           /*!< Bytes moved since the last start */
+        uint8_t flags;
+    } Channel;
+
+    FakeDMAController(size_t limit = 1024);
+
+    virtual uint32_t assign(uint32_t mapping);
+    virtual void start(uint32_t channel, const volatile void *src,
+                       volatile void *dst, size_t length, uint8_t flags);
+    virtual void stop(uint32_t channel);
+    virtual bool isDone(uint32_t channel);
+    virtual size_t maxLength() const;
+
+    // Request from the peripheral: move one byte, false when the channel is not running
+    bool trigger(uint32_t channel);
+    bool running(uint32_t channel) const;
+
+    Channel channels[FAKE_DMA_CHANNELS];
+    std::vector<Call> calls;
+    unsigned errors;
+    size_t limit;
+
+    // Called after a channel is stopped, e.g. to let the peripheral finish
+    void (*onStop)(void *context, uint32_t channel);
+    void *context;
+};
+
+#endif /* FAKEDMACONTROLLER_H_ */
@@ -0,0 +1,493 @@
+/*
+ * SDCardTest.cpp
+ *
+ *  Created on: 17 Oct 2026
+ *
+ *  Host test of SDCard against SDCardModel over HostSPI. Covered: a
+ *  received byte lost on the bus fails the block read with a CRC error
+ *  instead of returning the data with a hole; trimmed ranges reach the
+ *  card as CMD32/33/38 on sync(), without the programmed sectors, also
+ *  when a program splits a range while the discard queue is full; the
+ *  ACMD41 wait of a card that stays idle ends after its poll budget
+ *  without a time source and after SD_INIT_TIMEOUT with one, also when
+ *  the millisecond counter wraps; a block rejected in a multiple block
+ *  write is resumed from the ACMD22 count without rewriting the blocks
+ *  that landed; the transfer clock and the CMD6 High-Speed switch, with
+ *  the fallback to 25MHz when the card or the bus cannot go faster; the
+ *  warm start from retained state, which falls back to the full
+ *  identification on a bad CRC or when another card answers; a model
+ *  size below or between whole C_SIZE units rounded up. Built with
+ *  read-ahead, also: scattered reads prefetch nothing, a sequential run
+ *  at most one window past its end, a program replaces a prefetched copy.
+ *  Built with the CRC on, also: blocks move in SD_CRC_CHUNK transfers on
+ *  a DMA bus with the CRC16 updated per chunk, a flipped bit fails one.
+ *
+ *  Build and run from the repository root, again with
+ *  -DSD_READAHEAD_SECTORS=4 to cover the read-ahead and with
+ *  -DSD_CRC_ENABLED=1 to cover the CRC:
+ *
+ *      g++ -Wall -I. -Ihost host/test/SDCardTest.cpp SDCard.cpp \
+ *          SDCardInfo.cpp SDCRC.cpp host/HostSPI.cpp host/SDCardModel.cpp \
+ *          -o sdcardtest
+ *      ./sdcardtest
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "SDCard.h"
+#include "HostSPI.h"
+#include "SDCardModel.h"
+
+#define SECTORS                 65536       /*!< 32 MiB card */
+#define SECTOR                  512
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { \
+        printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+static void pattern(uint8_t *buffer, size_t length, uint8_t seed)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        buffer[i] = (uint8_t)(seed + i * 7);
+    }
+}
+
+static void testLostByte(void)
+{
+    SDCardModel card(SECTORS);
+    HostSPI spi(&card);
+    SDCard sd(&spi, 0, 0);
+    uint8_t w[4 * SECTOR], r[4 * SECTOR];
+
+    CHECK(sd.init() == BD_ERROR_OK);
+    pattern(w, sizeof(w), 0x11);
+    CHECK(sd.program(w, 100 * SECTOR, sizeof(w)) == BD_ERROR_OK);
+    CHECK(sd.sync() == BD_ERROR_OK);
+
+    // single block: the first block transfer after the command loses a byte
+    spi.lostByte = spi.bytes + 16;
+    CHECK(sd.read(r, 100 * SECTOR, SECTOR) == BD_ERROR_DEVICE_ERROR);
+    CHECK(sd.error() == SD_BLOCK_DEVICE_ERROR_CRC);
+    CHECK(spi.overruns == 1);
+
+    // multiple block read: the stream is stopped, a retry gets the data
+    spi.lostByte = spi.bytes + 16;
+    CHECK(sd.read(r, 100 * SECTOR, sizeof(r)) == BD_ERROR_DEVICE_ERROR);
+    CHECK(sd.error() == SD_BLOCK_DEVICE_ERROR_CRC);
+    CHECK(spi.overruns == 2);
+    CHECK(sd.read(r, 100 * SECTOR, sizeof(r)) == BD_ERROR_OK);
+    CHECK(memcmp(r, w, sizeof(r)) == 0);
+
+    // lost bytes of data going out do not matter
+    spi.lostByte = spi.bytes + 16;
+    CHECK(sd.program(w, 200 * SECTOR, SECTOR) == BD_ERROR_OK);
+    CHECK(sd.sync() == BD_ERROR_OK);
+    CHECK(sd.read(r, 200 * SECTOR, SECTOR) == BD_ERROR_OK);
+    CHECK(memcmp(r, w, SECTOR) == 0);
+}
+
+static void testWriteResume(void)
+{
+    SDCardModel card(SECTORS);
+    HostSPI spi(&card);
+    SDCard sd(&spi, 0, 0);
+    uint8_t w[16 * SECTOR], r[16 * SECTOR];
+
+    CHECK(sd.init() == BD_ERROR_OK);
+    pattern(w, sizeof(w), 0x21);
+
+    // the fifth block gets a write error: four landed, the rest is resent
+    card.blocksWritten = 0;
+    card.rejectBlock = 5;
+    CHECK(sd.program(w, 200 * SECTOR, sizeof(w)) == BD_ERROR_OK);
+    CHECK(sd.sync() == BD_ERROR_OK);
+    CHECK(card.writeErrors == 1);
+    CHECK(card.blocksWritten == 16);
+    CHECK(sd.get_programmed_size() == sizeof(w));
+    CHECK(sd.read(r, 200 * SECTOR, sizeof(r)) == BD_ERROR_OK);
+    CHECK(memcmp(r, w, sizeof(r)) == 0);
+
+    // the stream stays open across program() calls: the count covers both
+    pattern(w, sizeof(w), 0x43);
+    CHECK(sd.program(w, 300 * SECTOR, 8 * SECTOR) == BD_ERROR_OK);
+    card.blocksWritten = 0;
+    card.rejectBlock = 3;
+    CHECK(sd.program(w + 8 * SECTOR, 308 * SECTOR, 8 * SECTOR) == BD_ERROR_OK);
+    CHECK(sd.sync() == BD_ERROR_OK);
+    CHECK(card.writeErrors == 2);
+    CHECK(card.blocksWritten == 8);
+    CHECK(sd.read(r, 300 * SECTOR, sizeof(r)) == BD_ERROR_OK);
+    CHECK(memcmp(r, w, sizeof(r)) == 0);
+}
+
+#if SD_READAHEAD_SECTORS
+static void testReadAhead(void)
+{
+    SDCardModel card(SECTORS);
+    HostSPI spi(&card);
+    SDCard sd(&spi, 0, 0);
+    uint8_t w[32 * SECTOR], r[SECTOR];
+    static const uint32_t scattered[] = { 20, 21, 3, 27, 9, 4, 28 };
+    const uint32_t count = sizeof(scattered) / sizeof(scattered[0]);
+
+    CHECK(sd.init() == BD_ERROR_OK);
+    pattern(w, sizeof(w), 0x3C);
+    CHECK(sd.program(w, 400 * SECTOR, sizeof(w)) == BD_ERROR_OK);
+    CHECK(sd.sync() == BD_ERROR_OK);
+
+    // scattered reads, a pair of neighbours included, prefetch nothing
+    uint32_t before = card.blocksRead;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        CHECK(sd.read(r, (400 + scattered[i]) * SECTOR, SECTOR) == BD_ERROR_OK);
+        CHECK(memcmp(r, w + scattered[i] * SECTOR, SECTOR) == 0);
+    }
+    CHECK(card.blocksRead - before == count);
+
+    // a sequential run is prefetched, at most a window past its end
+    before = card.blocksRead;
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        CHECK(sd.read(r, (400 + i) * SECTOR, SECTOR) == BD_ERROR_OK);
+        CHECK(memcmp(r, w + i * SECTOR, SECTOR) == 0);
+    }
+    CHECK(card.blocksRead - before <= 16 + SD_READAHEAD_SECTORS);
+
+    // a program replaces the prefetched copy of its sector
+    pattern(w + 16 * SECTOR, SECTOR, 0xC3);
+    CHECK(sd.program(w + 16 * SECTOR, 416 * SECTOR, SECTOR) == BD_ERROR_OK);
+    CHECK(sd.read(r, 416 * SECTOR, SECTOR) == BD_ERROR_OK);
+    CHECK(memcmp(r, w + 16 * SECTOR, SECTOR) == 0);
+}
+#endif
+
+#if SD_CRC_ENABLED
+/* Bus whose background transfers complete at once, counted; corrupt flips
+   the first received byte of that transfer, 0 for none */
+class ChunkSPI : public HostSPI
+{
+public:
+    uint32_t chunks;
+    uint32_t corrupt;
+
+    ChunkSPI(SPIDevice *device) : HostSPI(device), chunks(0), corrupt(0) {}
+
+    virtual bool startTransfer(const uint8_t *tx, uint8_t *rx, size_t length,
+                               uint8_t fill, void (*callback)(void))
+    {
+        transfer(tx, rx, length);
+        chunks++;
+        if (rx && (chunks == corrupt))
+        {
+            rx[0] ^= 0x01;
+        }
+        return true;
+    }
+};
+
+static void testChunkedCRC(void)
+{
+    SDCardModel card(SECTORS);
+    ChunkSPI spi(&card);
+    SDCard sd(&spi, 0, 0);
+    uint8_t w[4 * SECTOR], r[4 * SECTOR];
+
+    CHECK(sd.init() == BD_ERROR_OK);
+    pattern(w, sizeof(w), 0x29);
+    uint32_t before = spi.chunks;
+    CHECK(sd.program(w, 500 * SECTOR, sizeof(w)) == BD_ERROR_OK);
+    CHECK(sd.sync() == BD_ERROR_OK);
+    CHECK(spi.chunks - before == sizeof(w) / SD_CRC_CHUNK);
+    CHECK(card.crcErrors == 0);
+    before = spi.chunks;
+    CHECK(sd.read(r, 500 * SECTOR, sizeof(r)) == BD_ERROR_OK);
+    CHECK(spi.chunks - before == sizeof(r) / SD_CRC_CHUNK);
+    CHECK(memcmp(r, w, sizeof(r)) == 0);
+
+    // a bit flipped in the middle of the block fails it
+    spi.corrupt = spi.chunks + 2;
+    CHECK(sd.read(r, 500 * SECTOR, SECTOR) == BD_ERROR_DEVICE_ERROR);
+    CHECK(sd.error() == SD_BLOCK_DEVICE_ERROR_CRC);
+    CHECK(sd.read(r, 500 * SECTOR, SECTOR) == BD_ERROR_OK);
+    CHECK(memcmp(r, w, SECTOR) == 0);
+}
+#endif
+
+static void testModelSize(void)
+{
+    // the model rounds its size up to what the CSD can describe
+    SDCardModel card(100);
+    HostSPI spi(&card);
+    SDCard sd(&spi, 0, 0);
+
+    CHECK(card.sectors == SD_MODEL_SIZE_UNIT);
+    CHECK(sd.init() == BD_ERROR_OK);
+    CHECK(sd.size() == (uint64_t)SD_MODEL_SIZE_UNIT * SECTOR);
+
+    SDCardModel odd(SD_MODEL_SIZE_UNIT + 1);
+    CHECK(odd.sectors == 2 * SD_MODEL_SIZE_UNIT);
+}
+
+/* Card model counting the commands by index */
+class CountingCardModel : public SDCardModel
+{
+public:
+    uint32_t count[64];
+
+    CountingCardModel() : SDCardModel(SECTORS)
+    {
+        memset(count, 0, sizeof(count));
+    }
+
+protected:
+    virtual void _command(uint8_t cmd, uint32_t arg)
+    {
+        count[cmd & 0x3F]++;
+        SDCardModel::_command(cmd, arg);
+    }
+};
+
+/* init() at the requested clock, then a write and read back */
+static void initAt(CountingCardModel &card, HostSPI &spi, unsigned int clock)
+{
+    SDCard sd(&spi, 0, 0);
+    uint8_t w[4 * SECTOR], r[4 * SECTOR];
+
+    if (clock)
+    {
+        CHECK(sd.frequency(clock) == 0);
+    }
+    CHECK(sd.init() == BD_ERROR_OK);
+    pattern(w, sizeof(w), 0x65);
+    CHECK(sd.program(w, 0, sizeof(w)) == BD_ERROR_OK);
+    CHECK(sd.sync() == BD_ERROR_OK);
+    CHECK(sd.read(r, 0, sizeof(r)) == BD_ERROR_OK);
+    CHECK(memcmp(r, w, sizeof(r)) == 0);
+}
+
+static void testHighSpeed(void)
+{
+    // the default clock fits the default speed: no CMD6
+    {
+        CountingCardModel card;
+        HostSPI spi(&card);
+        initAt(card, spi, 0);
+        CHECK(spi.clock == SD_TRX_FREQUENCY);
+        CHECK(card.count[6] == 0);
+    }
+    // above 25MHz: check and switch, then the configured clock is kept
+    {
+        CountingCardModel card;
+        HostSPI spi(&card);
+        initAt(card, spi, 40000000);
+        CHECK(card.count[6] == 2);
+        CHECK(spi.clock == 40000000);
+    }
+    // the card has no High-Speed: the check fails, the clock is capped
+    {
+        CountingCardModel card;
+        HostSPI spi(&card);
+        card.highSpeedSupported = false;
+        initAt(card, spi, 40000000);
+        CHECK(card.count[6] == 1);
+        CHECK(spi.clock == SD_MAX_FREQUENCY);
+    }
+    // the bus cannot go above 25MHz: nothing to gain from CMD6
+    {
+        CountingCardModel card;
+        HostSPI spi(&card);
+        spi.maxClock = 24000000;
+        initAt(card, spi, 40000000);
+        CHECK(card.count[6] == 0);
+        CHECK(spi.clock == 24000000);
+    }
+}
+
+static void testWarmStart(void)
+{
+    CountingCardModel card;
+    HostSPI spi(&card);
+    SDCardRetained keep;
+    uint8_t w[4 * SECTOR], r[4 * SECTOR];
+
+    memset(&keep, 0, sizeof(keep));
+    pattern(w, sizeof(w), 0x87);
+    {
+        SDCard sd(&spi, 0, 0);
+        sd.setRetained(&keep);
+        CHECK(sd.init() == BD_ERROR_OK);
+        CHECK(card.count[0] > 0);
+        CHECK(sd.program(w, 0, sizeof(w)) == BD_ERROR_OK);
+        CHECK(sd.sync() == BD_ERROR_OK);
+    }
+
+    // MCU reset, the card stayed powered: no CMD0, same geometry and data
+    memset(card.count, 0, sizeof(card.count));
+    {
+        SDCard sd(&spi, 0, 0);
+        sd.setRetained(&keep);
+        CHECK(sd.init() == BD_ERROR_OK);
+        CHECK(card.count[0] == 0);
+        CHECK(sd.size() == (uint64_t)SECTORS * SECTOR);
+        CHECK(sd.read(r, 0, sizeof(r)) == BD_ERROR_OK);
+        CHECK(memcmp(r, w, sizeof(r)) == 0);
+    }
+
+    // retained RAM corrupted: the CRC no longer matches
+    memset(card.count, 0, sizeof(card.count));
+    keep.sectors ^= 1;
+    {
+        SDCard sd(&spi, 0, 0);
+        sd.setRetained(&keep);
+        CHECK(sd.init() == BD_ERROR_OK);
+        CHECK(card.count[0] > 0);
+        CHECK(sd.size() == (uint64_t)SECTORS * SECTOR);
+    }
+
+    // another card in transfer state: the CID differs
+    memset(card.count, 0, sizeof(card.count));
+    card.serial ^= 0xFFFF;
+    {
+        SDCard sd(&spi, 0, 0);
+        sd.setRetained(&keep);
+        CHECK(sd.init() == BD_ERROR_OK);
+        CHECK(card.count[10] >= 2);
+        CHECK(card.count[0] > 0);
+    }
+
+    // the retained state now belongs to that card
+    memset(card.count, 0, sizeof(card.count));
+    {
+        SDCard sd(&spi, 0, 0);
+        sd.setRetained(&keep);
+        CHECK(sd.init() == BD_ERROR_OK);
+        CHECK(card.count[0] == 0);
+    }
+}
+
+/* Card that never leaves the idle state */
+class IdleCardModel : public SDCardModel
+{
+public:
+    IdleCardModel() : SDCardModel(SECTORS) {}
+
+protected:
+    virtual void _command(uint8_t cmd, uint32_t arg)
+    {
+        _acmd41 = 0;
+        SDCardModel::_command(cmd, arg);
+    }
+};
+
+/* Millisecond counter about to wrap, advancing on every call */
+static uint32_t clockMs;
+static uint32_t millis(void)
+{
+    return clockMs++;
+}
+
+static void testInitTimeout(void)
+{
+    IdleCardModel card;
+    HostSPI spi(&card);
+    SDCard sd(&spi, 0, 0);
+
+    // without a time source ACMD41 has a budget of its own (CMD55 + ACMD41
+    // per retry), not SD_INIT_TIMEOUT * SD_POLLS_PER_MS exchanges
+    CHECK(sd.init() == BD_ERROR_DEVICE_ERROR);
+    CHECK(sd.error() == SD_BLOCK_DEVICE_ERROR_NO_RESPONSE);
+    CHECK(card.commands > 1000);
+    CHECK(card.commands < 10000);
+
+    // the deadline holds across the wrap of the time source
+    clockMs = 0xFFFFFF00;
+    sd.setTimeSource(millis);
+    CHECK(sd.init() == BD_ERROR_DEVICE_ERROR);
+    CHECK(clockMs - 0xFFFFFF00 >= 1000);
+    CHECK(clockMs - 0xFFFFFF00 < 1100);
+}
+
+/* Sector of the card image holds only the byte value */
+static bool sectorIs(SDCardModel &card, uint32_t sector, uint8_t value)
+{
+    for (uint32_t i = 0; i < SECTOR; i++)
+    {
+        if (card.image[sector * SECTOR + i] != value)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void testDiscard(void)
+{
+    SDCardModel card(SECTORS);
+    HostSPI spi(&card);
+    SDCard sd(&spi, 0, 0);
+    uint8_t w[SECTOR];
+
+    CHECK(sd.init() == BD_ERROR_OK);
+    memset(&card.image[0], 0xAA, 64 * SECTOR);
+
+    // a single sector is a whole erase unit, the queue keeps it until sync()
+    CHECK(sd.trim(2 * SECTOR, SECTOR) == BD_ERROR_OK);
+    CHECK(sd.trim(3 * SECTOR, 3 * SECTOR) == BD_ERROR_OK);
+    CHECK(card.erases == 0);
+    CHECK(sd.sync() == BD_ERROR_OK);
+    CHECK(card.erases == 1);
+    CHECK(sectorIs(card, 1, 0xAA));
+    CHECK(sectorIs(card, 2, 0x00) && sectorIs(card, 5, 0x00));
+    CHECK(sectorIs(card, 6, 0xAA));
+
+    // fill the queue with separate ranges, then program into the middle of
+    // the first one: the tail still needs a slot
+    for (uint32_t i = 0; i < SD_DISCARD_RANGES; i++)
+    {
+        CHECK(sd.trim((8 + 4 * i) * SECTOR, 3 * SECTOR) == BD_ERROR_OK);
+    }
+    memset(w, 0x55, sizeof(w));
+    CHECK(sd.program(w, 9 * SECTOR, SECTOR) == BD_ERROR_OK);
+    CHECK(sd.sync() == BD_ERROR_OK);
+    CHECK(card.erases == 1 + SD_DISCARD_RANGES + 1);
+    CHECK(sectorIs(card, 8, 0x00));
+    CHECK(sectorIs(card, 9, 0x55));
+    CHECK(sectorIs(card, 10, 0x00));
+    CHECK(sectorIs(card, 11, 0xAA));
+    CHECK(sectorIs(card, 8 + 4 * (SD_DISCARD_RANGES - 1) + 2, 0x00));
+
+    // a program covering a queued range cancels it
+    CHECK(sd.trim(48 * SECTOR, SECTOR) == BD_ERROR_OK);
+    CHECK(sd.program(w, 48 * SECTOR, SECTOR) == BD_ERROR_OK);
+    CHECK(sd.sync() == BD_ERROR_OK);
+    CHECK(card.erases == 1 + SD_DISCARD_RANGES + 1);
+    CHECK(sectorIs(card, 48, 0x55));
+}
+
+int main()
+{
+    testLostByte();
+    testDiscard();
+    testInitTimeout();
+    testWriteResume();
+    testHighSpeed();
+    testWarmStart();
+    testModelSize();
+#if SD_READAHEAD_SECTORS
+    testReadAhead();
+#endif
+#if SD_CRC_ENABLED
+    testChunkedCRC();
+#endif
+
+    if (failures)
+    {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("SDCard: all tests passed\n");
+    return 0;
+}
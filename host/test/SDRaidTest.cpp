@@ -0,0 +1,194 @@
+/*
+ * SDRaidTest.cpp
+ *
+ *  Created on: 17 Oct 2026
+ *
+ *  Host test of the SD_RAID1 mirror on RAMBlockDevice members. Covered:
+ *  a member dropped on a failed program stays out across init() and
+ *  never serves stale data, a member with an older or without a
+ *  superblock is left out, and rebuild() copies the mirror back onto it.
+ *
+ *  Build and run from the repository root:
+ *
+ *      g++ -Wall -I. -Ihost host/test/SDRaidTest.cpp SDRaid.cpp \
+ *          RAMBlockDevice.cpp SDCRC.cpp -o sdraidtest
+ *      ./sdraidtest
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "SDRaid.h"
+#include "RAMBlockDevice.h"
+
+#define MEMBER_SIZE             (64 * 512)
+#define SECTOR                  512
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { \
+        printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+/* RAM member whose programs can be made to fail, like a worn out card */
+class FlakyBlockDevice : public RAMBlockDevice
+{
+public:
+    bool failPrograms;
+
+    FlakyBlockDevice(uint8_t *buffer) : RAMBlockDevice(buffer, MEMBER_SIZE), failPrograms(false) {}
+
+    virtual int program(const void *buffer, uint64_t addr, uint64_t size)
+    {
+        if (failPrograms)
+        {
+            return BD_ERROR_DEVICE_ERROR;
+        }
+        return RAMBlockDevice::program(buffer, addr, size);
+    }
+};
+
+class Mirror
+{
+public:
+    std::vector<uint8_t> memory[2];
+    FlakyBlockDevice *members[2];
+    SDRaid *raid;
+
+    Mirror()
+    {
+        BlockDevice *devices[2];
+        for (int i = 0; i < 2; i++)
+        {
+            memory[i].assign(MEMBER_SIZE, 0);
+            members[i] = new FlakyBlockDevice(&memory[i][0]);
+            devices[i] = members[i];
+        }
+        raid = new SDRaid(devices, 2, SD_RAID1);
+    }
+    ~Mirror()
+    {
+        delete raid;
+        delete members[0];
+        delete members[1];
+    }
+};
+
+/* Every read of the sector returns the expected data, whichever member serves it */
+static bool readsBack(SDRaid *raid, uint64_t addr, uint8_t value)
+{
+    uint8_t buffer[SECTOR];
+
+    for (int i = 0; i < 4; i++)
+    {
+        if (raid->read(buffer, addr, SECTOR) != BD_ERROR_OK)
+        {
+            return false;
+        }
+        for (int j = 0; j < SECTOR; j++)
+        {
+            if (buffer[j] != value)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static int fill(SDRaid *raid, uint64_t addr, uint8_t value)
+{
+    uint8_t buffer[SECTOR];
+
+    memset(buffer, value, sizeof(buffer));
+    return raid->program(buffer, addr, SECTOR);
+}
+
+static void testDroppedMember(void)
+{
+    Mirror m;
+
+    // a new mirror: the last sector of each member holds the superblock
+    CHECK(m.raid->init() == BD_ERROR_OK);
+    CHECK(m.raid->size() == MEMBER_SIZE - SECTOR);
+    CHECK(m.raid->failed() == 0);
+    CHECK(fill(m.raid, 0, 0x11) == BD_ERROR_OK);
+    CHECK(m.raid->sync() == BD_ERROR_OK);
+
+    // member 1 fails a program and misses the next update
+    m.members[1]->failPrograms = true;
+    CHECK(fill(m.raid, 0, 0x22) == BD_ERROR_OK);
+    CHECK(m.raid->failed() == 2);
+    CHECK(m.raid->degraded());
+    CHECK(m.memory[1][0] == 0x11);
+
+    // the card works again after a power cycle, but holds stale data
+    m.members[1]->failPrograms = false;
+    CHECK(m.raid->deinit() == BD_ERROR_OK);
+    CHECK(m.raid->init() == BD_ERROR_OK);
+    CHECK(m.raid->failed() == 2);
+    CHECK(readsBack(m.raid, 0, 0x22));
+
+    // rebuild takes it back, also across init()
+    CHECK(m.raid->rebuild(1) == BD_ERROR_OK);
+    CHECK(m.raid->failed() == 0);
+    CHECK(m.memory[1][0] == 0x22);
+    CHECK(m.raid->init() == BD_ERROR_OK);
+    CHECK(m.raid->failed() == 0);
+    CHECK(readsBack(m.raid, 0, 0x22));
+}
+
+static void testStaleMember(void)
+{
+    Mirror m;
+    std::vector<uint8_t> old;
+
+    CHECK(m.raid->init() == BD_ERROR_OK);
+    CHECK(fill(m.raid, SECTOR, 0x33) == BD_ERROR_OK);
+    old = m.memory[1];
+
+    // member 1 drops out, the others move on without it
+    m.members[1]->failPrograms = true;
+    CHECK(fill(m.raid, SECTOR, 0x44) == BD_ERROR_OK);
+    m.members[1]->failPrograms = false;
+
+    // the card is swapped for the copy taken before: an older generation
+    m.memory[1] = old;
+    CHECK(m.raid->init() == BD_ERROR_OK);
+    CHECK(m.raid->failed() == 2);
+    CHECK(readsBack(m.raid, SECTOR, 0x44));
+
+    // a blank card has no superblock at all
+    m.memory[1].assign(MEMBER_SIZE, 0);
+    CHECK(m.raid->init() == BD_ERROR_OK);
+    CHECK(m.raid->failed() == 2);
+    CHECK(m.raid->rebuild(1) == BD_ERROR_OK);
+    CHECK(m.memory[1][SECTOR] == 0x44);
+
+    // member 0 is the stale one now: the superblock of member 1 wins
+    old = m.memory[0];
+    m.members[0]->failPrograms = true;
+    CHECK(fill(m.raid, SECTOR, 0x66) == BD_ERROR_OK);
+    m.members[0]->failPrograms = false;
+    m.memory[0] = old;
+    CHECK(m.raid->init() == BD_ERROR_OK);
+    CHECK(m.raid->failed() == 1);
+    CHECK(readsBack(m.raid, SECTOR, 0x66));
+
+    CHECK(m.raid->rebuild(2) == BD_ERROR_PARAMETER);
+    CHECK(m.raid->rebuild(1) == BD_ERROR_OK);
+}
+
+int main()
+{
+    testDroppedMember();
+    testStaleMember();
+
+    if (failures)
+    {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("SDRaid: all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,185 @@
+/*
+ * SDTraceTest.cpp
+ *
+ *  Created on: 17 Oct 2026
+ *
+ *  Host test of the SPI tracer and its decoder. Covered: per-phase byte
+ *  and time accounting, nested operations recorded once, the ring keeping
+ *  the last SD_TRACE_RECORDS operations, the decoder output in-process
+ *  and from a raw dump (and a truncated dump), and SDCard tagging the
+ *  data and CRC bytes of a multiple block write.
+ *
+ *  Build and run from the repository root, with the tracer compiled in:
+ *
+ *      g++ -Wall -DSD_TRACE_ENABLED=1 -I. -Ihost host/test/SDTraceTest.cpp \
+ *          SDCard.cpp SDCardInfo.cpp SDCRC.cpp SDTrace.cpp host/HostSPI.cpp \
+ *          host/SDCardModel.cpp host/SDTraceDecoder.cpp -o sdtracetest
+ *      ./sdtracetest
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include "SDCard.h"
+#include "SDTrace.h"
+#include "SDTraceDecoder.h"
+#include "HostSPI.h"
+#include "SDCardModel.h"
+
+#define SECTOR                  512
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { \
+        printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+/* Device answering every byte with 0xFF */
+class IdleDevice : public SPIDevice
+{
+public:
+    virtual void select(bool selected) {}
+    virtual uint8_t exchange(uint8_t mosi)
+    {
+        return 0xFF;
+    }
+};
+
+/* Timestamps: bytes clocked on the bus */
+static HostSPI *clockBus;
+static uint32_t busClock(void)
+{
+    return (uint32_t)clockBus->bytes;
+}
+
+/* Decoder output as a string */
+static std::string decode(const SDTraceRecord *records, uint32_t recordCount)
+{
+    FILE *out = tmpfile();
+    char buffer[256];
+    std::string text;
+
+    SDTraceDecoder_print(records, recordCount, out);
+    rewind(out);
+    while (fgets(buffer, sizeof(buffer), out))
+    {
+        text += buffer;
+    }
+    fclose(out);
+    return text;
+}
+
+static void testRecords(void)
+{
+    IdleDevice device;
+    HostSPI spi(&device);
+    SDTrace trace;
+    uint8_t buffer[64];
+
+    clockBus = &spi;
+    trace.attach(&spi);
+    trace.setClock(busClock);
+    trace.reset();
+
+    // one read: command, data and CRC phases, a nested operation inside
+    trace.begin(SD_TRACE_OP_READ, 0x1000);
+    trace.phase(SD_TRACE_COMMAND);
+    CHECK(trace.write(buffer, 6));
+    trace.begin(SD_TRACE_OP_SYNC, 0);
+    trace.phase(SD_TRACE_DATA);
+    CHECK(trace.read(buffer, sizeof(buffer), 0xFF));
+    trace.end();
+    trace.phase(SD_TRACE_CRC);
+    CHECK(trace.read(buffer, 2, 0xFF));
+    trace.transfer(0xFF);
+    trace.end();
+
+    CHECK(trace.recordCount == 1);
+    const SDTraceRecord *r = &trace.records[0];
+    CHECK(r->operation == SD_TRACE_OP_READ);
+    CHECK(r->address == 0x1000);
+    CHECK(r->bytes[SD_TRACE_COMMAND] == 6);
+    CHECK(r->bytes[SD_TRACE_DATA] == sizeof(buffer));
+    CHECK(r->bytes[SD_TRACE_CRC] == 3);
+    CHECK(r->time[SD_TRACE_DATA] == sizeof(buffer));
+    CHECK(r->end - r->start == 6 + sizeof(buffer) + 3);
+    CHECK(trace.totalBytes[SD_TRACE_DATA] == sizeof(buffer));
+
+    std::string text = decode(trace.records, trace.recordCount);
+    CHECK(text.find("#0 read @0x00001000: 73 ticks") != std::string::npos);
+    CHECK(text.find("data") != std::string::npos);
+    CHECK(text.find("read x1") != std::string::npos);
+    CHECK(text.find("sync") == std::string::npos);
+
+    // the ring keeps the last SD_TRACE_RECORDS operations
+    for (uint32_t i = 0; i < SD_TRACE_RECORDS + 3; i++)
+    {
+        trace.begin(SD_TRACE_OP_PROGRAM, i * SECTOR);
+        trace.phase(SD_TRACE_DATA);
+        trace.write(buffer, 1);
+        trace.end();
+    }
+    CHECK(trace.recordCount == SD_TRACE_RECORDS + 4);
+    CHECK(trace.records[0].operation == SD_TRACE_OP_PROGRAM);
+    CHECK(trace.records[3].address == (SD_TRACE_RECORDS + 2) * SECTOR);
+    text = decode(trace.records, trace.recordCount);
+    CHECK(text.find("Summary (32 of 36 operations)") != std::string::npos);
+    CHECK(text.find("program x32") != std::string::npos);
+
+    // a raw dump decodes the same, a truncated one is rejected
+    FILE *dump = tmpfile();
+    FILE *out = tmpfile();
+    fwrite(trace.records, sizeof(trace.records), 1, dump);
+    fwrite(&trace.recordCount, sizeof(trace.recordCount), 1, dump);
+    rewind(dump);
+    CHECK(SDTraceDecoder_printDump(dump, out) == 0);
+    CHECK(ftell(out) == (long)text.size());
+    fclose(dump);
+    dump = tmpfile();
+    fwrite(trace.records, sizeof(trace.records) / 2, 1, dump);
+    rewind(dump);
+    CHECK(SDTraceDecoder_printDump(dump, out) == -1);
+    fclose(dump);
+    fclose(out);
+}
+
+static void testCard(void)
+{
+    SDCardModel card(65536);
+    HostSPI spi(&card);
+    SDCard sd(&spi, 0, 0);
+    uint8_t w[8 * SECTOR];
+
+    clockBus = &spi;
+    sd.trace()->setClock(busClock);
+    CHECK(sd.init() == BD_ERROR_OK);
+    CHECK(sd.trace()->records[0].operation == SD_TRACE_OP_INIT);
+
+    // a direct multiple block write: every data byte and CRC16 tagged
+    memset(w, 0x5A, sizeof(w));
+    uint32_t before = sd.trace()->recordCount;
+    CHECK(sd.program(w, 8 * SECTOR, sizeof(w)) == BD_ERROR_OK);
+    CHECK(sd.trace()->recordCount == before + 1);
+    const SDTraceRecord *r = &sd.trace()->records[before % SD_TRACE_RECORDS];
+    CHECK(r->operation == SD_TRACE_OP_PROGRAM);
+    CHECK(r->address == 8 * SECTOR);
+    CHECK(r->bytes[SD_TRACE_DATA] == sizeof(w));
+    CHECK(r->bytes[SD_TRACE_CRC] == 8 * 2);
+    CHECK(r->bytes[SD_TRACE_COMMAND] >= 6);
+    CHECK(sd.sync() == BD_ERROR_OK);
+}
+
+int main()
+{
+    testRecords();
+    testCard();
+
+    if (failures)
+    {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("SDTrace: all tests passed\n");
+    return 0;
+}
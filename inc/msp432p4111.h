@@ -21,7 +21,7 @@
 #define EUSCI_B1_MISO GPIO_PIN5
 #define EUSCI_B1_MOSI GPIO_PIN4
 #define EUSCI_B1_CLK  GPIO_PIN3
-#define EUSCI_B1_PINS (EUSCI_B1_MISO | EUSCI_B1_MISO | EUSCI_B1_CLK)
+#define EUSCI_B1_PINS (EUSCI_B1_MISO | EUSCI_B1_MOSI | EUSCI_B1_CLK)
 
 #define EUSCI_B2_PORT GPIO_PORT_P3
 #define EUSCI_B2_MISO GPIO_PIN7
@@ -45,7 +45,7 @@
 #define EUSCI_A1_MISO GPIO_PIN2
 #define EUSCI_A1_MOSI GPIO_PIN3
 #define EUSCI_A1_CLK  GPIO_PIN1
-#define EUSCI_A1_PINS (EUSCI_A1_MISO | EUSCI_A1_MISO | EUSCI_A1_CLK)
+#define EUSCI_A1_PINS (EUSCI_A1_MISO | EUSCI_A1_MOSI | EUSCI_A1_CLK)
 
 #define EUSCI_A2_PORT GPIO_PORT_P3
 #define EUSCI_A2_MISO GPIO_PIN2
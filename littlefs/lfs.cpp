@@ -350,9 +350,22 @@ struct lfs_diskoff {
     lfs_off_t off;
 };
 
+#if defined(__cplusplus) && !defined(__TI_COMPILER_VERSION__)
+// g++ does not let a temporary array decay to a pointer, a temporary
+// struct holding the array is fine
+template <size_t N> struct lfs_mattr_list {
+    struct lfs_mattr attrs[N];
+};
+
+#define LFS_MKATTRS(...) \
+    (lfs_mattr_list<sizeof((struct lfs_mattr[]){__VA_ARGS__}) / \
+            sizeof(struct lfs_mattr)>{{__VA_ARGS__}}).attrs, \
+    sizeof((struct lfs_mattr[]){__VA_ARGS__}) / sizeof(struct lfs_mattr)
+#else
 #define LFS_MKATTRS(...) \
     (struct lfs_mattr[]){__VA_ARGS__}, \
     sizeof((struct lfs_mattr[]){__VA_ARGS__}) / sizeof(struct lfs_mattr)
+#endif
 
 // operations on global state
 static inline void lfs_gstate_xor(lfs_gstate_t *a, const lfs_gstate_t *b) {
@@ -511,7 +524,7 @@ static int lfs_alloc(lfs_t *lfs, lfs_block_t *block) {
 
         // check if we have looked at all blocks since last ack
         if (lfs->free.ack == 0) {
-            LFS_ERROR("No more free space %"PRIu32,
+            LFS_ERROR("No more free space %" PRIu32,
                     lfs->free.i + lfs->free.off);
             return LFS_ERR_NOSPC;
         }
@@ -957,8 +970,8 @@ static lfs_stag_t lfs_dir_fetchmatch(lfs_t *lfs,
 
             // found a match for our fetcher?
             if ((fmask & tag) == (fmask & ftag)) {
-                int res = cb(data, tag, &(struct lfs_diskoff){
-                        dir->pair[0], off+sizeof(tag)});
+                struct lfs_diskoff disk = {dir->pair[0], off+(lfs_off_t)sizeof(tag)};
+                int res = cb(data, tag, &disk);
                 if (res < 0) {
                     if (res == LFS_ERR_CORRUPT) {
                         dir->erased = false;
@@ -1014,7 +1027,7 @@ static lfs_stag_t lfs_dir_fetchmatch(lfs_t *lfs,
         dir->rev = revs[(r+1)%2];
     }
 
-    LFS_ERROR("Corrupted dir pair at {0x%"PRIx32", 0x%"PRIx32"}",
+    LFS_ERROR("Corrupted dir pair at {0x%" PRIx32", 0x%" PRIx32"}",
             dir->pair[0], dir->pair[1]);
     return LFS_ERR_CORRUPT;
 }
@@ -1184,13 +1197,13 @@ nextname:
 
         // find entry matching name
         while (true) {
+            struct lfs_dir_find_match match = {lfs, name, namelen};
             tag = lfs_dir_fetchmatch(lfs, dir, dir->tail,
                     LFS_MKTAG(0x780, 0, 0),
                     LFS_MKTAG(LFS_TYPE_NAME, 0, namelen),
                      // are we last name?
                     (strchr(name, '/') == NULL) ? id : NULL,
-                    lfs_dir_find_match, &(struct lfs_dir_find_match){
-                        lfs, name, namelen});
+                    lfs_dir_find_match, &match);
             if (tag < 0) {
                 return tag;
             }
@@ -1553,7 +1566,7 @@ static int lfs_dir_compact(lfs_t *lfs,
             // do we have extra space? littlefs can't reclaim this space
             // by itself, so expand cautiously
             if ((lfs_size_t)res < lfs->cfg->block_count/2) {
-                LFS_DEBUG("Expanding superblock at rev %"PRIu32, dir->rev);
+                LFS_DEBUG("Expanding superblock at rev %" PRIu32, dir->rev);
                 int err = lfs_dir_split(lfs, dir, attrs, attrcount,
                         source, begin, end);
                 if (err && err != LFS_ERR_NOSPC) {
@@ -1609,13 +1622,13 @@ static int lfs_dir_compact(lfs_t *lfs,
             }
 
             // traverse the directory, this time writing out all unique tags
+            struct lfs_dir_commit_commit commitcommit = {lfs, &commit};
             err = lfs_dir_traverse(lfs,
                     source, 0, 0xffffffff, attrs, attrcount,
                     LFS_MKTAG(0x400, 0x3ff, 0),
                     LFS_MKTAG(LFS_TYPE_NAME, 0, 0),
                     begin, end, -begin,
-                    lfs_dir_commit_commit, &(struct lfs_dir_commit_commit){
-                        lfs, &commit});
+                    lfs_dir_commit_commit, &commitcommit);
             if (err) {
                 if (err == LFS_ERR_CORRUPT) {
                     goto relocate;
@@ -1693,12 +1706,12 @@ relocate:
         relocated = true;
         lfs_cache_drop(lfs, &lfs->pcache);
         if (!tired) {
-            LFS_DEBUG("Bad block at 0x%"PRIx32, dir->pair[1]);
+            LFS_DEBUG("Bad block at 0x%" PRIx32, dir->pair[1]);
         }
 
         // can't relocate superblock, filesystem is now frozen
         if (lfs_pair_cmp(dir->pair, (const lfs_block_t[2]){0, 1}) == 0) {
-            LFS_WARN("Superblock 0x%"PRIx32" has become unwritable",
+            LFS_WARN("Superblock 0x%" PRIx32" has become unwritable",
                     dir->pair[1]);
             return LFS_ERR_NOSPC;
         }
@@ -1715,8 +1728,8 @@ relocate:
 
     if (relocated) {
         // update references if we relocated
-        LFS_DEBUG("Relocating {0x%"PRIx32", 0x%"PRIx32"} "
-                    "-> {0x%"PRIx32", 0x%"PRIx32"}",
+        LFS_DEBUG("Relocating {0x%" PRIx32", 0x%" PRIx32"} "
+                    "-> {0x%" PRIx32", 0x%" PRIx32"}",
                 oldpair[0], oldpair[1], dir->pair[0], dir->pair[1]);
         int err = lfs_fs_relocate(lfs, oldpair, dir->pair);
         if (err) {
@@ -1797,11 +1810,11 @@ static int lfs_dir_commit(lfs_t *lfs, lfs_mdir_t *dir,
 
         // traverse attrs that need to be written out
         lfs_pair_tole32(dir->tail);
+        struct lfs_dir_commit_commit commitcommit = {lfs, &commit};
         int err = lfs_dir_traverse(lfs,
                 dir, dir->off, dir->etag, attrs, attrcount,
                 0, 0, 0, 0, 0,
-                lfs_dir_commit_commit, &(struct lfs_dir_commit_commit){
-                    lfs, &commit});
+                lfs_dir_commit_commit, &commitcommit);
         lfs_pair_fromle32(dir->tail);
         if (err) {
             if (err == LFS_ERR_NOSPC || err == LFS_ERR_CORRUPT) {
@@ -2020,7 +2033,7 @@ int lfs_dir_open(lfs_t *lfs, lfs_dir_t *dir, const char *path) {
     LFS_TRACE("lfs_dir_open(%p, %p, \"%s\")", (void*)lfs, (void*)dir, path);
     lfs_stag_t tag = lfs_dir_find(lfs, &dir->m, &path, NULL);
     if (tag < 0) {
-        LFS_TRACE("lfs_dir_open -> %"PRId32, tag);
+        LFS_TRACE("lfs_dir_open -> %" PRId32, tag);
         return tag;
     }
 
@@ -2039,7 +2052,7 @@ int lfs_dir_open(lfs_t *lfs, lfs_dir_t *dir, const char *path) {
         lfs_stag_t res = lfs_dir_get(lfs, &dir->m, LFS_MKTAG(0x700, 0x3ff, 0),
                 LFS_MKTAG(LFS_TYPE_STRUCT, lfs_tag_id(tag), 8), pair);
         if (res < 0) {
-            LFS_TRACE("lfs_dir_open -> %"PRId32, res);
+            LFS_TRACE("lfs_dir_open -> %" PRId32, res);
             return res;
         }
         lfs_pair_fromle32(pair);
@@ -2135,7 +2148,7 @@ int lfs_dir_read(lfs_t *lfs, lfs_dir_t *dir, struct lfs_info *info) {
 }
 
 int lfs_dir_seek(lfs_t *lfs, lfs_dir_t *dir, lfs_off_t off) {
-    LFS_TRACE("lfs_dir_seek(%p, %p, %"PRIu32")",
+    LFS_TRACE("lfs_dir_seek(%p, %p, %" PRIu32")",
             (void*)lfs, (void*)dir, off);
     // simply walk from head dir
     int err = lfs_dir_rewind(lfs, dir);
@@ -2180,7 +2193,7 @@ int lfs_dir_seek(lfs_t *lfs, lfs_dir_t *dir, lfs_off_t off) {
 lfs_soff_t lfs_dir_tell(lfs_t *lfs, lfs_dir_t *dir) {
     LFS_TRACE("lfs_dir_tell(%p, %p)", (void*)lfs, (void*)dir);
     (void)lfs;
-    LFS_TRACE("lfs_dir_tell -> %"PRId32, dir->pos);
+    LFS_TRACE("lfs_dir_tell -> %" PRId32, dir->pos);
     return dir->pos;
 }
 
@@ -2224,7 +2237,8 @@ static int lfs_ctz_find(lfs_t *lfs,
         return 0;
     }
 
-    lfs_off_t current = lfs_ctz_index(lfs, &(lfs_off_t){size-1});
+    lfs_off_t last = size-1;
+    lfs_off_t current = lfs_ctz_index(lfs, &last);
     lfs_off_t target = lfs_ctz_index(lfs, &pos);
 
     while (current > target) {
@@ -2339,7 +2353,7 @@ static int lfs_ctz_extend(lfs_t *lfs,
         }
 
 relocate:
-        LFS_DEBUG("Bad block at 0x%"PRIx32, nblock);
+        LFS_DEBUG("Bad block at 0x%" PRIx32, nblock);
 
         // just clear cache and try a new block
         lfs_cache_drop(lfs, pcache);
@@ -2354,7 +2368,8 @@ static int lfs_ctz_traverse(lfs_t *lfs,
         return 0;
     }
 
-    lfs_off_t index = lfs_ctz_index(lfs, &(lfs_off_t){size-1});
+    lfs_off_t last = size-1;
+    lfs_off_t index = lfs_ctz_index(lfs, &last);
 
     while (true) {
         int err = cb(data, head);
@@ -2648,7 +2663,7 @@ static int lfs_file_relocate(lfs_t *lfs, lfs_file_t *file) {
         return 0;
 
 relocate:
-        LFS_DEBUG("Bad block at 0x%"PRIx32, nblock);
+        LFS_DEBUG("Bad block at 0x%" PRIx32, nblock);
 
         // just clear cache and try a new block
         lfs_cache_drop(lfs, &lfs->pcache);
@@ -2728,7 +2743,7 @@ static int lfs_file_flush(lfs_t *lfs, lfs_file_t *file) {
                 break;
 
 relocate:
-                LFS_DEBUG("Bad block at 0x%"PRIx32, file->block);
+                LFS_DEBUG("Bad block at 0x%" PRIx32, file->block);
                 err = lfs_file_relocate(lfs, file);
                 if (err) {
                     return err;
@@ -2812,7 +2827,7 @@ int lfs_file_sync(lfs_t *lfs, lfs_file_t *file) {
 
 lfs_ssize_t lfs_file_read(lfs_t *lfs, lfs_file_t *file,
         void *buffer, lfs_size_t size) {
-    LFS_TRACE("lfs_file_read(%p, %p, %p, %"PRIu32")",
+    LFS_TRACE("lfs_file_read(%p, %p, %p, %" PRIu32")",
             (void*)lfs, (void*)file, buffer, size);
 //    LFS_ASSERT(file->flags & LFS_F_OPENED);
     if(!(file->flags & LFS_F_OPENED)){
@@ -2892,7 +2907,7 @@ lfs_ssize_t lfs_file_read(lfs_t *lfs, lfs_file_t *file,
         nsize -= diff;
     }
 
-    LFS_TRACE("lfs_file_read -> %"PRId32, size);
+    LFS_TRACE("lfs_file_read -> %" PRId32, size);
     return size;
 }
 
@@ -2935,11 +2950,12 @@ lfs_ssize_t lfs_file_write(lfs_t *lfs, lfs_file_t *file,
         // fill with zeros
         lfs_off_t pos = file->pos;
         file->pos = file->ctz.size;
+        const uint8_t zero = 0;
 
         while (file->pos < pos) {
-            lfs_ssize_t res = lfs_file_write(lfs, file, &(uint8_t){0}, 1);
+            lfs_ssize_t res = lfs_file_write(lfs, file, &zero, 1);
             if (res < 0) {
-                LFS_TRACE("lfs_file_write -> %"PRId32, res);
+                LFS_TRACE("lfs_file_write -> %" PRId32, res);
                 return res;
             }
         }
@@ -3029,13 +3045,13 @@ relocate:
     }
 
     file->flags &= ~LFS_F_ERRED;
-    LFS_TRACE("lfs_file_write -> %"PRId32, size);
+    LFS_TRACE("lfs_file_write -> %" PRId32, size);
     return size;
 }
 
 lfs_soff_t lfs_file_seek(lfs_t *lfs, lfs_file_t *file,
         lfs_soff_t off, int whence) {
-    LFS_TRACE("lfs_file_seek(%p, %p, %"PRId32", %d)",
+    LFS_TRACE("lfs_file_seek(%p, %p, %" PRId32", %d)",
             (void*)lfs, (void*)file, off, whence);
 
     //LFS_ASSERT(file->flags & LFS_F_OPENED);
@@ -3067,12 +3083,12 @@ lfs_soff_t lfs_file_seek(lfs_t *lfs, lfs_file_t *file,
 
     // update pos
     file->pos = npos;
-    LFS_TRACE("lfs_file_seek -> %"PRId32, npos);
+    LFS_TRACE("lfs_file_seek -> %" PRId32, npos);
     return npos;
 }
 
 int lfs_file_truncate(lfs_t *lfs, lfs_file_t *file, lfs_off_t size) {
-    LFS_TRACE("lfs_file_truncate(%p, %p, %"PRIu32")",
+    LFS_TRACE("lfs_file_truncate(%p, %p, %" PRIu32")",
             (void*)lfs, (void*)file, size);
 //    LFS_ASSERT(file->flags & LFS_F_OPENED);
     if(!(file->flags & LFS_F_OPENED)){
@@ -3116,16 +3132,17 @@ int lfs_file_truncate(lfs_t *lfs, lfs_file_t *file, lfs_off_t size) {
         if (file->pos != oldsize) {
             lfs_soff_t res = lfs_file_seek(lfs, file, 0, LFS_SEEK_END);
             if (res < 0) {
-                LFS_TRACE("lfs_file_truncate -> %"PRId32, res);
+                LFS_TRACE("lfs_file_truncate -> %" PRId32, res);
                 return (int)res;
             }
         }
 
         // fill with zeros
+        const uint8_t zero = 0;
         while (file->pos < size) {
-            lfs_ssize_t res = lfs_file_write(lfs, file, &(uint8_t){0}, 1);
+            lfs_ssize_t res = lfs_file_write(lfs, file, &zero, 1);
             if (res < 0) {
-                LFS_TRACE("lfs_file_truncate -> %"PRId32, res);
+                LFS_TRACE("lfs_file_truncate -> %" PRId32, res);
                 return (int)res;
             }
         }
@@ -3134,7 +3151,7 @@ int lfs_file_truncate(lfs_t *lfs, lfs_file_t *file, lfs_off_t size) {
     // restore pos
     lfs_soff_t res = lfs_file_seek(lfs, file, pos, LFS_SEEK_SET);
     if (res < 0) {
-      LFS_TRACE("lfs_file_truncate -> %"PRId32, res);
+      LFS_TRACE("lfs_file_truncate -> %" PRId32, res);
       return (int)res;
     }
 
@@ -3149,7 +3166,7 @@ lfs_soff_t lfs_file_tell(lfs_t *lfs, lfs_file_t *file) {
         return LFS_ERR_NOTOPEN;
     }
     (void)lfs;
-    LFS_TRACE("lfs_file_tell -> %"PRId32, file->pos);
+    LFS_TRACE("lfs_file_tell -> %" PRId32, file->pos);
     return file->pos;
 }
 
@@ -3157,7 +3174,7 @@ int lfs_file_rewind(lfs_t *lfs, lfs_file_t *file) {
     LFS_TRACE("lfs_file_rewind(%p, %p)", (void*)lfs, (void*)file);
     lfs_soff_t res = lfs_file_seek(lfs, file, 0, LFS_SEEK_SET);
     if (res < 0) {
-        LFS_TRACE("lfs_file_rewind -> %"PRId32, res);
+        LFS_TRACE("lfs_file_rewind -> %" PRId32, res);
         return (int)res;
     }
 
@@ -3173,11 +3190,11 @@ lfs_soff_t lfs_file_size(lfs_t *lfs, lfs_file_t *file) {
     }
     (void)lfs;
     if (file->flags & LFS_F_WRITING) {
-        LFS_TRACE("lfs_file_size -> %"PRId32,
+        LFS_TRACE("lfs_file_size -> %" PRId32,
                 lfs_max(file->pos, file->ctz.size));
         return lfs_max(file->pos, file->ctz.size);
     } else {
-        LFS_TRACE("lfs_file_size -> %"PRId32, file->ctz.size);
+        LFS_TRACE("lfs_file_size -> %" PRId32, file->ctz.size);
         return file->ctz.size;
     }
 }
@@ -3189,7 +3206,7 @@ int lfs_stat(lfs_t *lfs, const char *path, struct lfs_info *info) {
     lfs_mdir_t cwd;
     lfs_stag_t tag = lfs_dir_find(lfs, &cwd, &path, NULL);
     if (tag < 0) {
-        LFS_TRACE("lfs_stat -> %"PRId32, tag);
+        LFS_TRACE("lfs_stat -> %" PRId32, tag);
         return (int)tag;
     }
 
@@ -3210,7 +3227,7 @@ int lfs_remove(lfs_t *lfs, const char *path) {
     lfs_mdir_t cwd;
     lfs_stag_t tag = lfs_dir_find(lfs, &cwd, &path, NULL);
     if (tag < 0 || lfs_tag_id(tag) == 0x3ff) {
-        LFS_TRACE("lfs_remove -> %"PRId32, (tag < 0) ? tag : LFS_ERR_INVAL);
+        LFS_TRACE("lfs_remove -> %" PRId32, (tag < 0) ? tag : LFS_ERR_INVAL);
         return (tag < 0) ? (int)tag : LFS_ERR_INVAL;
     }
 
@@ -3222,7 +3239,7 @@ int lfs_remove(lfs_t *lfs, const char *path) {
         lfs_stag_t res = lfs_dir_get(lfs, &cwd, LFS_MKTAG(0x700, 0x3ff, 0),
                 LFS_MKTAG(LFS_TYPE_STRUCT, lfs_tag_id(tag), 8), pair);
         if (res < 0) {
-            LFS_TRACE("lfs_remove -> %"PRId32, res);
+            LFS_TRACE("lfs_remove -> %" PRId32, res);
             return (int)res;
         }
         lfs_pair_fromle32(pair);
@@ -3293,7 +3310,7 @@ int lfs_rename(lfs_t *lfs, const char *oldpath, const char *newpath) {
     lfs_mdir_t oldcwd;
     lfs_stag_t oldtag = lfs_dir_find(lfs, &oldcwd, &oldpath, NULL);
     if (oldtag < 0 || lfs_tag_id(oldtag) == 0x3ff) {
-        LFS_TRACE("lfs_rename -> %"PRId32,
+        LFS_TRACE("lfs_rename -> %" PRId32,
                 (oldtag < 0) ? oldtag : LFS_ERR_INVAL);
         return (oldtag < 0) ? (int)oldtag : LFS_ERR_INVAL;
     }
@@ -3304,7 +3321,7 @@ int lfs_rename(lfs_t *lfs, const char *oldpath, const char *newpath) {
     lfs_stag_t prevtag = lfs_dir_find(lfs, &newcwd, &newpath, &newid);
     if ((prevtag < 0 || lfs_tag_id(prevtag) == 0x3ff) &&
             !(prevtag == LFS_ERR_NOENT && newid != 0x3ff)) {
-        LFS_TRACE("lfs_rename -> %"PRId32,
+        LFS_TRACE("lfs_rename -> %" PRId32,
             (prevtag < 0) ? prevtag : LFS_ERR_INVAL);
         return (prevtag < 0) ? (int)prevtag : LFS_ERR_INVAL;
     }
@@ -3342,7 +3359,7 @@ int lfs_rename(lfs_t *lfs, const char *oldpath, const char *newpath) {
         lfs_stag_t res = lfs_dir_get(lfs, &newcwd, LFS_MKTAG(0x700, 0x3ff, 0),
                 LFS_MKTAG(LFS_TYPE_STRUCT, newid, 8), prevpair);
         if (res < 0) {
-            LFS_TRACE("lfs_rename -> %"PRId32, res);
+            LFS_TRACE("lfs_rename -> %" PRId32, res);
             return (int)res;
         }
         lfs_pair_fromle32(prevpair);
@@ -3426,12 +3443,12 @@ int lfs_rename(lfs_t *lfs, const char *oldpath, const char *newpath) {
 
 lfs_ssize_t lfs_getattr(lfs_t *lfs, const char *path,
         uint8_t type, void *buffer, lfs_size_t size) {
-    LFS_TRACE("lfs_getattr(%p, \"%s\", %"PRIu8", %p, %"PRIu32")",
+    LFS_TRACE("lfs_getattr(%p, \"%s\", %" PRIu8", %p, %" PRIu32")",
             (void*)lfs, path, type, buffer, size);
     lfs_mdir_t cwd;
     lfs_stag_t tag = lfs_dir_find(lfs, &cwd, &path, NULL);
     if (tag < 0) {
-        LFS_TRACE("lfs_getattr -> %"PRId32, tag);
+        LFS_TRACE("lfs_getattr -> %" PRId32, tag);
         return tag;
     }
 
@@ -3456,12 +3473,12 @@ lfs_ssize_t lfs_getattr(lfs_t *lfs, const char *path,
             return LFS_ERR_NOATTR;
         }
 
-        LFS_TRACE("lfs_getattr -> %"PRId32, tag);
+        LFS_TRACE("lfs_getattr -> %" PRId32, tag);
         return tag;
     }
 
     size = lfs_tag_size(tag);
-    LFS_TRACE("lfs_getattr -> %"PRId32, size);
+    LFS_TRACE("lfs_getattr -> %" PRId32, size);
     return size;
 }
 
@@ -3489,7 +3506,7 @@ static int lfs_commitattr(lfs_t *lfs, const char *path,
 
 int lfs_setattr(lfs_t *lfs, const char *path,
         uint8_t type, const void *buffer, lfs_size_t size) {
-    LFS_TRACE("lfs_setattr(%p, \"%s\", %"PRIu8", %p, %"PRIu32")",
+    LFS_TRACE("lfs_setattr(%p, \"%s\", %" PRIu8", %p, %" PRIu32")",
             (void*)lfs, path, type, buffer, size);
     if (size > lfs->attr_max) {
         LFS_TRACE("lfs_setattr -> %d", LFS_ERR_NOSPC);
@@ -3502,7 +3519,7 @@ int lfs_setattr(lfs_t *lfs, const char *path,
 }
 
 int lfs_removeattr(lfs_t *lfs, const char *path, uint8_t type) {
-    LFS_TRACE("lfs_removeattr(%p, \"%s\", %"PRIu8")", (void*)lfs, path, type);
+    LFS_TRACE("lfs_removeattr(%p, \"%s\", %" PRIu8")", (void*)lfs, path, type);
     int err = lfs_commitattr(lfs, path, type, NULL, 0x3ff);
     LFS_TRACE("lfs_removeattr -> %d", err);
     return err;
@@ -3655,13 +3672,13 @@ static int lfs_deinit(lfs_t *lfs) {
 int lfs_format(lfs_t *lfs, const struct lfs_config *cfg) {
     LFS_TRACE("lfs_format(%p, %p {.context=%p, "
                 ".read=%p, .prog=%p, .erase=%p, .sync=%p, "
-                ".read_size=%"PRIu32", .prog_size=%"PRIu32", "
-                ".block_size=%"PRIu32", .block_count=%"PRIu32", "
-                ".block_cycles=%"PRIu32", .cache_size=%"PRIu32", "
-                ".lookahead_size=%"PRIu32", .read_buffer=%p, "
+                ".read_size=%" PRIu32", .prog_size=%" PRIu32", "
+                ".block_size=%" PRIu32", .block_count=%" PRIu32", "
+                ".block_cycles=%" PRIu32", .cache_size=%" PRIu32", "
+                ".lookahead_size=%" PRIu32", .read_buffer=%p, "
                 ".prog_buffer=%p, .lookahead_buffer=%p, "
-                ".name_max=%"PRIu32", .file_max=%"PRIu32", "
-                ".attr_max=%"PRIu32"})",
+                ".name_max=%" PRIu32", .file_max=%" PRIu32", "
+                ".attr_max=%" PRIu32"})",
             (void*)lfs, (void*)cfg, cfg->context,
             (void*)(uintptr_t)cfg->read, (void*)(uintptr_t)cfg->prog,
             (void*)(uintptr_t)cfg->erase, (void*)(uintptr_t)cfg->sync,
@@ -3736,13 +3753,13 @@ cleanup:
 int lfs_mount(lfs_t *lfs, const struct lfs_config *cfg) {
     LFS_TRACE("lfs_mount(%p, %p {.context=%p, "
                 ".read=%p, .prog=%p, .erase=%p, .sync=%p, "
-                ".read_size=%"PRIu32", .prog_size=%"PRIu32", "
-                ".block_size=%"PRIu32", .block_count=%"PRIu32", "
-                ".block_cycles=%"PRIu32", .cache_size=%"PRIu32", "
-                ".lookahead_size=%"PRIu32", .read_buffer=%p, "
+                ".read_size=%" PRIu32", .prog_size=%" PRIu32", "
+                ".block_size=%" PRIu32", .block_count=%" PRIu32", "
+                ".block_cycles=%" PRIu32", .cache_size=%" PRIu32", "
+                ".lookahead_size=%" PRIu32", .read_buffer=%p, "
                 ".prog_buffer=%p, .lookahead_buffer=%p, "
-                ".name_max=%"PRIu32", .file_max=%"PRIu32", "
-                ".attr_max=%"PRIu32"})",
+                ".name_max=%" PRIu32", .file_max=%" PRIu32", "
+                ".attr_max=%" PRIu32"})",
             (void*)lfs, (void*)cfg, cfg->context,
             (void*)(uintptr_t)cfg->read, (void*)(uintptr_t)cfg->prog,
             (void*)(uintptr_t)cfg->erase, (void*)(uintptr_t)cfg->sync,
@@ -3768,12 +3785,12 @@ int lfs_mount(lfs_t *lfs, const struct lfs_config *cfg) {
         cycle += 1;
 
         // fetch next block in tail list
+        struct lfs_dir_find_match match = {lfs, "littlefs", 8};
         lfs_stag_t tag = lfs_dir_fetchmatch(lfs, &dir, dir.tail,
                 LFS_MKTAG(0x7ff, 0x3ff, 0),
                 LFS_MKTAG(LFS_TYPE_SUPERBLOCK, 0, 8),
                 NULL,
-                lfs_dir_find_match, &(struct lfs_dir_find_match){
-                    lfs, "littlefs", 8});
+                lfs_dir_find_match, &match);
         if (tag < 0) {
             err = tag;
             goto cleanup;
@@ -3801,7 +3818,7 @@ int lfs_mount(lfs_t *lfs, const struct lfs_config *cfg) {
             uint16_t minor_version = (0xffff & (superblock.version >>  0));
             if ((major_version != LFS_DISK_VERSION_MAJOR ||
                  minor_version > LFS_DISK_VERSION_MINOR)) {
-                LFS_ERROR("Invalid version v%"PRIu16".%"PRIu16,
+                LFS_ERROR("Invalid version v%" PRIu16".%" PRIu16,
                         major_version, minor_version);
                 err = LFS_ERR_INVAL;
                 goto cleanup;
@@ -3810,7 +3827,7 @@ int lfs_mount(lfs_t *lfs, const struct lfs_config *cfg) {
             // check superblock configuration
             if (superblock.name_max) {
                 if (superblock.name_max > lfs->name_max) {
-                    LFS_ERROR("Unsupported name_max (%"PRIu32" > %"PRIu32")",
+                    LFS_ERROR("Unsupported name_max (%" PRIu32" > %" PRIu32")",
                             superblock.name_max, lfs->name_max);
                     err = LFS_ERR_INVAL;
                     goto cleanup;
@@ -3821,7 +3838,7 @@ int lfs_mount(lfs_t *lfs, const struct lfs_config *cfg) {
 
             if (superblock.file_max) {
                 if (superblock.file_max > lfs->file_max) {
-                    LFS_ERROR("Unsupported file_max (%"PRIu32" > %"PRIu32")",
+                    LFS_ERROR("Unsupported file_max (%" PRIu32" > %" PRIu32")",
                             superblock.file_max, lfs->file_max);
                     err = LFS_ERR_INVAL;
                     goto cleanup;
@@ -3832,7 +3849,7 @@ int lfs_mount(lfs_t *lfs, const struct lfs_config *cfg) {
 
             if (superblock.attr_max) {
                 if (superblock.attr_max > lfs->attr_max) {
-                    LFS_ERROR("Unsupported attr_max (%"PRIu32" > %"PRIu32")",
+                    LFS_ERROR("Unsupported attr_max (%" PRIu32" > %" PRIu32")",
                             superblock.attr_max, lfs->attr_max);
                     err = LFS_ERR_INVAL;
                     goto cleanup;
@@ -3857,7 +3874,7 @@ int lfs_mount(lfs_t *lfs, const struct lfs_config *cfg) {
 
     // update littlefs with gstate
     if (!lfs_gstate_iszero(&lfs->gstate)) {
-        LFS_DEBUG("Found pending gstate 0x%08"PRIx32"%08"PRIx32"%08"PRIx32,
+        LFS_DEBUG("Found pending gstate 0x%08" PRIx32"%08" PRIx32"%08" PRIx32,
                 lfs->gstate.tag,
                 lfs->gstate.pair[0],
                 lfs->gstate.pair[1]);
@@ -3901,12 +3918,12 @@ int lfs_mount_async(lfs_t *lfs, const struct lfs_config *cfg, uint8_t* state, lf
             *cycle_iterator += 1;
 
             // fetch next block in tail list
+            struct lfs_dir_find_match match = {lfs, "littlefs", 8};
             lfs_stag_t tag = lfs_dir_fetchmatch(lfs, (dir_iterator), (*dir_iterator).tail,
                     LFS_MKTAG(0x7ff, 0x3ff, 0),
                     LFS_MKTAG(LFS_TYPE_SUPERBLOCK, 0, 8),
                     NULL,
-                    lfs_dir_find_match, &(struct lfs_dir_find_match){
-                        lfs, "littlefs", 8});
+                    lfs_dir_find_match, &match);
             if (tag < 0) {
                 err = tag;
                 goto cleanup;
@@ -3934,7 +3951,7 @@ int lfs_mount_async(lfs_t *lfs, const struct lfs_config *cfg, uint8_t* state, lf
                 uint16_t minor_version = (0xffff & (superblock.version >>  0));
                 if ((major_version != LFS_DISK_VERSION_MAJOR ||
                      minor_version > LFS_DISK_VERSION_MINOR)) {
-                    LFS_ERROR("Invalid version v%"PRIu16".%"PRIu16,
+                    LFS_ERROR("Invalid version v%" PRIu16".%" PRIu16,
                             major_version, minor_version);
                     err = LFS_ERR_INVAL;
                     goto cleanup;
@@ -3943,7 +3960,7 @@ int lfs_mount_async(lfs_t *lfs, const struct lfs_config *cfg, uint8_t* state, lf
                 // check superblock configuration
                 if (superblock.name_max) {
                     if (superblock.name_max > lfs->name_max) {
-                        LFS_ERROR("Unsupported name_max (%"PRIu32" > %"PRIu32")",
+                        LFS_ERROR("Unsupported name_max (%" PRIu32" > %" PRIu32")",
                                 superblock.name_max, lfs->name_max);
                         err = LFS_ERR_INVAL;
                         goto cleanup;
@@ -3954,7 +3971,7 @@ int lfs_mount_async(lfs_t *lfs, const struct lfs_config *cfg, uint8_t* state, lf
 
                 if (superblock.file_max) {
                     if (superblock.file_max > lfs->file_max) {
-                        LFS_ERROR("Unsupported file_max (%"PRIu32" > %"PRIu32")",
+                        LFS_ERROR("Unsupported file_max (%" PRIu32" > %" PRIu32")",
                                 superblock.file_max, lfs->file_max);
                         err = LFS_ERR_INVAL;
                         goto cleanup;
@@ -3965,7 +3982,7 @@ int lfs_mount_async(lfs_t *lfs, const struct lfs_config *cfg, uint8_t* state, lf
 
                 if (superblock.attr_max) {
                     if (superblock.attr_max > lfs->attr_max) {
-                        LFS_ERROR("Unsupported attr_max (%"PRIu32" > %"PRIu32")",
+                        LFS_ERROR("Unsupported attr_max (%" PRIu32" > %" PRIu32")",
                                 superblock.attr_max, lfs->attr_max);
                         err = LFS_ERR_INVAL;
                         goto cleanup;
@@ -3999,7 +4016,7 @@ int lfs_mount_async(lfs_t *lfs, const struct lfs_config *cfg, uint8_t* state, lf
 
         // update littlefs with gstate
         if (!lfs_gstate_iszero(&lfs->gstate)) {
-            LFS_DEBUG("Found pending gstate 0x%08"PRIx32"%08"PRIx32"%08"PRIx32,
+            LFS_DEBUG("Found pending gstate 0x%08" PRIx32"%08" PRIx32"%08" PRIx32,
                     lfs->gstate.tag,
                     lfs->gstate.pair[0],
                     lfs->gstate.pair[1]);
@@ -4279,12 +4296,12 @@ static lfs_stag_t lfs_fs_parent(lfs_t *lfs, const lfs_block_t pair[2],
         }
         cycle += 1;
 
+        struct lfs_fs_parent_match match = {lfs, {pair[0], pair[1]}};
         lfs_stag_t tag = lfs_dir_fetchmatch(lfs, parent, parent->tail,
                 LFS_MKTAG(0x7ff, 0, 0x3ff),
                 LFS_MKTAG(LFS_TYPE_DIRSTRUCT, 0, 8),
                 NULL,
-                lfs_fs_parent_match, &(struct lfs_fs_parent_match){
-                    lfs, {pair[0], pair[1]}});
+                lfs_fs_parent_match, &match);
         if (tag && tag != LFS_ERR_NOENT) {
             return tag;
         }
@@ -4332,7 +4349,7 @@ static int lfs_fs_relocate(lfs_t *lfs,
         if (lfs_gstate_hasmovehere(&lfs->gstate, parent.pair)) {
             moveid = lfs_tag_id(lfs->gstate.tag);
             LFS_DEBUG("Fixing move while relocating "
-                    "{0x%"PRIx32", 0x%"PRIx32"} 0x%"PRIx16"\n",
+                    "{0x%" PRIx32", 0x%" PRIx32"} 0x%" PRIx16"\n",
                     parent.pair[0], parent.pair[1], moveid);
             lfs_fs_prepmove(lfs, 0x3ff, NULL);
             if (moveid < lfs_tag_id(tag)) {
@@ -4344,7 +4361,7 @@ static int lfs_fs_relocate(lfs_t *lfs,
         int err = lfs_dir_commit(lfs, &parent, LFS_MKATTRS(
                 {LFS_MKTAG_IF(moveid != 0x3ff,
                     LFS_TYPE_DELETE, moveid, 0), NULL},
-                {tag, newpair}));
+                {(lfs_tag_t)tag, newpair}));
         lfs_pair_fromle32(newpair);
         if (err) {
             return err;
@@ -4368,7 +4385,7 @@ static int lfs_fs_relocate(lfs_t *lfs,
         if (lfs_gstate_hasmovehere(&lfs->gstate, parent.pair)) {
             moveid = lfs_tag_id(lfs->gstate.tag);
             LFS_DEBUG("Fixing move while relocating "
-                    "{0x%"PRIx32", 0x%"PRIx32"} 0x%"PRIx16"\n",
+                    "{0x%" PRIx32", 0x%" PRIx32"} 0x%" PRIx16"\n",
                     parent.pair[0], parent.pair[1], moveid);
             lfs_fs_prepmove(lfs, 0x3ff, NULL);
         }
@@ -4409,7 +4426,7 @@ static int lfs_fs_demove(lfs_t *lfs) {
     }
 
     // Fix bad moves
-    LFS_DEBUG("Fixing move {0x%"PRIx32", 0x%"PRIx32"} 0x%"PRIx16,
+    LFS_DEBUG("Fixing move {0x%" PRIx32", 0x%" PRIx32"} 0x%" PRIx16,
             lfs->gdisk.pair[0],
             lfs->gdisk.pair[1],
             lfs_tag_id(lfs->gdisk.tag));
@@ -4463,7 +4480,7 @@ static int lfs_fs_deorphan(lfs_t *lfs) {
 
             if (tag == LFS_ERR_NOENT) {
                 // we are an orphan
-                LFS_DEBUG("Fixing orphan {0x%"PRIx32", 0x%"PRIx32"}",
+                LFS_DEBUG("Fixing orphan {0x%" PRIx32", 0x%" PRIx32"}",
                         pdir.tail[0], pdir.tail[1]);
 
                 err = lfs_dir_drop(lfs, &pdir, &dir);
@@ -4485,8 +4502,8 @@ static int lfs_fs_deorphan(lfs_t *lfs) {
 
             if (!lfs_pair_sync(pair, pdir.tail)) {
                 // we have desynced
-                LFS_DEBUG("Fixing half-orphan {0x%"PRIx32", 0x%"PRIx32"} "
-                            "-> {0x%"PRIx32", 0x%"PRIx32"}",
+                LFS_DEBUG("Fixing half-orphan {0x%" PRIx32", 0x%" PRIx32"} "
+                            "-> {0x%" PRIx32", 0x%" PRIx32"}",
                         pdir.tail[0], pdir.tail[1], pair[0], pair[1]);
 
                 lfs_pair_tole32(pair);
@@ -10,6 +10,86 @@
 #ifndef LFS_CONFIG
 
 
+#if defined(LFS_CRC_HW)
+#include <driverlib.h>
+
+static uint32_t lfs_crc_rbit(uint32_t a) {
+    uint32_t r = 0;
+    for (int i = 0; i < 32; i++) {
+        r = (r << 1) | (a & 1);
+        a >>= 1;
+    }
+    return r;
+}
+
+// CRC32 hardware module: it takes the data LSB first like the software
+// CRC, but keeps its state bit-reversed. The module is not shared with
+// anything else while a CRC is computed.
+uint32_t lfs_crc(uint32_t crc, const void *buffer, size_t size) {
+    const uint8_t *data = (const uint8_t*)buffer;
+
+    MAP_CRC32_setSeed(lfs_crc_rbit(crc), CRC32_MODE);
+    for (size_t i = 0; i < size; i++) {
+        MAP_CRC32_set8BitData(data[i], CRC32_MODE);
+    }
+    return MAP_CRC32_getResultReversed(CRC32_MODE);
+}
+
+#elif LFS_CRC_SLICES > 1
+
+// Slice-by-N tables, generated at compile time: table k holds the CRC of
+// a byte followed by k zero bytes
+static constexpr uint32_t lfs_crc_entry(uint32_t crc, int bits) {
+    return bits ? lfs_crc_entry((crc >> 1) ^ ((crc & 1) ? 0xedb88320 : 0), bits - 1) : crc;
+}
+
+static constexpr uint32_t lfs_crc_slice(uint32_t i, int k) {
+    return k ? (lfs_crc_slice(i, k - 1) >> 8) ^ lfs_crc_entry(lfs_crc_slice(i, k - 1) & 0xff, 8)
+             : lfs_crc_entry(i, 8);
+}
+
+#define LFS_CRC_X4(k, i)    lfs_crc_slice((i), k), lfs_crc_slice((i) + 1, k), \
+                            lfs_crc_slice((i) + 2, k), lfs_crc_slice((i) + 3, k)
+#define LFS_CRC_X16(k, i)   LFS_CRC_X4(k, i), LFS_CRC_X4(k, (i) + 4), LFS_CRC_X4(k, (i) + 8), LFS_CRC_X4(k, (i) + 12)
+#define LFS_CRC_X64(k, i)   LFS_CRC_X16(k, i), LFS_CRC_X16(k, (i) + 16), LFS_CRC_X16(k, (i) + 32), LFS_CRC_X16(k, (i) + 48)
+#define LFS_CRC_TABLE(k)    { LFS_CRC_X64(k, 0), LFS_CRC_X64(k, 64), LFS_CRC_X64(k, 128), LFS_CRC_X64(k, 192) }
+
+static const uint32_t lfs_crc_table[LFS_CRC_SLICES][256] = {
+    LFS_CRC_TABLE(0), LFS_CRC_TABLE(1), LFS_CRC_TABLE(2), LFS_CRC_TABLE(3),
+#if LFS_CRC_SLICES == 8
+    LFS_CRC_TABLE(4), LFS_CRC_TABLE(5), LFS_CRC_TABLE(6), LFS_CRC_TABLE(7),
+#endif
+};
+
+// Software CRC implementation, LFS_CRC_SLICES bytes per step
+uint32_t lfs_crc(uint32_t crc, const void *buffer, size_t size) {
+    const uint8_t *data = (const uint8_t*)buffer;
+    const uint32_t (*t)[256] = lfs_crc_table;
+
+    while (size >= LFS_CRC_SLICES) {
+        crc ^= (uint32_t)data[0] | ((uint32_t)data[1] << 8) |
+               ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+#if LFS_CRC_SLICES == 8
+        crc = t[7][crc & 0xff] ^ t[6][(crc >> 8) & 0xff] ^
+              t[5][(crc >> 16) & 0xff] ^ t[4][crc >> 24] ^
+              t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+#else
+        crc = t[3][crc & 0xff] ^ t[2][(crc >> 8) & 0xff] ^
+              t[1][(crc >> 16) & 0xff] ^ t[0][crc >> 24];
+#endif
+        data += LFS_CRC_SLICES;
+        size -= LFS_CRC_SLICES;
+    }
+
+    while (size--) {
+        crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xff];
+    }
+
+    return crc;
+}
+
+#else
+
 // Software CRC implementation with small lookup table
 uint32_t lfs_crc(uint32_t crc, const void *buffer, size_t size) {
     static const uint32_t rtable[16] = {
@@ -30,4 +110,6 @@ uint32_t lfs_crc(uint32_t crc, const void *buffer, size_t size) {
 }
 
 
+#endif
+
 #endif
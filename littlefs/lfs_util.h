@@ -199,6 +199,16 @@ static inline uint32_t lfs_tobe32(uint32_t a) {
 }
 
 // Calculate CRC-32 with polynomial = 0x04c11db7
+//
+// LFS_CRC_SLICES selects the software kernel: 1 is the 64 byte nibble
+// table, 4 and 8 use slice-by-4 (4 KiB) and slice-by-8 (8 KiB) tables
+// generated at compile time. LFS_CRC_HW uses the MSP432 CRC32 module.
+#ifndef LFS_CRC_SLICES
+#define LFS_CRC_SLICES 4
+#endif
+#if LFS_CRC_SLICES != 1 && LFS_CRC_SLICES != 4 && LFS_CRC_SLICES != 8
+#error "LFS_CRC_SLICES must be 1, 4 or 8"
+#endif
 uint32_t lfs_crc(uint32_t crc, const void *buffer, size_t size);
 
 // Allocate memory, only used if buffers are not provided to littlefs